@@ -73,13 +73,67 @@
 #define CFG_ASTRO_PI_CMD_TOPICID                ASTRO_PI_CMD_TOPICID
 #define CFG_ASTRO_PI_STATUS_TLM_TOPICID         ASTRO_PI_STATUS_TLM_TOPICID
 #define CFG_ASTRO_PI_SENSE_HAT_TLM_TOPICID      ASTRO_PI_SENSE_HAT_TLM_TOPICID
+#define CFG_ASTRO_PI_SEQ_TRACK_TLM_TOPICID      ASTRO_PI_SEQ_TRACK_TLM_TOPICID
+#define CFG_ASTRO_PI_DISPATCH_TLM_TOPICID       ASTRO_PI_DISPATCH_TLM_TOPICID
+#define CFG_ASTRO_PI_PSD_TLM_TOPICID            ASTRO_PI_PSD_TLM_TOPICID
+#define CFG_ASTRO_PI_SCRIPT_OUTPUT_TLM_TOPICID  ASTRO_PI_SCRIPT_OUTPUT_TLM_TOPICID
+#define CFG_ASTRO_PI_RESOURCE_TLM_TOPICID       ASTRO_PI_RESOURCE_TLM_TOPICID
 #define CFG_JMSG_LIB_TOPIC_SCRIPT_CMD_TOPICID   JMSG_LIB_TOPIC_SCRIPT_CMD_TOPICID
 #define CFG_JMSG_LIB_TOPIC_CSV_TLM_TOPICID      JMSG_LIB_TOPIC_CSV_TLM_TOPICID
 #define CFG_SEND_STATUS_TLM_TOPICID             BC_SCH_2_SEC_TOPICID
+#define CFG_SAMPLE_SYNC_TICK_TOPICID            BC_SCH_1_HZ_TOPICID
       
 #define CFG_CMD_PIPE_NAME   CMD_PIPE_NAME
 #define CFG_CMD_PIPE_DEPTH  CMD_PIPE_DEPTH
 
+#define CFG_SENSE_HAT_PIPE_NAME   SENSE_HAT_PIPE_NAME
+#define CFG_SENSE_HAT_PIPE_DEPTH  SENSE_HAT_PIPE_DEPTH
+
+#define CFG_SENSE_HAT_INGEST_CHILD_NAME        SENSE_HAT_INGEST_CHILD_NAME
+#define CFG_SENSE_HAT_INGEST_CHILD_STACK_SIZE  SENSE_HAT_INGEST_CHILD_STACK_SIZE
+#define CFG_SENSE_HAT_INGEST_CHILD_PRIORITY    SENSE_HAT_INGEST_CHILD_PRIORITY
+#define CFG_SENSE_HAT_INGEST_CHILD_PERF_ID     SENSE_HAT_INGEST_CHILD_PERF_ID
+
+#define CFG_SENSE_HAT_PUB_CHILD_NAME        SENSE_HAT_PUB_CHILD_NAME
+#define CFG_SENSE_HAT_PUB_CHILD_STACK_SIZE  SENSE_HAT_PUB_CHILD_STACK_SIZE
+#define CFG_SENSE_HAT_PUB_CHILD_PRIORITY    SENSE_HAT_PUB_CHILD_PRIORITY
+#define CFG_SENSE_HAT_PUB_CHILD_PERF_ID     SENSE_HAT_PUB_CHILD_PERF_ID
+
+#define CFG_DIAG_LEVEL           DIAG_LEVEL
+#define CFG_DIAG_EVENT_RATE      DIAG_EVENT_RATE
+#define CFG_DIAG_EVENT_BURST     DIAG_EVENT_BURST
+#define CFG_DIAG_SUMMARY_PERIOD  DIAG_SUMMARY_PERIOD
+
+#define CFG_SCRIPT_SYNC_LOCAL_DIR           SCRIPT_SYNC_LOCAL_DIR
+#define CFG_SCRIPT_SYNC_MANIFEST_TIMEOUT    SCRIPT_SYNC_MANIFEST_TIMEOUT
+#define CFG_SCRIPT_SYNC_BLOCKS_PER_DELAY    SCRIPT_SYNC_BLOCKS_PER_DELAY
+#define CFG_SCRIPT_SYNC_DELAY               SCRIPT_SYNC_DELAY
+#define CFG_SCRIPT_SYNC_CHILD_NAME          SCRIPT_SYNC_CHILD_NAME
+#define CFG_SCRIPT_SYNC_CHILD_STACK_SIZE    SCRIPT_SYNC_CHILD_STACK_SIZE
+#define CFG_SCRIPT_SYNC_CHILD_PRIORITY      SCRIPT_SYNC_CHILD_PRIORITY
+#define CFG_SCRIPT_SYNC_CHILD_PERF_ID       SCRIPT_SYNC_CHILD_PERF_ID
+
+#define CFG_LED_MATRIX_KEY_FRAME_INTERVAL   LED_MATRIX_KEY_FRAME_INTERVAL
+
+#define CFG_SAMPLE_SYNC_MODE  SAMPLE_SYNC_MODE
+
+#define CFG_CAL_TBL_LOAD_FILE  CAL_TBL_LOAD_FILE
+
+#define CFG_SPECTRUM_SEGMENT_LEN        SPECTRUM_SEGMENT_LEN
+#define CFG_SPECTRUM_SEGMENTS_PER_PSD   SPECTRUM_SEGMENTS_PER_PSD
+#define CFG_SPECTRUM_CHILD_NAME         SPECTRUM_CHILD_NAME
+#define CFG_SPECTRUM_CHILD_STACK_SIZE   SPECTRUM_CHILD_STACK_SIZE
+#define CFG_SPECTRUM_CHILD_PRIORITY     SPECTRUM_CHILD_PRIORITY
+#define CFG_SPECTRUM_CHILD_PERF_ID      SPECTRUM_CHILD_PERF_ID
+
+#define CFG_WARM_START_CDS_NAME     WARM_START_CDS_NAME
+#define CFG_WARM_START_SAVE_PERIOD  WARM_START_SAVE_PERIOD
+
+#define CFG_SCRIPT_OUTPUT_PAGE_RATE       SCRIPT_OUTPUT_PAGE_RATE
+#define CFG_SCRIPT_OUTPUT_PAGE_BURST      SCRIPT_OUTPUT_PAGE_BURST
+#define CFG_SCRIPT_OUTPUT_LOG_FILE        SCRIPT_OUTPUT_LOG_FILE
+#define CFG_SCRIPT_OUTPUT_LOG_MAX_BYTES   SCRIPT_OUTPUT_LOG_MAX_BYTES
+
 
 #define APP_CONFIG(XX) \
    XX(APP_CFE_NAME,char*) \
@@ -87,11 +141,54 @@
    XX(ASTRO_PI_CMD_TOPICID,uint32) \
    XX(ASTRO_PI_STATUS_TLM_TOPICID,uint32) \
    XX(ASTRO_PI_SENSE_HAT_TLM_TOPICID,uint32) \
+   XX(ASTRO_PI_SEQ_TRACK_TLM_TOPICID,uint32) \
+   XX(ASTRO_PI_DISPATCH_TLM_TOPICID,uint32) \
+   XX(ASTRO_PI_PSD_TLM_TOPICID,uint32) \
+   XX(ASTRO_PI_SCRIPT_OUTPUT_TLM_TOPICID,uint32) \
+   XX(ASTRO_PI_RESOURCE_TLM_TOPICID,uint32) \
    XX(JMSG_LIB_TOPIC_SCRIPT_CMD_TOPICID,uint32) \
    XX(JMSG_LIB_TOPIC_CSV_TLM_TOPICID,uint32) \
    XX(BC_SCH_2_SEC_TOPICID,uint32) \
+   XX(BC_SCH_1_HZ_TOPICID,uint32) \
    XX(CMD_PIPE_NAME,char*) \
    XX(CMD_PIPE_DEPTH,uint32) \
+   XX(SENSE_HAT_PIPE_NAME,char*) \
+   XX(SENSE_HAT_PIPE_DEPTH,uint32) \
+   XX(SENSE_HAT_INGEST_CHILD_NAME,char*) \
+   XX(SENSE_HAT_INGEST_CHILD_STACK_SIZE,uint32) \
+   XX(SENSE_HAT_INGEST_CHILD_PRIORITY,uint32) \
+   XX(SENSE_HAT_INGEST_CHILD_PERF_ID,uint32) \
+   XX(SENSE_HAT_PUB_CHILD_NAME,char*) \
+   XX(SENSE_HAT_PUB_CHILD_STACK_SIZE,uint32) \
+   XX(SENSE_HAT_PUB_CHILD_PRIORITY,uint32) \
+   XX(SENSE_HAT_PUB_CHILD_PERF_ID,uint32) \
+   XX(DIAG_LEVEL,uint32) \
+   XX(DIAG_EVENT_RATE,uint32) \
+   XX(DIAG_EVENT_BURST,uint32) \
+   XX(DIAG_SUMMARY_PERIOD,uint32) \
+   XX(SCRIPT_SYNC_LOCAL_DIR,char*) \
+   XX(SCRIPT_SYNC_MANIFEST_TIMEOUT,uint32) \
+   XX(SCRIPT_SYNC_BLOCKS_PER_DELAY,uint32) \
+   XX(SCRIPT_SYNC_DELAY,uint32) \
+   XX(SCRIPT_SYNC_CHILD_NAME,char*) \
+   XX(SCRIPT_SYNC_CHILD_STACK_SIZE,uint32) \
+   XX(SCRIPT_SYNC_CHILD_PRIORITY,uint32) \
+   XX(SCRIPT_SYNC_CHILD_PERF_ID,uint32) \
+   XX(LED_MATRIX_KEY_FRAME_INTERVAL,uint32) \
+   XX(SAMPLE_SYNC_MODE,uint32) \
+   XX(CAL_TBL_LOAD_FILE,char*) \
+   XX(SPECTRUM_SEGMENT_LEN,uint32) \
+   XX(SPECTRUM_SEGMENTS_PER_PSD,uint32) \
+   XX(SPECTRUM_CHILD_NAME,char*) \
+   XX(SPECTRUM_CHILD_STACK_SIZE,uint32) \
+   XX(SPECTRUM_CHILD_PRIORITY,uint32) \
+   XX(SPECTRUM_CHILD_PERF_ID,uint32) \
+   XX(WARM_START_CDS_NAME,char*) \
+   XX(WARM_START_SAVE_PERIOD,uint32) \
+   XX(SCRIPT_OUTPUT_PAGE_RATE,uint32) \
+   XX(SCRIPT_OUTPUT_PAGE_BURST,uint32) \
+   XX(SCRIPT_OUTPUT_LOG_FILE,char*) \
+   XX(SCRIPT_OUTPUT_LOG_MAX_BYTES,uint32) \
 
 DECLARE_ENUM(Config,APP_CONFIG)
 
@@ -102,6 +199,29 @@ DECLARE_ENUM(Config,APP_CONFIG)
 
 #define ASTRO_PI_UNDEF_TLM_STR "Undefined"
 
+#define SEQ_TRACK_MAX_SOURCES  4   /* Must match SeqSourceStatsArray dimension in astro_pi.xml */
+
+#define SAMPLE_QUEUE_DEPTH       64  /* Decoded samples between Sense HAT stages, must be a power of 2 */
+#define SENSE_HAT_PUB_BATCH_LEN  8   /* Max samples popped per publish task queue read */
+
+#define DISPATCH_MAX_ENTRIES   4   /* MsgIds registered per dispatcher */
+#define DISPATCH_TLM_ENTRIES   8   /* Must match DispatchStatsArray dimension in astro_pi.xml */
+
+#define SCRIPT_SYNC_BLOCK_LEN        384   /* File bytes per sync block message, base64 text must fit in a JMSG script string */
+#define SCRIPT_SYNC_MAX_FILE_BLOCKS  128   /* Limits synced files to 48KB */
+#define SCRIPT_SYNC_MAX_FILES        32    /* Remote files tracked in a sync manifest */
+
+#define SAMPLE_SYNC_REQ_SLOTS  16   /* Outstanding sample requests tracked, must be a power of 2 */
+
+#define SPECTRUM_BATCH_LEN  16   /* Max samples popped per spectrum task queue read */
+#define SPECTRUM_PSD_BANDS  32   /* Must match PsdBandArray dimension in astro_pi.xml */
+
+#define SCRIPT_OUTPUT_SCRIPTS   4     /* Scripts with buffered output, should be at least the Pi's script workers */
+#define SCRIPT_OUTPUT_PAGES     8     /* Output pages buffered per script */
+#define SCRIPT_OUTPUT_PAGE_LEN  200   /* Must match OutputTextArray dimension in astro_pi.xml */
+
+#define RESOURCE_TASKS  5   /* Must match TaskUsageArray dimension in astro_pi.xml */
+
 
 /******************************************************************************
 ** Event Macros
@@ -113,5 +233,17 @@ DECLARE_ENUM(Config,APP_CONFIG)
 
 #define ASTRO_PI_APP_BASE_EID  (APP_C_FW_APP_BASE_EID +  0)
 #define PY_SCRIPT_BASE_EID     (APP_C_FW_APP_BASE_EID + 20)
+#define SEQ_TRACK_BASE_EID     (APP_C_FW_APP_BASE_EID + 40)
+#define DIAG_BASE_EID          (APP_C_FW_APP_BASE_EID + 60)
+#define SENSE_HAT_BASE_EID     (APP_C_FW_APP_BASE_EID + 80)
+#define DISPATCH_BASE_EID      (APP_C_FW_APP_BASE_EID + 100)
+#define SCRIPT_SYNC_BASE_EID   (APP_C_FW_APP_BASE_EID + 120)
+#define LED_MATRIX_BASE_EID    (APP_C_FW_APP_BASE_EID + 140)
+#define SAMPLE_SYNC_BASE_EID   (APP_C_FW_APP_BASE_EID + 160)
+#define SPECTRUM_BASE_EID      (APP_C_FW_APP_BASE_EID + 180)
+#define CAL_TBL_BASE_EID       (APP_C_FW_APP_BASE_EID + 200)
+#define WARM_START_BASE_EID    (APP_C_FW_APP_BASE_EID + 220)
+#define SCRIPT_OUTPUT_BASE_EID (APP_C_FW_APP_BASE_EID + 240)
+#define RESOURCE_BASE_EID      (APP_C_FW_APP_BASE_EID + 260)
 
 #endif /* _app_cfg_ */
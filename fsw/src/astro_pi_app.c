@@ -35,14 +35,31 @@
 /* Convenience macros */
 #define  INITBL_OBJ      (&(AstroPiApp.IniTbl))
 #define  CMDMGR_OBJ      (&(AstroPiApp.CmdMgr))
+#define  TBLMGR_OBJ      (&(AstroPiApp.TblMgr))
+#define  DISPATCH_OBJ    (&(AstroPiApp.Dispatch))
+#define  CALIBRATE_OBJ   (&(AstroPiApp.Calibrate))
+#define  DIAG_OBJ        (&(AstroPiApp.Diag))
+#define  LED_MATRIX_OBJ  (&(AstroPiApp.LedMatrix))
 #define  PY_SCRIPT_OBJ   (&(AstroPiApp.PyScript))
+#define  RESOURCE_OBJ    (&(AstroPiApp.Resource))
+#define  SAMPLE_SYNC_OBJ (&(AstroPiApp.SampleSync))
+#define  SCRIPT_OUTPUT_OBJ (&(AstroPiApp.ScriptOutput))
+#define  SCRIPT_SYNC_OBJ (&(AstroPiApp.ScriptSync))
+#define  SENSE_HAT_OBJ   (&(AstroPiApp.SenseHat))
+#define  SEQ_TRACK_OBJ   (&(AstroPiApp.SeqTrack))
+#define  SPECTRUM_OBJ    (&(AstroPiApp.Spectrum))
+#define  WARM_START_OBJ  (&(AstroPiApp.WarmStart))
 
 /*******************************/
 /** Local Function Prototypes **/
 /*******************************/
 
 static int32 InitApp(void);
+static bool ProcessCmdMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
 static int32 ProcessCommands(void);
+static bool ProcessSendStatusMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+static void SendDispatchTlm(void);
+static void SendResourceTlm(void);
 static void SendStatusPkt(void);
 
 
@@ -60,7 +77,8 @@ static CFE_EVS_BinFilter_t  EventFilters[] =
 {  
    /* Event ID                           Mask */
    {PKTUTIL_CSV_PARSE_ERR_EID,      CFE_EVS_FIRST_4_STOP},
-   {PY_SCRIPT_CREATE_SENSE_HAT_EID, CFE_EVS_FIRST_4_STOP}
+   {SEQ_TRACK_TBL_FULL_EID,         CFE_EVS_FIRST_4_STOP},
+   {SCRIPT_OUTPUT_RPT_EID,          CFE_EVS_FIRST_4_STOP}
    
 };
 
@@ -95,14 +113,16 @@ void ASTRO_PI_AppMain(void)
    {
       
       /*
-      ** The Rx and Tx child tasks manage translating and transferring the JSON
-      ** messages. This loop only needs to service commands.
+      ** The Sense HAT child tasks manage ingesting and publishing telemetry.
+      ** This loop only needs to service commands.
       */ 
       
       RunStatus = ProcessCommands();
       
    } /* End CFE_ES_RunLoop */
 
+   WARM_START_Save();
+
    CFE_ES_WriteToSysLog("Astro Pi App terminating, run status = 0x%08X\n", RunStatus);   /* Use SysLog, events may not be working */
 
    CFE_EVS_SendEvent(ASTRO_PI_APP_EXIT_EID, CFE_EVS_EventType_CRITICAL, "Astro Pi App terminating, run status = 0x%08X", RunStatus);
@@ -143,8 +163,21 @@ bool ASTRO_PI_APP_ResetAppCmd(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr)
    CFE_EVS_ResetAllFilters();
 
    CMDMGR_ResetStatus(CMDMGR_OBJ);
+   TBLMGR_ResetStatus(TBLMGR_OBJ);
+   DISPATCH_ResetStatus(DISPATCH_OBJ);
    
+   CALIBRATE_ResetStatus();
+   DIAG_ResetStatus();
+   LED_MATRIX_ResetStatus();
    PY_SCRIPT_ResetStatus();
+   RESOURCE_ResetStatus();
+   SAMPLE_SYNC_ResetStatus();
+   SCRIPT_OUTPUT_ResetStatus();
+   SCRIPT_SYNC_ResetStatus();
+   SENSE_HAT_ResetStatus();
+   SEQ_TRACK_ResetStatus();
+   SPECTRUM_ResetStatus();
+   WARM_START_ResetStatus();
 	  
    return true;
 
@@ -159,6 +192,7 @@ static int32 InitApp(void)
 {
 
    int32 RetStatus = APP_C_FW_CFS_ERROR;
+   int32 SysStatus;
       
       
    /*
@@ -171,40 +205,91 @@ static int32 InitApp(void)
       AstroPiApp.PerfId = INITBL_GetIntConfig(INITBL_OBJ, CFG_APP_MAIN_PERF_ID);
       CFE_ES_PerfLogEntry(AstroPiApp.PerfId);
 
-      PY_SCRIPT_Constructor(PY_SCRIPT_OBJ, INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_LIB_TOPIC_SCRIPT_CMD_TOPICID),
-                            INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_SENSE_HAT_TLM_TOPICID));
-
-      AstroPiApp.CmdMid             = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_CMD_TOPICID));
-      AstroPiApp.SendStatusMid      = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_SEND_STATUS_TLM_TOPICID));
-      AstroPiApp.JmsgTopicCsvTlmMid = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, JMSG_LIB_TOPIC_CSV_TLM_TOPICID));
+      CALIBRATE_Constructor(CALIBRATE_OBJ);
+      DIAG_Constructor(DIAG_OBJ, INITBL_GetIntConfig(INITBL_OBJ, CFG_DIAG_LEVEL),
+                       INITBL_GetIntConfig(INITBL_OBJ, CFG_DIAG_EVENT_RATE),
+                       INITBL_GetIntConfig(INITBL_OBJ, CFG_DIAG_EVENT_BURST),
+                       INITBL_GetIntConfig(INITBL_OBJ, CFG_DIAG_SUMMARY_PERIOD));
+      LED_MATRIX_Constructor(LED_MATRIX_OBJ, INITBL_OBJ);
+      PY_SCRIPT_Constructor(PY_SCRIPT_OBJ, INITBL_GetIntConfig(INITBL_OBJ, CFG_JMSG_LIB_TOPIC_SCRIPT_CMD_TOPICID));
+      RESOURCE_Constructor(RESOURCE_OBJ, INITBL_OBJ);   /* Before any child tasks are started */
+      SAMPLE_SYNC_Constructor(SAMPLE_SYNC_OBJ, INITBL_OBJ);
+      SEQ_TRACK_Constructor(SEQ_TRACK_OBJ, INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_SEQ_TRACK_TLM_TOPICID));
+      SCRIPT_OUTPUT_Constructor(SCRIPT_OUTPUT_OBJ, INITBL_OBJ);
+      if (SCRIPT_SYNC_Constructor(SCRIPT_SYNC_OBJ, INITBL_OBJ) &&
+          SPECTRUM_Constructor(SPECTRUM_OBJ, INITBL_OBJ))
+      {
       
-      /*
-      ** Initialize app level interfaces
-      */
+         /* Restores the state of the objects constructed above */
+         WARM_START_Constructor(WARM_START_OBJ, INITBL_OBJ);
+      
+         /* Sense HAT child tasks use the other objects so it must be constructed last */
+         if (SENSE_HAT_Constructor(SENSE_HAT_OBJ, INITBL_OBJ))
+         {
+      
+            /*
+            ** Initialize app level interfaces
+            */
  
-      CFE_SB_CreatePipe(&AstroPiApp.CmdPipe, INITBL_GetIntConfig(INITBL_OBJ, CFG_CMD_PIPE_DEPTH), INITBL_GetStrConfig(INITBL_OBJ, CFG_CMD_PIPE_NAME));  
-      CFE_SB_Subscribe(AstroPiApp.CmdMid, AstroPiApp.CmdPipe);
-      CFE_SB_Subscribe(AstroPiApp.SendStatusMid, AstroPiApp.CmdPipe);
-      CFE_SB_Subscribe(AstroPiApp.JmsgTopicCsvTlmMid, AstroPiApp.CmdPipe);
-
-      CMDMGR_Constructor(CMDMGR_OBJ);
-      CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_NOOP_CC,  NULL, ASTRO_PI_APP_NoOpCmd,     0);
-      CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_RESET_CC, NULL, ASTRO_PI_APP_ResetAppCmd, 0);
+            SysStatus = CFE_SB_CreatePipe(&AstroPiApp.CmdPipe, INITBL_GetIntConfig(INITBL_OBJ, CFG_CMD_PIPE_DEPTH), INITBL_GetStrConfig(INITBL_OBJ, CFG_CMD_PIPE_NAME));  
+            if (SysStatus == CFE_SUCCESS)
+            {
+               
+               DISPATCH_Constructor(DISPATCH_OBJ, AstroPiApp.CmdPipe);
+               if (DISPATCH_RegisterFunc(DISPATCH_OBJ, CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_CMD_TOPICID)),
+                                         CMDMGR_OBJ, ProcessCmdMsg) &&
+                   DISPATCH_RegisterFunc(DISPATCH_OBJ, CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_SEND_STATUS_TLM_TOPICID)),
+                                         NULL, ProcessSendStatusMsg) &&
+                   DISPATCH_RegisterFunc(DISPATCH_OBJ, CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_SAMPLE_SYNC_TICK_TOPICID)),
+                                         NULL, SAMPLE_SYNC_TickMsg))
+               {
+
+                  CMDMGR_Constructor(CMDMGR_OBJ);
+                  TBLMGR_Constructor(TBLMGR_OBJ, INITBL_GetStrConfig(INITBL_OBJ, CFG_APP_CFE_NAME));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_NOOP_CC,  NULL, ASTRO_PI_APP_NoOpCmd,     0);
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_RESET_CC, NULL, ASTRO_PI_APP_ResetAppCmd, 0);
       
-      CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SEND_TEST_SCRIPT_CC,    NULL, PY_SCRIPT_SendTestCmd,    sizeof(ASTRO_PI_SendTestScript_CmdPayload_t));
-      CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SEND_LOCAL_SCRIPT_CC,   NULL, PY_SCRIPT_SendLocalCmd,   sizeof(ASTRO_PI_SendLocalScript_CmdPayload_t));
-      CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_START_REMOTE_SCRIPT_CC, NULL, PY_SCRIPT_StartRemoteCmd, sizeof(ASTRO_PI_StartRemoteScript_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SEND_TEST_SCRIPT_CC,    NULL, PY_SCRIPT_SendTestCmd,    sizeof(ASTRO_PI_SendTestScript_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SEND_LOCAL_SCRIPT_CC,   NULL, PY_SCRIPT_SendLocalCmd,   sizeof(ASTRO_PI_SendLocalScript_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_START_REMOTE_SCRIPT_CC, NULL, PY_SCRIPT_StartRemoteCmd, sizeof(ASTRO_PI_StartRemoteScript_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SET_DIAG_LEVEL_CC,      NULL, DIAG_SetLevelCmd,         sizeof(ASTRO_PI_SetDiagLevel_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_CANCEL_SCRIPT_CC,       NULL, PY_SCRIPT_CancelCmd,      sizeof(ASTRO_PI_CancelScript_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SYNC_SCRIPTS_CC,        NULL, SCRIPT_SYNC_StartCmd,     0);
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SET_LED_FRAME_CC,       NULL, LED_MATRIX_SetFrameCmd,   sizeof(ASTRO_PI_SetLedFrame_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_SET_SAMPLE_MODE_CC,     NULL, SAMPLE_SYNC_SetModeCmd,   sizeof(ASTRO_PI_SetSampleMode_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_LOAD_CAL_TBL_CC,        TBLMGR_OBJ, TBLMGR_LoadTblCmd,  sizeof(APP_C_FW_LoadTbl_CmdPayload_t));
+                  CMDMGR_RegisterFunc(CMDMGR_OBJ, ASTRO_PI_DUMP_CAL_TBL_CC,        TBLMGR_OBJ, TBLMGR_DumpTblCmd,  sizeof(APP_C_FW_DumpTbl_CmdPayload_t));
       
-      CFE_MSG_Init(CFE_MSG_PTR(AstroPiApp.StatusTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_STATUS_TLM_TOPICID)), sizeof(ASTRO_PI_StatusTlm_t));
-
-      /*
-      ** Application startup event message
-      */
-      CFE_EVS_SendEvent(ASTRO_PI_APP_INIT_APP_EID, CFE_EVS_EventType_INFORMATION,
-                        "Astro Pi App Initialized. Version %d.%d.%d",
-                        ASTRO_PI_APP_MAJOR_VER, ASTRO_PI_APP_MINOR_VER, ASTRO_PI_APP_PLATFORM_REV);
+                  TBLMGR_RegisterTblWithDef(TBLMGR_OBJ, CAL_TBL_LoadCmd, CAL_TBL_DumpCmd, INITBL_GetStrConfig(INITBL_OBJ, CFG_CAL_TBL_LOAD_FILE));
+      
+                  CFE_MSG_Init(CFE_MSG_PTR(AstroPiApp.StatusTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_STATUS_TLM_TOPICID)), sizeof(ASTRO_PI_StatusTlm_t));
+                  CFE_MSG_Init(CFE_MSG_PTR(AstroPiApp.DispatchTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_DISPATCH_TLM_TOPICID)), sizeof(ASTRO_PI_DispatchTlm_t));
+                  CFE_MSG_Init(CFE_MSG_PTR(AstroPiApp.ResourceTlm.TelemetryHeader), CFE_SB_ValueToMsgId(INITBL_GetIntConfig(INITBL_OBJ, CFG_ASTRO_PI_RESOURCE_TLM_TOPICID)), sizeof(ASTRO_PI_ResourceTlm_t));
+
+                  /*
+                  ** Application startup event message
+                  */
+                  CFE_EVS_SendEvent(ASTRO_PI_APP_INIT_APP_EID, CFE_EVS_EventType_INFORMATION,
+                                    "Astro Pi App Initialized. Version %d.%d.%d",
+                                    ASTRO_PI_APP_MAJOR_VER, ASTRO_PI_APP_MINOR_VER, ASTRO_PI_APP_PLATFORM_REV);
                         
-      RetStatus = CFE_SUCCESS;
+                  RetStatus = CFE_SUCCESS;
+               
+               } /* End if dispatch functions registered */
+            }
+            else
+            {
+               CFE_EVS_SendEvent(ASTRO_PI_APP_INIT_APP_EID, CFE_EVS_EventType_ERROR,
+                                 "Error creating the command pipe. Status = 0x%08X", (unsigned int)SysStatus);
+            }
+         } /* End if Sense HAT constructed */
+      } /* End if script sync and spectrum constructed */
+      
+      /* ProcessCommands() makes the balancing exit call when init succeeds */
+      if (RetStatus != CFE_SUCCESS)
+      {
+         CFE_ES_PerfLogExit(AstroPiApp.PerfId);
+      }
       
    } /* End if INITBL Constructed */
    
@@ -234,31 +319,15 @@ static int32 ProcessCommands(void)
 
    if (SysStatus == CFE_SUCCESS)
    {
-      SysStatus = CFE_MSG_GetMsgId(&SbBufPtr->Msg, &MsgId);
-
-      if (SysStatus == CFE_SUCCESS)
+      RESOURCE_BeginWork(ASTRO_PI_ResourceTask_MAIN);
+      if (!DISPATCH_ProcessMsg(DISPATCH_OBJ, SbBufPtr))
       {
-
-         if (CFE_SB_MsgId_Equal(MsgId, AstroPiApp.CmdMid))
-         {
-            CMDMGR_DispatchFunc(CMDMGR_OBJ, &SbBufPtr->Msg);
-         } 
-         else if (CFE_SB_MsgId_Equal(MsgId, AstroPiApp.SendStatusMid))
-         {   
-            SendStatusPkt();
-         }
-         else if (CFE_SB_MsgId_Equal(MsgId, AstroPiApp.JmsgTopicCsvTlmMid))
-         {   
-            PY_SCRIPT_CreateSenseHatTlm(&SbBufPtr->Msg);
-         }
-         else
-         {   
-            CFE_EVS_SendEvent(ASTRO_PI_APP_INVALID_MID_EID, CFE_EVS_EventType_ERROR,
-                              "Received invalid command packet, MID = 0x%04X(%d)", 
-                              CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId));
-         }
-
-      } /* End if got message ID */
+         CFE_MSG_GetMsgId(&SbBufPtr->Msg, &MsgId);
+         CFE_EVS_SendEvent(ASTRO_PI_APP_INVALID_MID_EID, CFE_EVS_EventType_ERROR,
+                           "Received invalid command packet, MID = 0x%04X(%d)", 
+                           CFE_SB_MsgIdToValue(MsgId), CFE_SB_MsgIdToValue(MsgId));
+      }
+      RESOURCE_EndWork(ASTRO_PI_ResourceTask_MAIN);
    } /* End if received buffer */
    else
    {
@@ -273,6 +342,110 @@ static int32 ProcessCommands(void)
 } /* End ProcessCommands() */
 
 
+/******************************************************************************
+** Function: ProcessCmdMsg
+**
+** Dispatch handler for the app's commands.
+**
+*/
+static bool ProcessCmdMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   return CMDMGR_DispatchFunc((CMDMGR_Class_t *)ObjDataPtr, MsgPtr);
+
+} /* End ProcessCmdMsg() */
+
+
+/******************************************************************************
+** Function: ProcessSendStatusMsg
+**
+** Dispatch handler for the scheduler's periodic status request.
+**
+*/
+static bool ProcessSendStatusMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   SendStatusPkt();
+   DIAG_Tick();
+   WARM_START_Tick();
+
+   return true;
+
+} /* End ProcessSendStatusMsg() */
+
+
+/******************************************************************************
+** Function: SendDispatchTlm
+**
+** Notes:
+**   1. Command pipe entries are followed by the Sense HAT ingest pipe
+**      entries. Unused entries are zero.
+**
+*/
+static void SendDispatchTlm(void)
+{
+
+   ASTRO_PI_DispatchTlm_Payload_t *Payload = &AstroPiApp.DispatchTlm.Payload;
+   const DISPATCH_Class_t *IngestDispatch  = &AstroPiApp.SenseHat.Ingest.Dispatch;
+
+   memset(Payload, 0, sizeof(ASTRO_PI_DispatchTlm_Payload_t));
+
+   Payload->EntryCnt  = DISPATCH_GetStats(DISPATCH_OBJ, Payload->Entry, DISPATCH_TLM_ENTRIES);
+   Payload->EntryCnt += DISPATCH_GetStats(IngestDispatch, &Payload->Entry[Payload->EntryCnt],
+                                          DISPATCH_TLM_ENTRIES - Payload->EntryCnt);
+
+   Payload->CmdUnknownMsgCnt    = AstroPiApp.Dispatch.UnknownMsgCnt;
+   Payload->IngestUnknownMsgCnt = IngestDispatch->UnknownMsgCnt;
+
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(AstroPiApp.DispatchTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(AstroPiApp.DispatchTlm.TelemetryHeader), true);
+
+} /* End SendDispatchTlm() */
+
+
+/******************************************************************************
+** Function: SendResourceTlm
+**
+** Notes:
+**   1. Queue peaks are in samples, script buffer peaks are in bytes.
+**   2. The Sense HAT queue and script output counters are written by child
+**      tasks. A peak that is one update behind is acceptable telemetry.
+**
+*/
+static void SendResourceTlm(void)
+{
+
+   ASTRO_PI_ResourceTlm_Payload_t *Payload = &AstroPiApp.ResourceTlm.Payload;
+   ASTRO_PI_SampleQueueStats_t    QueueStats;
+
+   memset(Payload, 0, sizeof(ASTRO_PI_ResourceTlm_Payload_t));
+
+   Payload->AppDataBytes = sizeof(ASTRO_PI_APP_Class_t);
+   RESOURCE_GetTaskUsage(Payload);
+
+   SAMPLE_QUEUE_GetStats(&AstroPiApp.SenseHat.PubQueue, &QueueStats);
+   Payload->PubQueue.Size = SAMPLE_QUEUE_DEPTH;
+   Payload->PubQueue.Peak = QueueStats.PeakDepth;
+
+   SAMPLE_QUEUE_GetStats(&AstroPiApp.Spectrum.Queue, &QueueStats);
+   Payload->SpectrumQueue.Size = SAMPLE_QUEUE_DEPTH;
+   Payload->SpectrumQueue.Peak = QueueStats.PeakDepth;
+
+   Payload->ScriptFileBuf.Size     = sizeof(AstroPiApp.PyScript.ScriptFileBuf);
+   Payload->ScriptFileBuf.Peak     = AstroPiApp.PyScript.PeakScriptFileBytes;
+   Payload->ScriptRawFileBuf.Size  = sizeof(AstroPiApp.PyScript.RawFileBuf);
+   Payload->ScriptRawFileBuf.Peak  = AstroPiApp.PyScript.PeakRawFileBytes;
+   Payload->ScriptOutputPages.Size = SCRIPT_OUTPUT_SCRIPTS*SCRIPT_OUTPUT_PAGES;
+   Payload->ScriptOutputPages.Peak = AstroPiApp.ScriptOutput.PeakBufferedPages;
+   Payload->SeqTrackSources.Size   = SEQ_TRACK_MAX_SOURCES;
+   Payload->SeqTrackSources.Peak   = AstroPiApp.SeqTrack.SourceCnt;
+
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(AstroPiApp.ResourceTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(AstroPiApp.ResourceTlm.TelemetryHeader), true);
+
+} /* End SendResourceTlm() */
+
+
 /******************************************************************************
 ** Function: SendStatusPkt
 **
@@ -290,13 +463,46 @@ void SendStatusPkt(void)
    Payload->InvalidCmdCnt  = AstroPiApp.CmdMgr.InvalidCmdCnt;
 
    /*
-   ** UDP Manager Data
+   ** Python Scripts
    */
 
-   Payload->SentScriptCnt  = AstroPiApp.PyScript.SentCnt;
-   strncpy(Payload->LastSentScript, AstroPiApp.PyScript.LastSent,OS_MAX_PATH_LEN); 
+   PY_SCRIPT_GetStatus(Payload);
+   SCRIPT_SYNC_GetStatus(Payload);
+   SCRIPT_OUTPUT_GetStatus(Payload);
+
+   /*
+   ** Diagnostics
+   */
+   
+   Payload->DiagLevel         = AstroPiApp.Diag.Level;
+   Payload->DiagSuppressedCnt = DIAG_GetSuppressedCnt();
+
+   /*
+   ** LED Matrix
+   */
+
+   LED_MATRIX_GetStatus(Payload);
+
+   /*
+   ** Sense HAT Pipeline
+   */
+   
+   SENSE_HAT_GetStatus(Payload);
+   CALIBRATE_GetStatus(Payload);
+   SAMPLE_SYNC_GetStatus(Payload);
+   SPECTRUM_GetStatus(Payload);
+
+   /*
+   ** Warm Start
+   */
+
+   WARM_START_GetStatus(Payload);
        
    CFE_SB_TimeStampMsg(CFE_MSG_PTR(AstroPiApp.StatusTlm.TelemetryHeader));
    CFE_SB_TransmitMsg(CFE_MSG_PTR(AstroPiApp.StatusTlm.TelemetryHeader), true);
 
+   SEQ_TRACK_SendTlm();
+   SendDispatchTlm();
+   SendResourceTlm();
+   
 } /* End SendStatusPkt() */
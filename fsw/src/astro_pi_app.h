@@ -32,7 +32,19 @@
 */
 
 #include "app_cfg.h"
+#include "calibrate.h"
+#include "diag.h"
+#include "dispatch.h"
+#include "led_matrix.h"
 #include "py_script.h"
+#include "resource.h"
+#include "sample_sync.h"
+#include "script_output.h"
+#include "script_sync.h"
+#include "sense_hat.h"
+#include "seq_track.h"
+#include "spectrum.h"
+#include "warm_start.h"
 
 /***********************/
 /** Macro Definitions **/
@@ -66,12 +78,16 @@ typedef struct
    INITBL_Class_t    IniTbl; 
    CFE_SB_PipeId_t   CmdPipe;
    CMDMGR_Class_t    CmdMgr;
+   TBLMGR_Class_t    TblMgr;
+   DISPATCH_Class_t  Dispatch;
       
    /*
    ** Telemetry Packets
    */
    
-   ASTRO_PI_StatusTlm_t   StatusTlm;
+   ASTRO_PI_StatusTlm_t    StatusTlm;
+   ASTRO_PI_DispatchTlm_t  DispatchTlm;
+   ASTRO_PI_ResourceTlm_t  ResourceTlm;
 
    
    /*
@@ -80,11 +96,18 @@ typedef struct
    
    uint32 PerfId;
    
-   CFE_SB_MsgId_t  CmdMid;
-   CFE_SB_MsgId_t  SendStatusMid;
-   CFE_SB_MsgId_t  JmsgTopicCsvTlmMid;
-   
+   CALIBRATE_Class_t Calibrate;
+   DIAG_Class_t      Diag;
+   LED_MATRIX_Class_t LedMatrix;
    PY_SCRIPT_Class_t PyScript;
+   RESOURCE_Class_t  Resource;
+   SAMPLE_SYNC_Class_t SampleSync;
+   SENSE_HAT_Class_t SenseHat;
+   SCRIPT_OUTPUT_Class_t ScriptOutput;
+   SCRIPT_SYNC_Class_t ScriptSync;
+   SEQ_TRACK_Class_t SeqTrack;
+   SPECTRUM_Class_t  Spectrum;
+   WARM_START_Class_t WarmStart;
 
 } ASTRO_PI_APP_Class_t;
 
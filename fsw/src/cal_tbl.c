@@ -0,0 +1,453 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the Sense HAT calibration table
+**
+** Notes:
+**   1. See cal_tbl.h for the table definition and validation rules.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <math.h>
+#include "cal_tbl.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void AddJsonObj(uint16 *ObjCnt, float *Data, const char *QueryFmt, const char *Name, int Idx);
+static bool LoadJsonData(size_t JsonFileLen);
+static void PublishData(const CAL_TBL_Data_t *Data);
+static bool ValidData(const CAL_TBL_Data_t *Data);
+static void WriteCoeffs(osal_id_t FileHandle, const char *Name, const float *Coeff, int CoeffCnt, const char *Suffix);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static CAL_TBL_Class_t *CalTbl;
+
+/* JSON names must be in CAL_TBL_Channel_t order */
+static const char *ChannelName[CAL_TBL_CHANNELS] =
+{
+   "temperature", "rate-x", "rate-y", "rate-z", "accel-x", "accel-y", "accel-z", "pressure", "humidity"
+};
+
+static const char *TriadName[CAL_TBL_TRIADS] = { "rate-misalign", "accel-misalign" };
+static const char *AxisName[CAL_TBL_TRIAD_AXES] = { "x", "y", "z" };
+
+
+/******************************************************************************
+** Function: CAL_TBL_Constructor
+**
+** Notes:
+**   1. The JSON objects load the working buffer. Queries are built from
+**      the channel and triad names so the object array can't get out of
+**      step with the data structure.
+**
+*/
+void CAL_TBL_Constructor(CAL_TBL_Class_t *CalTblPtr)
+{
+
+   uint16 ObjCnt = 0;
+
+   CalTbl = CalTblPtr;
+
+   memset(CalTbl, 0, sizeof(CAL_TBL_Class_t));
+
+   AddJsonObj(&ObjCnt, &CalTbl->LoadData.RefTemp, "ref-temp", NULL, 0);
+
+   for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+   {
+      for (int c=0; c < CAL_TBL_POLY_COEFFS; c++)
+      {
+         AddJsonObj(&ObjCnt, &CalTbl->LoadData.Poly[Ch][c], "channel.%s.poly[%d]", ChannelName[Ch], c);
+      }
+      AddJsonObj(&ObjCnt, &CalTbl->LoadData.TempCoeff[Ch], "channel.%s.temp-coeff", ChannelName[Ch], 0);
+   }
+
+   for (int Triad=0; Triad < CAL_TBL_TRIADS; Triad++)
+   {
+      for (int Row=0; Row < CAL_TBL_TRIAD_AXES; Row++)
+      {
+         for (int Col=0; Col < CAL_TBL_TRIAD_AXES; Col++)
+         {
+            char RowQuery[CAL_TBL_QUERY_LEN];
+            snprintf(RowQuery, sizeof(RowQuery), "%s.%s", TriadName[Triad], AxisName[Row]);
+            AddJsonObj(&ObjCnt, &CalTbl->LoadData.Misalign[Triad][Row][Col], "%s[%d]", RowQuery, Col);
+         }
+      }
+   }
+
+} /* End CAL_TBL_Constructor() */
+
+
+/******************************************************************************
+** Function: CAL_TBL_DumpCmd
+**
+*/
+bool CAL_TBL_DumpCmd(TBLMGR_Tbl_t *Tbl, uint8 DumpType, const char *Filename)
+{
+
+   const CAL_TBL_Data_t *Data = &CalTbl->Data;
+   bool       RetStatus = false;
+   int32      SysStatus;
+   osal_id_t  FileHandle;
+   os_err_name_t OsErrStr;
+   char  DumpRecord[256];
+   char  SysTimeStr[128];
+
+   SysStatus = OS_OpenCreate(&FileHandle, Filename, OS_FILE_FLAG_CREATE | OS_FILE_FLAG_TRUNCATE, OS_READ_WRITE);
+
+   if (SysStatus == OS_SUCCESS)
+   {
+
+      CFE_TIME_Print(SysTimeStr, CFE_TIME_GetTime());
+      snprintf(DumpRecord, sizeof(DumpRecord), "{\n   \"title\": \"Astro Pi Sense HAT calibration\",\n"
+               "   \"description\": \"Table dumped at %s\",\n", SysTimeStr);
+      OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+
+      snprintf(DumpRecord, sizeof(DumpRecord), "   \"ref-temp\": %.8g,\n   \"channel\": {\n", Data->RefTemp);
+      OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+
+      for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+      {
+         snprintf(DumpRecord, sizeof(DumpRecord), "      \"%s\": {\"poly\": ", ChannelName[Ch]);
+         OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+         WriteCoeffs(FileHandle, NULL, Data->Poly[Ch], CAL_TBL_POLY_COEFFS, "");
+         snprintf(DumpRecord, sizeof(DumpRecord), ", \"temp-coeff\": %.8g}%s\n",
+                  Data->TempCoeff[Ch], (Ch < CAL_TBL_CHANNELS-1) ? "," : "");
+         OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+      }
+
+      for (int Triad=0; Triad < CAL_TBL_TRIADS; Triad++)
+      {
+         snprintf(DumpRecord, sizeof(DumpRecord), "   },\n   \"%s\": {\n", TriadName[Triad]);
+         OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+         for (int Row=0; Row < CAL_TBL_TRIAD_AXES; Row++)
+         {
+            WriteCoeffs(FileHandle, AxisName[Row], Data->Misalign[Triad][Row], CAL_TBL_TRIAD_AXES,
+                        (Row < CAL_TBL_TRIAD_AXES-1) ? ",\n" : "\n");
+         }
+      }
+
+      snprintf(DumpRecord, sizeof(DumpRecord), "   }\n}\n");
+      OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+
+      OS_close(FileHandle);
+      RetStatus = true;
+
+   } /* End if file create */
+   else
+   {
+      OS_GetErrorName(SysStatus, &OsErrStr);
+      CFE_EVS_SendEvent(CAL_TBL_DUMP_ERR_EID, CFE_EVS_EventType_ERROR,
+                        "Error creating calibration table dump file '%s', status=%s",
+                        Filename, OsErrStr);
+   }
+
+   return RetStatus;
+
+} /* End of CAL_TBL_DumpCmd() */
+
+
+/******************************************************************************
+** Function: CAL_TBL_LoadCmd
+**
+*/
+bool CAL_TBL_LoadCmd(TBLMGR_Tbl_t *Tbl, uint8 LoadType, const char *Filename)
+{
+
+   bool RetStatus;
+
+   CalTbl->LastLoadType = LoadType;
+
+   RetStatus = CJSON_ProcessFile(Filename, CalTbl->JsonBuf, CAL_TBL_JSON_FILE_MAX_CHAR, LoadJsonData);
+
+   if (RetStatus)
+   {
+      CalTbl->Loaded = true;
+      CalTbl->LoadCnt++;
+   }
+   else
+   {
+      CalTbl->LoadErrCnt++;
+   }
+
+   return RetStatus;
+
+} /* End CAL_TBL_LoadCmd() */
+
+
+/******************************************************************************
+** Function: CAL_TBL_Read
+**
+** Notes:
+**   1. The table is copied to a local buffer and only kept if the sequence
+**      didn't change during the copy. If the table is being written the
+**      reader keeps its current copy and picks up the new table on a later
+**      call so it never waits for the main task.
+**
+*/
+bool CAL_TBL_Read(CAL_TBL_Data_t *Data, uint32 *Seq)
+{
+
+   CAL_TBL_Data_t Copy;
+   uint32 StartSeq;
+   uint32 EndSeq;
+
+   StartSeq = __atomic_load_n(&CalTbl->Seq, __ATOMIC_ACQUIRE);
+
+   if (StartSeq != *Seq && (StartSeq & 1) == 0)
+   {
+      memcpy(&Copy, &CalTbl->Data, sizeof(CAL_TBL_Data_t));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      EndSeq = __atomic_load_n(&CalTbl->Seq, __ATOMIC_RELAXED);
+      if (EndSeq == StartSeq)
+      {
+         *Data = Copy;
+         *Seq  = StartSeq;
+      }
+   }
+
+   return (*Seq != 0);
+
+} /* End CAL_TBL_Read() */
+
+
+/******************************************************************************
+** Function: CAL_TBL_ResetStatus
+**
+*/
+void CAL_TBL_ResetStatus(void)
+{
+
+   CalTbl->LoadCnt    = 0;
+   CalTbl->LoadErrCnt = 0;
+
+} /* End CAL_TBL_ResetStatus() */
+
+
+/******************************************************************************
+** Function: AddJsonObj
+**
+** Notes:
+**   1. QueryFmt has one %s for Name, if Name isn't NULL, followed by an
+**      optional %d for Idx.
+**
+*/
+static void AddJsonObj(uint16 *ObjCnt, float *Data, const char *QueryFmt, const char *Name, int Idx)
+{
+
+   CJSON_Obj_t *Obj   = &CalTbl->JsonObj[*ObjCnt];
+   char        *Query = CalTbl->Query[*ObjCnt];
+
+   if (Name == NULL)
+   {
+      strncpy(Query, QueryFmt, CAL_TBL_QUERY_LEN-1);
+   }
+   else
+   {
+      snprintf(Query, CAL_TBL_QUERY_LEN, QueryFmt, Name, Idx);
+   }
+
+   Obj->TblData    = Data;
+   Obj->TblDataLen = sizeof(float);
+   Obj->Updated    = false;
+   Obj->Type       = JSONNumber;
+   Obj->Float      = true;
+   Obj->Query.Key    = Query;
+   Obj->Query.KeyLen = strlen(Query);
+
+   (*ObjCnt)++;
+
+} /* End AddJsonObj() */
+
+
+/******************************************************************************
+** Function: LoadJsonData
+**
+** Notes:
+**   1. A replace load must define every value. An update load starts from
+**      the active table so values that aren't in the file are unchanged.
+**
+*/
+static bool LoadJsonData(size_t JsonFileLen)
+{
+
+   bool    RetStatus = false;
+   size_t  ObjLoadCnt;
+
+   CalTbl->JsonFileLen = JsonFileLen;
+
+   if (CalTbl->LastLoadType == TBLMGR_LOAD_TBL_UPDATE && CalTbl->Loaded)
+   {
+      CalTbl->LoadData = CalTbl->Data;
+   }
+   else
+   {
+      memset(&CalTbl->LoadData, 0, sizeof(CAL_TBL_Data_t));
+   }
+
+   ObjLoadCnt = CJSON_LoadObjArray(CalTbl->JsonObj, CAL_TBL_OBJ_CNT, CalTbl->JsonBuf, CalTbl->JsonFileLen);
+
+   if ((CalTbl->LastLoadType != TBLMGR_LOAD_TBL_UPDATE || !CalTbl->Loaded) && ObjLoadCnt != CAL_TBL_OBJ_CNT)
+   {
+      CFE_EVS_SendEvent(CAL_TBL_LOAD_ERR_EID, CFE_EVS_EventType_ERROR,
+                        "Calibration table replace load only contains %d of %d values",
+                        (int)ObjLoadCnt, CAL_TBL_OBJ_CNT);
+   }
+   else if (ValidData(&CalTbl->LoadData))
+   {
+      PublishData(&CalTbl->LoadData);
+      CFE_EVS_SendEvent(CAL_TBL_LOAD_EID, CFE_EVS_EventType_INFORMATION,
+                        "Calibration table %s loaded %d values",
+                        CalTbl->LastLoadType == TBLMGR_LOAD_TBL_UPDATE ? "update" : "replace",
+                        (int)ObjLoadCnt);
+      RetStatus = true;
+   }
+
+   return RetStatus;
+
+} /* End LoadJsonData() */
+
+
+/******************************************************************************
+** Function: PublishData
+**
+** Notes:
+**   1. Only the main task writes the table so the sequence doesn't need an
+**      atomic increment.
+**
+*/
+static void PublishData(const CAL_TBL_Data_t *Data)
+{
+
+   uint32 Seq = CalTbl->Seq;
+
+   __atomic_store_n(&CalTbl->Seq, Seq+1, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+
+   CalTbl->Data = *Data;
+
+   __atomic_store_n(&CalTbl->Seq, Seq+2, __ATOMIC_RELEASE);
+
+} /* End PublishData() */
+
+
+/******************************************************************************
+** Function: ValidData
+**
+** Notes:
+**   1. Data must be the load working buffer since the finite check uses
+**      the JSON objects to name a bad value.
+**   2. Sends an event for the first failure found.
+**
+*/
+static bool ValidData(const CAL_TBL_Data_t *Data)
+{
+
+   const float (*M)[CAL_TBL_TRIAD_AXES];
+   float Det;
+
+   for (int i=0; i < CAL_TBL_OBJ_CNT; i++)
+   {
+      if (!isfinite(*(const float *)CalTbl->JsonObj[i].TblData))
+      {
+         CFE_EVS_SendEvent(CAL_TBL_LOAD_ERR_EID, CFE_EVS_EventType_ERROR,
+                           "Calibration table %s is not a finite number", CalTbl->Query[i]);
+         return false;
+      }
+   }
+
+   for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+   {
+      if (Data->Poly[Ch][1] == 0.0f)
+      {
+         CFE_EVS_SendEvent(CAL_TBL_LOAD_ERR_EID, CFE_EVS_EventType_ERROR,
+                           "Calibration table %s linear coefficient is zero", ChannelName[Ch]);
+         return false;
+      }
+   }
+
+   if (Data->TempCoeff[CAL_TBL_TEMPERATURE] != 0.0f)
+   {
+      CFE_EVS_SendEvent(CAL_TBL_LOAD_ERR_EID, CFE_EVS_EventType_ERROR,
+                        "Calibration table temperature channel temp-coeff must be zero");
+      return false;
+   }
+
+   for (int Triad=0; Triad < CAL_TBL_TRIADS; Triad++)
+   {
+      M = Data->Misalign[Triad];
+      Det = M[0][0]*(M[1][1]*M[2][2] - M[1][2]*M[2][1]) -
+            M[0][1]*(M[1][0]*M[2][2] - M[1][2]*M[2][0]) +
+            M[0][2]*(M[1][0]*M[2][1] - M[1][1]*M[2][0]);
+      if (Det < CAL_TBL_MIN_DET || Det > CAL_TBL_MAX_DET)
+      {
+         CFE_EVS_SendEvent(CAL_TBL_LOAD_ERR_EID, CFE_EVS_EventType_ERROR,
+                           "Calibration table %s determinant %f is not between %.2f and %.2f",
+                           TriadName[Triad], Det, CAL_TBL_MIN_DET, CAL_TBL_MAX_DET);
+         return false;
+      }
+   }
+
+   return true;
+
+} /* End ValidData() */
+
+
+/******************************************************************************
+** Function: WriteCoeffs
+**
+** Write a JSON array of coefficients, as a named member if Name isn't NULL.
+**
+*/
+static void WriteCoeffs(osal_id_t FileHandle, const char *Name, const float *Coeff, int CoeffCnt, const char *Suffix)
+{
+
+   char   DumpRecord[256];
+   size_t Len = 0;
+
+   if (Name != NULL)
+   {
+      Len = snprintf(DumpRecord, sizeof(DumpRecord), "      \"%s\": ", Name);
+   }
+
+   Len += snprintf(&DumpRecord[Len], sizeof(DumpRecord)-Len, "[");
+   for (int c=0; c < CoeffCnt; c++)
+   {
+      Len += snprintf(&DumpRecord[Len], sizeof(DumpRecord)-Len, "%.8g%s", Coeff[c], (c < CoeffCnt-1) ? ", " : "");
+   }
+   snprintf(&DumpRecord[Len], sizeof(DumpRecord)-Len, "]%s", Suffix);
+
+   OS_write(FileHandle, DumpRecord, strlen(DumpRecord));
+
+} /* End WriteCoeffs() */
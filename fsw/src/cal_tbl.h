@@ -0,0 +1,216 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the Sense HAT calibration table
+**
+** Notes:
+**   1. Each float channel of the Sense HAT telemetry has a polynomial
+**        c[0] + c[1]*raw + c[2]*raw^2 + c[3]*raw^3
+**      and a temperature coefficient applied to the difference between
+**      the calibrated temperature and the table's reference temperature.
+**      The temperature channel's own coefficient must be zero.
+**   2. The rate and accel triads have a 3x3 misalignment matrix that is
+**      applied to the triad's polynomial corrected values. Each row is
+**      named by the output axis it computes.
+**   3. A load is validated as a whole before it replaces the active data.
+**      Every value must be finite, each polynomial's linear coefficient
+**      must be non-zero and each misalignment matrix determinant must be
+**      between CAL_TBL_MIN_DET and CAL_TBL_MAX_DET. An update load only
+**      needs to contain the values being changed.
+**   4. The table is loaded by the main task and read by the Sense HAT
+**      publish task. Loads are published with a sequence lock so the
+**      reader never blocks and never sees a partially written table.
+**
+*/
+
+#ifndef _cal_tbl_
+#define _cal_tbl_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define CAL_TBL_POLY_COEFFS  4
+#define CAL_TBL_TRIAD_AXES   3
+
+#define CAL_TBL_MIN_DET  0.5f
+#define CAL_TBL_MAX_DET  2.0f
+
+#define CAL_TBL_OBJ_CNT  (CAL_TBL_CHANNELS*(CAL_TBL_POLY_COEFFS+1) + \
+                          CAL_TBL_TRIADS*CAL_TBL_TRIAD_AXES*CAL_TBL_TRIAD_AXES + 1)
+
+#define CAL_TBL_QUERY_LEN           40
+#define CAL_TBL_JSON_FILE_MAX_CHAR  4000
+
+
+/*
+** Event Message IDs
+*/
+
+#define CAL_TBL_LOAD_EID       (CAL_TBL_BASE_EID + 0)
+#define CAL_TBL_LOAD_ERR_EID   (CAL_TBL_BASE_EID + 1)
+#define CAL_TBL_DUMP_ERR_EID   (CAL_TBL_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Channels are in calibration order, the temperature channel must be
+** first because the other channels are compensated with its calibrated
+** value.
+*/
+typedef enum
+{
+
+   CAL_TBL_TEMPERATURE = 0,
+   CAL_TBL_RATE_X,
+   CAL_TBL_RATE_Y,
+   CAL_TBL_RATE_Z,
+   CAL_TBL_ACCEL_X,
+   CAL_TBL_ACCEL_Y,
+   CAL_TBL_ACCEL_Z,
+   CAL_TBL_PRESSURE,
+   CAL_TBL_HUMIDITY,
+   CAL_TBL_CHANNELS
+
+} CAL_TBL_Channel_t;
+
+
+typedef enum
+{
+
+   CAL_TBL_RATE_TRIAD = 0,
+   CAL_TBL_ACCEL_TRIAD,
+   CAL_TBL_TRIADS
+
+} CAL_TBL_Triad_t;
+
+
+typedef struct
+{
+
+   float  RefTemp;
+   float  Poly[CAL_TBL_CHANNELS][CAL_TBL_POLY_COEFFS];
+   float  TempCoeff[CAL_TBL_CHANNELS];
+   float  Misalign[CAL_TBL_TRIADS][CAL_TBL_TRIAD_AXES][CAL_TBL_TRIAD_AXES];
+
+} CAL_TBL_Data_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Table Data
+   */
+
+   CAL_TBL_Data_t  Data;
+   uint32  Seq;            /* Odd while Data is being written, read and written with __atomic builtins */
+
+   /*
+   ** Class State Data
+   */
+
+   bool    Loaded;
+   uint8   LastLoadType;
+   uint32  LoadCnt;
+   uint32  LoadErrCnt;
+
+   CAL_TBL_Data_t  LoadData;   /* Load working buffer, validated before it's published */
+
+   size_t  JsonFileLen;
+   char    JsonBuf[CAL_TBL_JSON_FILE_MAX_CHAR];
+
+   CJSON_Obj_t  JsonObj[CAL_TBL_OBJ_CNT];
+   char         Query[CAL_TBL_OBJ_CNT][CAL_TBL_QUERY_LEN];
+
+} CAL_TBL_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: CAL_TBL_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. The table isn't loaded until it's registered with TBLMGR.
+**
+*/
+void CAL_TBL_Constructor(CAL_TBL_Class_t *CalTblPtr);
+
+
+/******************************************************************************
+** Function: CAL_TBL_DumpCmd
+**
+** Write the active table to a JSON file in the load file format.
+**
+** Notes:
+**   1. Function signature must match TBLMGR_DumpTblFuncPtr_t.
+**
+*/
+bool CAL_TBL_DumpCmd(TBLMGR_Tbl_t *Tbl, uint8 DumpType, const char *Filename);
+
+
+/******************************************************************************
+** Function: CAL_TBL_LoadCmd
+**
+** Load, validate and publish a JSON calibration table.
+**
+** Notes:
+**   1. Function signature must match TBLMGR_LoadTblFuncPtr_t.
+**   2. The active table is unchanged if the load fails.
+**
+*/
+bool CAL_TBL_LoadCmd(TBLMGR_Tbl_t *Tbl, uint8 LoadType, const char *Filename);
+
+
+/******************************************************************************
+** Function: CAL_TBL_Read
+**
+** Copy the active table into Data if it has changed since Seq.
+**
+** Notes:
+**   1. Only called by the Sense HAT publish task.
+**   2. Seq is the reader's copy of the table sequence, it's updated when
+**      Data is loaded.
+**   3. Returns false if a table has never been loaded.
+**
+*/
+bool CAL_TBL_Read(CAL_TBL_Data_t *Data, uint32 *Seq);
+
+
+/******************************************************************************
+** Function: CAL_TBL_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+*/
+void CAL_TBL_ResetStatus(void);
+
+
+#endif /* _cal_tbl_ */
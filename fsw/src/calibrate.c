@@ -0,0 +1,265 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Apply the calibration table to batches of Sense HAT samples
+**
+** Notes:
+**   1. See calibrate.h for the batch processing design and cal_tbl.h for
+**      the calibration equations.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stddef.h>
+#include "calibrate.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void ApplyMisalign(CAL_TBL_Triad_t Triad, uint32 SampleCnt);
+static void ApplyPoly(CAL_TBL_Channel_t Ch, uint32 SampleCnt);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static CALIBRATE_Class_t *Calibrate;
+
+/* Payload offsets in CAL_TBL_Channel_t order */
+static const size_t ChannelOffset[CAL_TBL_CHANNELS] =
+{
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, Temperature),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, RateX),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, RateY),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, RateZ),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, AccelX),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, AccelY),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, AccelZ),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, Pressure),
+   offsetof(ASTRO_PI_SenseHatTlm_Payload_t, Humidity)
+};
+
+static const CAL_TBL_Channel_t TriadFirstCh[CAL_TBL_TRIADS] = { CAL_TBL_RATE_X, CAL_TBL_ACCEL_X };
+
+
+/******************************************************************************
+** Function: CALIBRATE_Constructor
+**
+*/
+void CALIBRATE_Constructor(CALIBRATE_Class_t *CalibratePtr)
+{
+
+   Calibrate = CalibratePtr;
+
+   memset(Calibrate, 0, sizeof(CALIBRATE_Class_t));
+
+   CAL_TBL_Constructor(&Calibrate->Tbl);
+
+} /* End CALIBRATE_Constructor() */
+
+
+/******************************************************************************
+** Function: CALIBRATE_ApplyBatch
+**
+*/
+void CALIBRATE_ApplyBatch(SAMPLE_QUEUE_Entry_t *Batch, uint32 SampleCnt)
+{
+
+   ASTRO_PI_CalibrationStats_t *Stats = &Calibrate->Stats;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+   uint64     BatchNs;
+   uint32     SampleNs;
+
+   if (SampleCnt == 0)
+   {
+      return;
+   }
+
+   if (!CAL_TBL_Read(&Calibrate->Coeff, &Calibrate->CoeffSeq))
+   {
+      Stats->UncalSampleCnt += SampleCnt;
+      return;
+   }
+
+   OS_GetLocalTime(&StartTime);
+
+   for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+   {
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         Calibrate->Chan[Ch][i] = *(const float *)((const uint8 *)&Batch[i].Payload + ChannelOffset[Ch]);
+      }
+   }
+
+   for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+   {
+      ApplyPoly(Ch, SampleCnt);
+   }
+
+   for (int Triad=0; Triad < CAL_TBL_TRIADS; Triad++)
+   {
+      ApplyMisalign(Triad, SampleCnt);
+   }
+
+   for (int Ch=0; Ch < CAL_TBL_CHANNELS; Ch++)
+   {
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         *(float *)((uint8 *)&Batch[i].Payload + ChannelOffset[Ch]) = Calibrate->Chan[Ch][i];
+      }
+   }
+
+   OS_GetLocalTime(&EndTime);
+
+   BatchNs  = (uint64)OS_TimeGetTotalNanoseconds(OS_TimeSubtract(EndTime, StartTime));
+   SampleNs = (uint32)(BatchNs / SampleCnt);
+
+   Stats->BatchCnt++;
+   Stats->SampleCnt += SampleCnt;
+   Stats->LastSampleNs = SampleNs;
+   if (SampleNs > Stats->MaxSampleNs)
+   {
+      Stats->MaxSampleNs = SampleNs;
+   }
+   Calibrate->TotalTimeNs += BatchNs;
+
+} /* End CALIBRATE_ApplyBatch() */
+
+
+/******************************************************************************
+** Function: CALIBRATE_GetStatus
+**
+*/
+void CALIBRATE_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   ASTRO_PI_CalibrationStats_t *Stats = &Calibrate->Stats;
+
+   Stats->TblLoaded     = Calibrate->Tbl.Loaded;
+   Stats->TblLoadCnt    = Calibrate->Tbl.LoadCnt;
+   Stats->TblLoadErrCnt = Calibrate->Tbl.LoadErrCnt;
+   Stats->AvgSampleNs   = (Stats->SampleCnt > 0) ? (uint32)(Calibrate->TotalTimeNs / Stats->SampleCnt) : 0;
+
+   Payload->Calibration = *Stats;
+
+} /* End CALIBRATE_GetStatus() */
+
+
+/******************************************************************************
+** Function: CALIBRATE_ResetStatus
+**
+*/
+void CALIBRATE_ResetStatus(void)
+{
+
+   memset(&Calibrate->Stats, 0, sizeof(Calibrate->Stats));
+   Calibrate->TotalTimeNs = 0;
+
+   CAL_TBL_ResetStatus();
+
+} /* End CALIBRATE_ResetStatus() */
+
+
+/******************************************************************************
+** Function: ApplyMisalign
+**
+** Multiply each sample's triad vector by the triad's misalignment matrix.
+**
+*/
+static void ApplyMisalign(CAL_TBL_Triad_t Triad, uint32 SampleCnt)
+{
+
+   const float (*M)[CAL_TBL_TRIAD_AXES] = Calibrate->Coeff.Misalign[Triad];
+   const float *restrict X = Calibrate->Chan[TriadFirstCh[Triad]];
+   const float *restrict Y = Calibrate->Chan[TriadFirstCh[Triad]+1];
+   const float *restrict Z = Calibrate->Chan[TriadFirstCh[Triad]+2];
+
+   for (int Row=0; Row < CAL_TBL_TRIAD_AXES; Row++)
+   {
+      const float Mx = M[Row][0];
+      const float My = M[Row][1];
+      const float Mz = M[Row][2];
+      float *restrict Out = Calibrate->Triad[Row];
+
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         Out[i] = Mx*X[i] + My*Y[i] + Mz*Z[i];
+      }
+   }
+
+   for (int Row=0; Row < CAL_TBL_TRIAD_AXES; Row++)
+   {
+      memcpy(Calibrate->Chan[TriadFirstCh[Triad]+Row], Calibrate->Triad[Row], SampleCnt*sizeof(float));
+   }
+
+} /* End ApplyMisalign() */
+
+
+/******************************************************************************
+** Function: ApplyPoly
+**
+** Apply a channel's polynomial and temperature compensation.
+**
+** Notes:
+**   1. The temperature channel is calibrated first so the other channels
+**      are compensated with the calibrated temperature.
+**
+*/
+static void ApplyPoly(CAL_TBL_Channel_t Ch, uint32 SampleCnt)
+{
+
+   const float *Poly = Calibrate->Coeff.Poly[Ch];
+   const float C0 = Poly[0];
+   const float C1 = Poly[1];
+   const float C2 = Poly[2];
+   const float C3 = Poly[3];
+   float *restrict X = Calibrate->Chan[Ch];
+
+   if (Ch == CAL_TBL_TEMPERATURE)
+   {
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         X[i] = C0 + X[i]*(C1 + X[i]*(C2 + X[i]*C3));
+      }
+   }
+   else
+   {
+      const float TempCoeff = Calibrate->Coeff.TempCoeff[Ch];
+      const float RefTemp   = Calibrate->Coeff.RefTemp;
+      const float *restrict T = Calibrate->Chan[CAL_TBL_TEMPERATURE];
+
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         X[i] = C0 + X[i]*(C1 + X[i]*(C2 + X[i]*C3)) + TempCoeff*(T[i] - RefTemp);
+      }
+   }
+
+} /* End ApplyPoly() */
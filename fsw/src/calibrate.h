@@ -0,0 +1,125 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Apply the calibration table to batches of Sense HAT samples
+**
+** Notes:
+**   1. The publish task calibrates each batch it pops before the samples
+**      are published so Sense HAT telemetry and the spectrum stage receive
+**      calibrated values. Samples are published raw until a calibration
+**      table has been loaded.
+**   2. A batch is gathered into one array per channel so the polynomial
+**      and misalignment loops are simple loops over contiguous floats that
+**      the compiler can vectorize, then scattered back into the samples.
+**   3. The publish task keeps its own copy of the coefficients and only
+**      copies the table again when a load has changed it.
+**   4. The calibration time of each batch is measured and reported per
+**      sample in the status telemetry.
+**
+*/
+
+#ifndef _calibrate_
+#define _calibrate_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "cal_tbl.h"
+#include "sample_queue.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   /*
+   ** Contained Objects
+   */
+
+   CAL_TBL_Class_t  Tbl;
+
+   /*
+   ** Class State Data, owned by the publish task
+   */
+
+   CAL_TBL_Data_t  Coeff;
+   uint32  CoeffSeq;
+
+   uint64  TotalTimeNs;
+   ASTRO_PI_CalibrationStats_t  Stats;
+
+   float   Chan[CAL_TBL_CHANNELS][SENSE_HAT_PUB_BATCH_LEN];
+   float   Triad[CAL_TBL_TRIAD_AXES][SENSE_HAT_PUB_BATCH_LEN];
+
+} CALIBRATE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: CALIBRATE_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void CALIBRATE_Constructor(CALIBRATE_Class_t *CalibratePtr);
+
+
+/******************************************************************************
+** Function: CALIBRATE_ApplyBatch
+**
+** Calibrate the float channels of SampleCnt samples in place.
+**
+** Notes:
+**   1. Only called by the Sense HAT publish task. SampleCnt must not exceed
+**      SENSE_HAT_PUB_BATCH_LEN.
+**
+*/
+void CALIBRATE_ApplyBatch(SAMPLE_QUEUE_Entry_t *Batch, uint32 SampleCnt);
+
+
+/******************************************************************************
+** Function: CALIBRATE_GetStatus
+**
+** Load the calibration fields of the app's status telemetry payload.
+**
+*/
+void CALIBRATE_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: CALIBRATE_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+*/
+void CALIBRATE_ResetStatus(void);
+
+
+#endif /* _calibrate_ */
@@ -0,0 +1,301 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Rate limit and aggregate diagnostic output from the telemetry paths
+**
+** Notes:
+**   1. See diag.h for the token bucket and summary scheme.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stdio.h>
+#include "diag.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+/*
+** The summary string is inserted into the summary event so it gets what's
+** left of the event message after the longest fixed text
+*/
+#define DIAG_SUMMARY_FIXED_TEXT  "Last 4294967295s: suppressed 4294967295"
+#define DIAG_SUMMARY_STR_LEN     ((int)(CFE_MISSION_EVS_MAX_MESSAGE_LENGTH - (sizeof(DIAG_SUMMARY_FIXED_TEXT)-1)))
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void SendSummary(void);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static DIAG_Class_t *Diag;
+
+/* Must be in DIAG_Category_t order */
+static const char *DIAG_CategoryLabel[DIAG_CATEGORY_CNT] =
+{
+   "sent",
+   "parse err",
+   "resync",
+   "led frame err",
+   "missed tick"
+};
+
+static const ASTRO_PI_DiagLevel_Enum_t DIAG_CategoryMinLevel[DIAG_CATEGORY_CNT] =
+{
+   ASTRO_PI_DiagLevel_DEBUG,
+   ASTRO_PI_DiagLevel_ERROR,
+   ASTRO_PI_DiagLevel_INFO,
+   ASTRO_PI_DiagLevel_ERROR,
+   ASTRO_PI_DiagLevel_INFO
+};
+
+
+/******************************************************************************
+** Function: DIAG_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Buckets start full so startup problems are reported immediately.
+**   3. An invalid Level is rejected the same way DIAG_SetLevelCmd() does and
+**      the ERROR level is used.
+**
+*/
+void DIAG_Constructor(DIAG_Class_t *DiagPtr, uint16 Level, uint32 EventRate,
+                      uint32 EventBurst, uint32 SummaryPeriod)
+{
+
+   Diag = DiagPtr;
+
+   memset(Diag, 0, sizeof(DIAG_Class_t));
+
+   Diag->Level         = ASTRO_PI_DiagLevel_ERROR;
+   Diag->EventRate     = EventRate;
+   Diag->EventBurst    = EventBurst;
+   Diag->SummaryPeriod = SummaryPeriod;
+
+   for (int i=0; i < DIAG_CATEGORY_CNT; i++)
+   {
+      Diag->Category[i].MinLevel    = DIAG_CategoryMinLevel[i];
+      Diag->Category[i].MilliTokens = EventBurst * DIAG_MILLI_TOKEN;
+   }
+
+   if (Level <= ASTRO_PI_DiagLevel_DEBUG)
+   {
+      Diag->Level = Level;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(DIAG_SET_LEVEL_EID, CFE_EVS_EventType_ERROR,
+                        "Invalid INI diagnostic level %d, using level %d", Level, Diag->Level);
+   }
+
+} /* End DIAG_Constructor() */
+
+
+/******************************************************************************
+** Function: DIAG_Count
+**
+*/
+bool DIAG_Count(DIAG_Category_t Category)
+{
+
+   bool  RetStatus = false;
+   DIAG_Category_Stats_t *Stats = &Diag->Category[Category];
+
+   Stats->PeriodCnt++;
+
+   if (Diag->Level >= Stats->MinLevel)
+   {
+      if (Stats->MilliTokens >= DIAG_MILLI_TOKEN)
+      {
+         Stats->MilliTokens -= DIAG_MILLI_TOKEN;
+         RetStatus = true;
+      }
+      else
+      {
+         Stats->PeriodSuppressedCnt++;
+         Stats->SuppressedCnt++;
+      }
+   }
+
+   return RetStatus;
+
+} /* End DIAG_Count() */
+
+
+/******************************************************************************
+** Function: DIAG_GetSuppressedCnt
+**
+*/
+uint32 DIAG_GetSuppressedCnt(void)
+{
+
+   uint32 SuppressedCnt = 0;
+
+   for (int i=0; i < DIAG_CATEGORY_CNT; i++)
+   {
+      SuppressedCnt += Diag->Category[i].SuppressedCnt;
+   }
+
+   return SuppressedCnt;
+
+} /* End DIAG_GetSuppressedCnt() */
+
+
+/******************************************************************************
+** Function: DIAG_ResetStatus
+**
+*/
+void DIAG_ResetStatus(void)
+{
+
+   for (int i=0; i < DIAG_CATEGORY_CNT; i++)
+   {
+      Diag->Category[i].MilliTokens   = Diag->EventBurst * DIAG_MILLI_TOKEN;
+      Diag->Category[i].SuppressedCnt = 0;
+   }
+
+} /* End DIAG_ResetStatus() */
+
+
+/******************************************************************************
+** Function: DIAG_SetLevelCmd
+**
+*/
+bool DIAG_SetLevelCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const ASTRO_PI_SetDiagLevel_CmdPayload_t *SetDiagLevelCmd = CMDMGR_PAYLOAD_PTR(MsgPtr, ASTRO_PI_SetDiagLevel_t);
+
+   bool RetStatus = false;
+
+   if (SetDiagLevelCmd->Level <= ASTRO_PI_DiagLevel_DEBUG)
+   {
+      CFE_EVS_SendEvent(DIAG_SET_LEVEL_EID, CFE_EVS_EventType_INFORMATION,
+                        "Diagnostic level changed from %d to %d", Diag->Level, SetDiagLevelCmd->Level);
+      Diag->Level = SetDiagLevelCmd->Level;
+      RetStatus = true;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(DIAG_SET_LEVEL_EID, CFE_EVS_EventType_ERROR,
+                        "Set diagnostic level command rejected, invalid level %d", SetDiagLevelCmd->Level);
+   }
+
+   return RetStatus;
+
+} /* End DIAG_SetLevelCmd() */
+
+
+/******************************************************************************
+** Function: DIAG_Tick
+**
+** Notes:
+**   1. The first call only establishes the time reference.
+**
+*/
+void DIAG_Tick(void)
+{
+
+   CFE_TIME_SysTime_t  Now   = CFE_TIME_GetTime();
+   CFE_TIME_SysTime_t  Delta;
+   uint32  DeltaMs;
+   uint32  MaxMilliTokens = Diag->EventBurst * DIAG_MILLI_TOKEN;
+   DIAG_Category_Stats_t *Stats;
+
+   if (!Diag->TimeValid)
+   {
+      Diag->LastTick  = Now;
+      Diag->TimeValid = true;
+      return;
+   }
+
+   Delta   = CFE_TIME_Subtract(Now, Diag->LastTick);
+   DeltaMs = Delta.Seconds*1000 + CFE_TIME_Sub2MicroSecs(Delta.Subseconds)/1000;
+   Diag->LastTick = Now;
+
+   for (int i=0; i < DIAG_CATEGORY_CNT; i++)
+   {
+      Stats = &Diag->Category[i];
+      Stats->MilliTokens += Diag->EventRate * DeltaMs;
+      if (Stats->MilliTokens > MaxMilliTokens)
+      {
+         Stats->MilliTokens = MaxMilliTokens;
+      }
+   }
+
+   Diag->TickMs += DeltaMs;
+   if (Diag->TickMs >= Diag->SummaryPeriod*1000)
+   {
+      SendSummary();
+      Diag->TickMs = 0;
+   }
+
+} /* End DIAG_Tick() */
+
+
+/******************************************************************************
+** Function: SendSummary
+**
+** Notes:
+**   1. Nothing is sent for a quiet period.
+**
+*/
+static void SendSummary(void)
+{
+
+   char    SummaryStr[DIAG_SUMMARY_STR_LEN];
+   int     StrLen = 0;
+   uint32  PeriodTotal = 0;
+   uint32  PeriodSuppressed = 0;
+   DIAG_Category_Stats_t *Stats;
+
+   for (int i=0; i < DIAG_CATEGORY_CNT; i++)
+   {
+      Stats = &Diag->Category[i];
+      PeriodTotal      += Stats->PeriodCnt;
+      PeriodSuppressed += Stats->PeriodSuppressedCnt;
+      if (StrLen < DIAG_SUMMARY_STR_LEN)
+      {
+         StrLen += snprintf(&SummaryStr[StrLen], DIAG_SUMMARY_STR_LEN-StrLen, "%s %u, ",
+                            DIAG_CategoryLabel[i], (unsigned int)Stats->PeriodCnt);
+      }
+      Stats->PeriodCnt = 0;
+      Stats->PeriodSuppressedCnt = 0;
+   }
+
+   if ((PeriodTotal > 0) && (Diag->Level >= ASTRO_PI_DiagLevel_SUMMARY))
+   {
+      CFE_EVS_SendEvent(DIAG_SUMMARY_EID, CFE_EVS_EventType_INFORMATION,
+                        "Last %us: %ssuppressed %u", (unsigned int)(Diag->TickMs/1000),
+                        SummaryStr, (unsigned int)PeriodSuppressed);
+   }
+
+} /* End SendSummary() */
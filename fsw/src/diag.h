@@ -0,0 +1,181 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Rate limit and aggregate diagnostic output from the telemetry paths
+**
+** Notes:
+**   1. Callers report every occurrence with DIAG_Count() and only send
+**      their detailed event message when it returns true. DIAG_Count()
+**      is a level check, a counter increment and a token decrement so it
+**      can be called for every telemetry sample.
+**   2. Each category has a token bucket that is refilled by DIAG_Tick()
+**      which is called from the app's periodic status wakeup. This keeps
+**      time reads off the hot path.
+**   3. DIAG_Tick() also issues one aggregated summary event per summary
+**      period that includes the occurrences suppressed by rate limiting.
+**
+*/
+
+#ifndef _diag_
+#define _diag_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define DIAG_MILLI_TOKEN  1000   /* Token buckets use fixed point to allow fractional refills */
+
+
+/*
+** Event Message IDs
+*/
+
+#define DIAG_SET_LEVEL_EID  (DIAG_BASE_EID + 0)
+#define DIAG_SUMMARY_EID    (DIAG_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Categories must start at 0 and be contiguous. DIAG_CategoryLabel[] in
+** diag.c must be kept in sync.
+*/
+typedef enum
+{
+
+   DIAG_SENSE_HAT_SENT = 0,
+   DIAG_SENSE_HAT_PARSE_ERR,
+   DIAG_SEQ_RESYNC,
+   DIAG_LED_FRAME_ERR,
+   DIAG_SAMPLE_MISSED_TICK,
+   DIAG_CATEGORY_CNT
+
+} DIAG_Category_t;
+
+
+typedef struct
+{
+
+   ASTRO_PI_DiagLevel_Enum_t MinLevel;   /* Lowest diag level that allows detailed messages */
+
+   uint32  MilliTokens;
+   uint32  PeriodCnt;                    /* Occurrences in the current summary period */
+   uint32  PeriodSuppressedCnt;
+   uint32  SuppressedCnt;                /* Total suppressed since reset */
+
+} DIAG_Category_Stats_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   ASTRO_PI_DiagLevel_Enum_t Level;
+
+   uint32  EventRate;          /* Detailed messages per second allowed for each category */
+   uint32  EventBurst;         /* Token bucket depth */
+   uint32  SummaryPeriod;      /* Seconds between summary events */
+
+   bool    TimeValid;
+   CFE_TIME_SysTime_t  LastTick;
+   uint32  TickMs;             /* Milliseconds accumulated in the current summary period */
+
+   DIAG_Category_Stats_t Category[DIAG_CATEGORY_CNT];
+
+} DIAG_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: DIAG_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void DIAG_Constructor(DIAG_Class_t *DiagPtr, uint16 Level, uint32 EventRate,
+                      uint32 EventBurst, uint32 SummaryPeriod);
+
+
+/******************************************************************************
+** Function: DIAG_Count
+**
+** Count an occurrence of a diagnostic category.
+**
+** Notes:
+**   1. Returns true if the caller may send its detailed message.
+**   2. Counts may be off by one if two tasks report the same category at
+**      the same instant. This is acceptable for diagnostics and avoids a
+**      lock on the hot path.
+**
+*/
+bool DIAG_Count(DIAG_Category_t Category);
+
+
+/******************************************************************************
+** Function: DIAG_GetSuppressedCnt
+**
+** Return the total number of suppressed messages for all categories.
+**
+*/
+uint32 DIAG_GetSuppressedCnt(void);
+
+
+/******************************************************************************
+** Function: DIAG_ResetStatus
+**
+** Reset counters and status flags to a known reset state.
+**
+*/
+void DIAG_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: DIAG_SetLevelCmd
+**
+*/
+bool DIAG_SetLevelCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+/******************************************************************************
+** Function: DIAG_Tick
+**
+** Refill token buckets and send a summary event when the summary period
+** expires.
+**
+** Notes:
+**   1. Must be called periodically from the main task.
+**
+*/
+void DIAG_Tick(void);
+
+
+#endif /* _diag_ */
@@ -0,0 +1,261 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Dispatch software bus messages received on a pipe to registered
+**   message handlers
+**
+** Notes:
+**   1. Handler times are measured with the OSAL local time which has at
+**      least microsecond resolution on supported platforms.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "dispatch.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint16 HashMsgId(CFE_SB_MsgId_t MsgId);
+static int16  LookupMsgId(const DISPATCH_Class_t *Dispatch, CFE_SB_MsgId_t MsgId, uint16 *HashSlot);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+
+/******************************************************************************
+** Function: DISPATCH_Constructor
+**
+*/
+void DISPATCH_Constructor(DISPATCH_Class_t *Dispatch, CFE_SB_PipeId_t Pipe)
+{
+
+   memset(Dispatch, 0, sizeof(DISPATCH_Class_t));
+
+   Dispatch->Pipe = Pipe;
+
+} /* End DISPATCH_Constructor() */
+
+
+/******************************************************************************
+** Function: DISPATCH_GetStats
+**
+*/
+uint16 DISPATCH_GetStats(const DISPATCH_Class_t *Dispatch, ASTRO_PI_DispatchStats_t *Stats, uint16 MaxStats)
+{
+
+   uint16 StatsCnt = (Dispatch->EntryCnt < MaxStats) ? Dispatch->EntryCnt : MaxStats;
+   const DISPATCH_Entry_t *Entry;
+
+   for (uint16 i=0; i < StatsCnt; i++)
+   {
+      Entry = &Dispatch->Entry[i];
+      Stats[i].MsgId       = CFE_SB_MsgIdToValue(Entry->MsgId);
+      Stats[i].RcvCnt      = Entry->RcvCnt;
+      Stats[i].ErrCnt      = Entry->ErrCnt;
+      Stats[i].AvgTimeUs   = (Entry->RcvCnt > 0) ? (uint32)(Entry->TotalTimeUs / Entry->RcvCnt) : 0;
+      Stats[i].MaxTimeUs   = Entry->MaxTimeUs;
+      Stats[i].TotalTimeMs = (uint32)(Entry->TotalTimeUs / 1000);
+   }
+
+   return StatsCnt;
+
+} /* End DISPATCH_GetStats() */
+
+
+/******************************************************************************
+** Function: DISPATCH_ProcessMsg
+**
+*/
+bool DISPATCH_ProcessMsg(DISPATCH_Class_t *Dispatch, const CFE_SB_Buffer_t *SbBufPtr)
+{
+
+   CFE_SB_MsgId_t    MsgId = CFE_SB_INVALID_MSG_ID;
+   DISPATCH_Entry_t  *Entry;
+   int16      EntryIdx;
+   uint16     HashSlot;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+   uint32     TimeUs;
+
+   if (CFE_MSG_GetMsgId(&SbBufPtr->Msg, &MsgId) != CFE_SUCCESS)
+   {
+      Dispatch->UnknownMsgCnt++;
+      return false;
+   }
+
+   EntryIdx = LookupMsgId(Dispatch, MsgId, &HashSlot);
+   if (EntryIdx < 0)
+   {
+      Dispatch->UnknownMsgCnt++;
+      return false;
+   }
+
+   Entry = &Dispatch->Entry[EntryIdx];
+
+   OS_GetLocalTime(&StartTime);
+   if (!Entry->MsgFunc(Entry->ObjDataPtr, &SbBufPtr->Msg))
+   {
+      Entry->ErrCnt++;
+   }
+   OS_GetLocalTime(&EndTime);
+
+   TimeUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+   Entry->RcvCnt++;
+   Entry->TotalTimeUs += TimeUs;
+   if (TimeUs > Entry->MaxTimeUs)
+   {
+      Entry->MaxTimeUs = TimeUs;
+   }
+
+   return true;
+
+} /* End DISPATCH_ProcessMsg() */
+
+
+/******************************************************************************
+** Function: DISPATCH_RegisterFunc
+**
+*/
+bool DISPATCH_RegisterFunc(DISPATCH_Class_t *Dispatch, CFE_SB_MsgId_t MsgId,
+                           void *ObjDataPtr, DISPATCH_MsgFunc_t MsgFunc)
+{
+
+   int32   SysStatus;
+   uint16  HashSlot;
+   DISPATCH_Entry_t *Entry;
+
+   if (Dispatch->EntryCnt >= DISPATCH_MAX_ENTRIES)
+   {
+      CFE_EVS_SendEvent(DISPATCH_REGISTER_EID, CFE_EVS_EventType_ERROR,
+                        "Dispatch registration of MID 0x%04X failed, table full with %d entries",
+                        CFE_SB_MsgIdToValue(MsgId), DISPATCH_MAX_ENTRIES);
+      return false;
+   }
+
+   if (LookupMsgId(Dispatch, MsgId, &HashSlot) >= 0)
+   {
+      CFE_EVS_SendEvent(DISPATCH_REGISTER_EID, CFE_EVS_EventType_ERROR,
+                        "Dispatch registration of MID 0x%04X failed, MID already registered",
+                        CFE_SB_MsgIdToValue(MsgId));
+      return false;
+   }
+
+   SysStatus = CFE_SB_Subscribe(MsgId, Dispatch->Pipe);
+   if (SysStatus != CFE_SUCCESS)
+   {
+      CFE_EVS_SendEvent(DISPATCH_REGISTER_EID, CFE_EVS_EventType_ERROR,
+                        "Dispatch registration of MID 0x%04X failed, subscribe status = 0x%08X",
+                        CFE_SB_MsgIdToValue(MsgId), SysStatus);
+      return false;
+   }
+
+   Entry = &Dispatch->Entry[Dispatch->EntryCnt];
+   memset(Entry, 0, sizeof(DISPATCH_Entry_t));
+   Entry->MsgId      = MsgId;
+   Entry->ObjDataPtr = ObjDataPtr;
+   Entry->MsgFunc    = MsgFunc;
+
+   Dispatch->EntryCnt++;
+   Dispatch->HashTbl[HashSlot] = (uint8)Dispatch->EntryCnt;
+
+   return true;
+
+} /* End DISPATCH_RegisterFunc() */
+
+
+/******************************************************************************
+** Function: DISPATCH_ResetStatus
+**
+*/
+void DISPATCH_ResetStatus(DISPATCH_Class_t *Dispatch)
+{
+
+   Dispatch->UnknownMsgCnt = 0;
+
+   for (uint16 i=0; i < Dispatch->EntryCnt; i++)
+   {
+      Dispatch->Entry[i].RcvCnt      = 0;
+      Dispatch->Entry[i].ErrCnt      = 0;
+      Dispatch->Entry[i].TotalTimeUs = 0;
+      Dispatch->Entry[i].MaxTimeUs   = 0;
+   }
+
+} /* End DISPATCH_ResetStatus() */
+
+
+/******************************************************************************
+** Function: HashMsgId
+**
+** Fibonacci hash of the MsgId value reduced to a hash table slot.
+**
+*/
+static uint16 HashMsgId(CFE_SB_MsgId_t MsgId)
+{
+
+   uint32 Hash = (uint32)CFE_SB_MsgIdToValue(MsgId) * 2654435769u;
+
+   return (uint16)((Hash >> 16) & (DISPATCH_HASH_SLOTS-1));
+
+} /* End HashMsgId() */
+
+
+/******************************************************************************
+** Function: LookupMsgId
+**
+** Notes:
+**   1. Returns the entry index or -1 if the MsgId isn't registered. HashSlot
+**      is set to the entry's slot or the empty slot where it can be added.
+**   2. The table is never more than half full so an empty slot is always
+**      found.
+**
+*/
+static int16 LookupMsgId(const DISPATCH_Class_t *Dispatch, CFE_SB_MsgId_t MsgId, uint16 *HashSlot)
+{
+
+   uint16 Slot = HashMsgId(MsgId);
+   uint8  EntryIdx;
+
+   while ((EntryIdx = Dispatch->HashTbl[Slot]) != 0)
+   {
+      if (CFE_SB_MsgId_Equal(Dispatch->Entry[EntryIdx-1].MsgId, MsgId))
+      {
+         *HashSlot = Slot;
+         return (int16)(EntryIdx-1);
+      }
+      Slot = (Slot + 1) & (DISPATCH_HASH_SLOTS-1);
+   }
+
+   *HashSlot = Slot;
+
+   return -1;
+
+} /* End LookupMsgId() */
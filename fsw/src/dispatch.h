@@ -0,0 +1,160 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Dispatch software bus messages received on a pipe to registered
+**   message handlers
+**
+** Notes:
+**   1. Each task that receives SB messages owns a DISPATCH instance for its
+**      pipe. Objects register a handler for each MsgId they process when
+**      they're constructed, which also subscribes the pipe to the MsgId.
+**   2. Handlers are found with an open addressing hash table indexed by the
+**      MsgId value so the lookup cost doesn't grow with the number of
+**      registered messages.
+**   3. Receive counts and handler execution times are accumulated for each
+**      MsgId. Only the owning task updates an instance's counters. Resets
+**      from the app's main task may race with an update.
+**
+*/
+
+#ifndef _dispatch_
+#define _dispatch_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define DISPATCH_HASH_SLOTS  (2*DISPATCH_MAX_ENTRIES)   /* Must be a power of 2 */
+
+
+/*
+** Event Message IDs
+*/
+
+#define DISPATCH_REGISTER_EID  (DISPATCH_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Same signature as CMDMGR command functions
+*/
+typedef bool (*DISPATCH_MsgFunc_t)(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+typedef struct
+{
+
+   CFE_SB_MsgId_t      MsgId;
+   void                *ObjDataPtr;
+   DISPATCH_MsgFunc_t  MsgFunc;
+
+   uint32  RcvCnt;
+   uint32  ErrCnt;          /* Handler returned false */
+   uint64  TotalTimeUs;
+   uint32  MaxTimeUs;
+
+} DISPATCH_Entry_t;
+
+
+typedef struct
+{
+
+   CFE_SB_PipeId_t  Pipe;
+
+   uint16  EntryCnt;
+   uint32  UnknownMsgCnt;
+
+   uint8   HashTbl[DISPATCH_HASH_SLOTS];   /* Entry index+1, 0 indicates an empty slot */
+
+   DISPATCH_Entry_t  Entry[DISPATCH_MAX_ENTRIES];
+
+} DISPATCH_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: DISPATCH_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. The pipe must already be created.
+**
+*/
+void DISPATCH_Constructor(DISPATCH_Class_t *Dispatch, CFE_SB_PipeId_t Pipe);
+
+
+/******************************************************************************
+** Function: DISPATCH_GetStats
+**
+** Load up to MaxStats telemetry entries and return the number loaded.
+**
+** Notes:
+**   1. May be called from any task. The values are not an atomic snapshot.
+**
+*/
+uint16 DISPATCH_GetStats(const DISPATCH_Class_t *Dispatch, ASTRO_PI_DispatchStats_t *Stats, uint16 MaxStats);
+
+
+/******************************************************************************
+** Function: DISPATCH_ProcessMsg
+**
+** Call the handler registered for the message's MsgId.
+**
+** Notes:
+**   1. Returns false if no handler is registered for the MsgId. The caller
+**      is responsible for reporting the error.
+**
+*/
+bool DISPATCH_ProcessMsg(DISPATCH_Class_t *Dispatch, const CFE_SB_Buffer_t *SbBufPtr);
+
+
+/******************************************************************************
+** Function: DISPATCH_RegisterFunc
+**
+** Register a MsgId handler and subscribe the dispatcher's pipe to the MsgId.
+**
+** Notes:
+**   1. Returns false and sends an event if the table is full, the MsgId is
+**      already registered or the subscription fails.
+**
+*/
+bool DISPATCH_RegisterFunc(DISPATCH_Class_t *Dispatch, CFE_SB_MsgId_t MsgId,
+                           void *ObjDataPtr, DISPATCH_MsgFunc_t MsgFunc);
+
+
+/******************************************************************************
+** Function: DISPATCH_ResetStatus
+**
+** Reset counters to a known reset state. Registrations are not affected.
+**
+*/
+void DISPATCH_ResetStatus(DISPATCH_Class_t *Dispatch);
+
+
+#endif /* _dispatch_ */
@@ -0,0 +1,201 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Real input FFT power spectrum
+**
+** Notes:
+**   1. See fft.h for the algorithm.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <math.h>
+#include "fft.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define FFT_PI  3.14159265358979323846
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void ComplexFft(FFT_Class_t *Fft);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+
+/******************************************************************************
+** Function: FFT_Constructor
+**
+*/
+bool FFT_Constructor(FFT_Class_t *Fft, uint16 Len)
+{
+
+   uint16 Half = Len/2;
+   uint16 Bits = 0;
+   uint16 Rev;
+
+   memset(Fft, 0, sizeof(FFT_Class_t));
+
+   if (Len < FFT_MIN_LEN || Len > FFT_MAX_LEN || (Len & (Len-1)) != 0)
+   {
+      return false;
+   }
+
+   Fft->Len = Len;
+
+   for (uint16 k=0; k < Half; k++)
+   {
+      Fft->Cos[k] = (float)cos(2.0*FFT_PI*k/Len);
+      Fft->Sin[k] = (float)sin(2.0*FFT_PI*k/Len);
+   }
+
+   while ((1u << Bits) < Half)
+   {
+      Bits++;
+   }
+   for (uint16 i=0; i < Half; i++)
+   {
+      Rev = 0;
+      for (uint16 b=0; b < Bits; b++)
+      {
+         Rev |= ((i >> b) & 1) << (Bits-1-b);
+      }
+      Fft->BitRev[i] = Rev;
+   }
+
+   return true;
+
+} /* End FFT_Constructor() */
+
+
+/******************************************************************************
+** Function: FFT_RealPower
+**
+** Notes:
+**   1. With Z the N/2 point transform of z[n] = x[2n] + i*x[2n+1]:
+**        E[k] = (Z[k] + conj(Z[N/2-k]))/2        even sample spectrum
+**        O[k] = (Z[k] - conj(Z[N/2-k]))/(2i)     odd sample spectrum
+**        X[k] = E[k] + W^k*O[k], W = exp(-2*pi*i/N)
+**      Z[N/2] is Z[0].
+**
+*/
+void FFT_RealPower(FFT_Class_t *Fft, const float *In, float *Power)
+{
+
+   uint16 Half = Fft->Len/2;
+   uint16 j;
+   float  ZkRe, ZkIm, ZjRe, ZjIm;
+   float  ERe, EIm, ORe, OIm;
+   float  XRe, XIm;
+
+   for (uint16 n=0; n < Half; n++)
+   {
+      Fft->Re[Fft->BitRev[n]] = In[2*n];
+      Fft->Im[Fft->BitRev[n]] = In[2*n+1];
+   }
+
+   ComplexFft(Fft);
+
+   for (uint16 k=0; k <= Half; k++)
+   {
+
+      ZkRe = Fft->Re[k % Half];
+      ZkIm = Fft->Im[k % Half];
+      j    = (Half - k) % Half;
+      ZjRe = Fft->Re[j];
+      ZjIm = Fft->Im[j];
+
+      ERe = 0.5f*(ZkRe + ZjRe);
+      EIm = 0.5f*(ZkIm - ZjIm);
+      ORe = 0.5f*(ZkIm + ZjIm);
+      OIm = 0.5f*(ZjRe - ZkRe);
+
+      if (k < Half)
+      {
+         /* W^k = cos - i*sin */
+         XRe = ERe + Fft->Cos[k]*ORe + Fft->Sin[k]*OIm;
+         XIm = EIm + Fft->Cos[k]*OIm - Fft->Sin[k]*ORe;
+      }
+      else
+      {
+         /* W^(N/2) = -1 */
+         XRe = ERe - ORe;
+         XIm = EIm - OIm;
+      }
+
+      Power[k] = XRe*XRe + XIm*XIm;
+
+   } /* End split loop */
+
+} /* End FFT_RealPower() */
+
+
+/******************************************************************************
+** Function: ComplexFft
+**
+** In place radix-2 decimation in time FFT of the bit reversed Re[], Im[].
+**
+** Notes:
+**   1. A butterfly stage of width 2*Span uses W_(2*Span)^m which is
+**      W_N^(m*N/(2*Span)) so the stages index the N point tables with a
+**      stride of (N/2)/Span.
+**
+*/
+static void ComplexFft(FFT_Class_t *Fft)
+{
+
+   uint16 Half = Fft->Len/2;
+   uint16 Step;
+   float  WRe, WIm;
+   float  TRe, TIm;
+   uint16 Top, Bot;
+
+   for (uint16 Span=1; Span < Half; Span <<= 1)
+   {
+      Step = Half/Span;
+      for (uint16 m=0; m < Span; m++)
+      {
+         WRe =  Fft->Cos[m*Step];
+         WIm = -Fft->Sin[m*Step];
+         for (Top=m; Top < Half; Top += 2*Span)
+         {
+            Bot = Top + Span;
+            TRe = WRe*Fft->Re[Bot] - WIm*Fft->Im[Bot];
+            TIm = WRe*Fft->Im[Bot] + WIm*Fft->Re[Bot];
+            Fft->Re[Bot] = Fft->Re[Top] - TRe;
+            Fft->Im[Bot] = Fft->Im[Top] - TIm;
+            Fft->Re[Top] += TRe;
+            Fft->Im[Top] += TIm;
+         }
+      }
+   }
+
+} /* End ComplexFft() */
@@ -0,0 +1,96 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Real input FFT power spectrum
+**
+** Notes:
+**   1. A length N real sequence is transformed with an N/2 point complex
+**      radix-2 FFT of the even and odd samples followed by a split step
+**      that separates the two interleaved spectra.
+**   2. Twiddle factors, the bit reversal table and working buffers are in
+**      the class and sized for FFT_MAX_LEN so transforms don't allocate
+**      memory. Each task that computes transforms needs its own instance.
+**
+*/
+
+#ifndef _fft_
+#define _fft_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define FFT_MIN_LEN  8
+#define FFT_MAX_LEN  256   /* Must be a power of 2 */
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint16  Len;                         /* Real input length N */
+
+   float   Cos[FFT_MAX_LEN/2];          /* cos(2*pi*k/N) */
+   float   Sin[FFT_MAX_LEN/2];          /* sin(2*pi*k/N) */
+   uint16  BitRev[FFT_MAX_LEN/2];       /* N/2 point bit reversed indices */
+
+   float   Re[FFT_MAX_LEN/2];
+   float   Im[FFT_MAX_LEN/2];
+
+} FFT_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: FFT_Constructor
+**
+** Prepare the tables for length Len transforms.
+**
+** Notes:
+**   1. Returns false if Len isn't a power of 2 between FFT_MIN_LEN and
+**      FFT_MAX_LEN.
+**
+*/
+bool FFT_Constructor(FFT_Class_t *Fft, uint16 Len);
+
+
+/******************************************************************************
+** Function: FFT_RealPower
+**
+** Load Power[k] with |X[k]|^2 for k = 0..N/2 where X is the DFT of the N
+** real samples in In.
+**
+** Notes:
+**   1. Power must have room for N/2+1 values.
+**
+*/
+void FFT_RealPower(FFT_Class_t *Fft, const float *In, float *Power);
+
+
+#endif /* _fft_ */
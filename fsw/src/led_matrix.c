@@ -0,0 +1,281 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Stream frames to the Sense HAT's 8x8 LED matrix
+**
+** Notes:
+**   1. See led_matrix.h for the frame encoding.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stddef.h>
+#include "led_matrix.h"
+#include "diag.h"
+#include "py_script.h"
+#include "jmsg_lib_eds_typedefs.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static LED_MATRIX_Class_t *LedMatrix;
+
+/*
+** Frame report parameters in the order sent by the Pi
+*/
+static const struct
+{
+
+   size_t              Offset;
+   PKTUTIL_CSV_Type_t  Type;
+   uint16              Len;
+
+} FrameRptParam[LED_MATRIX_RPT_PARAMS] =
+{
+
+   { offsetof(ASTRO_PI_LedRemoteStats_t, FrameCnt),     PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(ASTRO_PI_LedRemoteStats_t, Fps),          PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN },
+   { offsetof(ASTRO_PI_LedRemoteStats_t, SeqErrCnt),    PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(ASTRO_PI_LedRemoteStats_t, DecodeErrCnt), PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN }
+
+};
+
+
+/******************************************************************************
+** Function: LED_MATRIX_Constructor
+**
+*/
+void LED_MATRIX_Constructor(LED_MATRIX_Class_t *LedMatrixPtr, INITBL_Class_t *IniTbl)
+{
+
+   LedMatrix = LedMatrixPtr;
+
+   memset(LedMatrix, 0, sizeof(LED_MATRIX_Class_t));
+
+   LedMatrix->KeyFrameInterval = INITBL_GetIntConfig(IniTbl, CFG_LED_MATRIX_KEY_FRAME_INTERVAL);
+
+   for (int i=0; i < LED_MATRIX_RPT_PARAMS; i++)
+   {
+      LedMatrix->FrameRpt.CsvEntry[i] = (PKTUTIL_CSV_Entry_t){ ((uint8 *)&LedMatrix->FrameRpt.Rpt) + FrameRptParam[i].Offset,
+                                                               FrameRptParam[i].Type, FrameRptParam[i].Len };
+   }
+
+} /* End LED_MATRIX_Constructor() */
+
+
+/******************************************************************************
+** Function: LED_MATRIX_GetStatus
+**
+*/
+void LED_MATRIX_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->LedMatrix = LedMatrix->Stats;
+
+} /* End LED_MATRIX_GetStatus() */
+
+
+/******************************************************************************
+** Function: LED_MATRIX_ProcessRpt
+**
+** Notes:
+**   1. The parameter text is copied because PktUtil_ParseCsvStr() modifies
+**      it and the SB buffer is shared with other subscribers.
+**   2. Reports are periodic so only the first parse error since a reset
+**      sends an event, later errors are only counted.
+**
+*/
+bool LED_MATRIX_ProcessRpt(const char *Name, const char *ParamText)
+{
+
+   LED_MATRIX_FrameRpt_t *FrameRpt = &LedMatrix->FrameRpt;
+   int CsvEntries;
+
+   if (strncmp(Name, LED_MATRIX_RPT_NAME, OS_MAX_API_NAME) != 0)
+   {
+      return false;
+   }
+
+   LedMatrix->Stats.RptCnt++;
+
+   strncpy(FrameRpt->ParamText, ParamText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+   FrameRpt->ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1] = '\0';
+
+   memset(&FrameRpt->Rpt, 0, sizeof(FrameRpt->Rpt));
+   CsvEntries = PktUtil_ParseCsvStr(FrameRpt->ParamText, FrameRpt->CsvEntry, LED_MATRIX_RPT_PARAMS);
+
+   if (CsvEntries == LED_MATRIX_RPT_PARAMS)
+   {
+      LedMatrix->Stats.Remote = FrameRpt->Rpt;
+   }
+   else
+   {
+      if (++LedMatrix->Stats.RptParseErrCnt == 1)
+      {
+         CFE_EVS_SendEvent(LED_MATRIX_RPT_EID, CFE_EVS_EventType_ERROR,
+                           "Incorrect number of LED frame report parameters. Received %d expected %d",
+                           CsvEntries, LED_MATRIX_RPT_PARAMS);
+      }
+   }
+
+   return true;
+
+} /* End LED_MATRIX_ProcessRpt() */
+
+
+/******************************************************************************
+** Function: LED_MATRIX_ResetStatus
+**
+*/
+void LED_MATRIX_ResetStatus(void)
+{
+
+   ASTRO_PI_LedRemoteStats_t Remote = LedMatrix->Stats.Remote;
+
+   memset(&LedMatrix->Stats, 0, sizeof(LedMatrix->Stats));
+   LedMatrix->Stats.Remote = Remote;
+
+   LedMatrix->PrevValid = false;
+
+} /* End LED_MATRIX_ResetStatus() */
+
+
+/******************************************************************************
+** Function: LED_MATRIX_SetFrameCmd
+**
+** Notes:
+**   1. Prev[] and the sequence number are only updated after the frame is
+**      sent so a failed send is followed by a delta from the frame the Pi
+**      last received.
+**   2. Events are rate limited by DIAG since frames may be commanded at
+**      animation rates.
+**
+*/
+bool LED_MATRIX_SetFrameCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const ASTRO_PI_SetLedFrame_CmdPayload_t *SetLedFrameCmd = CMDMGR_PAYLOAD_PTR(MsgPtr, ASTRO_PI_SetLedFrame_t);
+
+   ASTRO_PI_LedMatrixStats_t *Stats = &LedMatrix->Stats;
+   bool    FullFrame;
+   uint16  Pixel;
+   uint16  ChangedCnt = 0;
+   size_t  DataLen = 0;
+   size_t  TextLen;
+
+   Stats->FrameCnt++;
+
+   FullFrame = (!LedMatrix->PrevValid || LedMatrix->DeltaFrames >= LedMatrix->KeyFrameInterval);
+
+   /*
+   ** Build the delta while counting changed pixels. It's abandoned if it
+   ** reaches the full frame length.
+   */
+
+   for (int i=0; i < LED_MATRIX_PIXELS; i++)
+   {
+      Pixel = SetLedFrameCmd->Pixels[i];
+      if (Pixel != LedMatrix->Prev[i])
+      {
+         ChangedCnt++;
+         if (!FullFrame)
+         {
+            if (DataLen + LED_MATRIX_DELTA_ENTRY >= LED_MATRIX_FULL_LEN)
+            {
+               FullFrame = true;
+            }
+            else
+            {
+               LedMatrix->FrameData[DataLen++] = (uint8)i;
+               LedMatrix->FrameData[DataLen++] = (uint8)(Pixel >> 8);
+               LedMatrix->FrameData[DataLen++] = (uint8)(Pixel & 0xFF);
+            }
+         }
+      }
+   }
+   Stats->LastChangedPixels = ChangedCnt;
+
+   if (!FullFrame && ChangedCnt == 0)
+   {
+      Stats->UnchangedFrameCnt++;
+      return true;
+   }
+
+   if (FullFrame)
+   {
+      for (int i=0; i < LED_MATRIX_PIXELS; i++)
+      {
+         LedMatrix->FrameData[2*i]   = (uint8)(SetLedFrameCmd->Pixels[i] >> 8);
+         LedMatrix->FrameData[2*i+1] = (uint8)(SetLedFrameCmd->Pixels[i] & 0xFF);
+      }
+      DataLen = LED_MATRIX_FULL_LEN;
+   }
+
+   TextLen = snprintf(LedMatrix->FrameText, sizeof(LedMatrix->FrameText), "%s%u:",
+                      FullFrame ? LED_MATRIX_FULL_TEXT_PREFIX : LED_MATRIX_DELTA_TEXT_PREFIX,
+                      (unsigned int)LedMatrix->Seq);
+   TextLen += PY_SCRIPT_Base64Encode(LedMatrix->FrameData, DataLen, &LedMatrix->FrameText[TextLen]);
+
+   if (!PY_SCRIPT_SendText(LedMatrix->FrameText, TextLen))
+   {
+      Stats->SbErrCnt++;
+      if (DIAG_Count(DIAG_LED_FRAME_ERR))
+      {
+         CFE_EVS_SendEvent(LED_MATRIX_SET_FRAME_EID, CFE_EVS_EventType_ERROR,
+                           "LED frame %u not sent due to a Software Bus error", (unsigned int)LedMatrix->Seq);
+      }
+      return false;
+   }
+
+   memcpy(LedMatrix->Prev, SetLedFrameCmd->Pixels, sizeof(LedMatrix->Prev));
+   LedMatrix->PrevValid = true;
+   LedMatrix->Seq++;
+
+   if (FullFrame)
+   {
+      LedMatrix->DeltaFrames = 0;
+      Stats->FullFrameCnt++;
+   }
+   else
+   {
+      LedMatrix->DeltaFrames++;
+      Stats->DeltaFrameCnt++;
+   }
+
+   Stats->LastTextBytes = TextLen;
+   Stats->TextBytes    += TextLen;
+
+   return true;
+
+} /* End LED_MATRIX_SetFrameCmd() */
@@ -0,0 +1,186 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Stream frames to the Sense HAT's 8x8 LED matrix
+**
+** Notes:
+**   1. Frames are 64 RGB565 pixels in row major order. The Pi writes them
+**      straight to the matrix with set_pixels() so no script is compiled
+**      or run per frame.
+**   2. Only the pixels that changed since the last frame sent are sent. A
+**      delta frame is a list of 3 byte (pixel index, RGB565 big endian)
+**      entries. A full frame is sent when the delta wouldn't be smaller,
+**      for the first frame and every KeyFrameInterval frames so the Pi
+**      recovers from a lost frame. Unchanged frames aren't sent.
+**   3. Frames carry a 16 bit sequence number. The Pi ignores delta frames
+**      after a sequence gap until the next full frame.
+**   4. JMSG topics can't be added from this app so frames are sent with
+**      PY_SCRIPT_SendText() as script text starting with
+**      LED_MATRIX_FULL_TEXT_PREFIX or LED_MATRIX_DELTA_TEXT_PREFIX followed
+**      by "<seq>:<base64 frame data>". The Pi's frame rate is
+**      reported in CSV telemetry named LED_MATRIX_RPT_NAME that is
+**      processed by the Sense HAT ingest task.
+**
+*/
+
+#ifndef _led_matrix_
+#define _led_matrix_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_platform_eds_defines.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define LED_MATRIX_PIXELS        64
+#define LED_MATRIX_FULL_LEN      (2*LED_MATRIX_PIXELS)
+#define LED_MATRIX_DELTA_ENTRY   3
+
+#define LED_MATRIX_FULL_TEXT_PREFIX   "#led-full "
+#define LED_MATRIX_DELTA_TEXT_PREFIX  "#led-delta "
+
+#define LED_MATRIX_RPT_NAME     "led-status"   /* JMSG CSV 'name' of the Pi's frame report */
+#define LED_MATRIX_RPT_PARAMS   4
+
+/*
+** Frame text is the longer prefix, a sequence number, a colon and the
+** base64 frame data
+*/
+#define LED_MATRIX_TEXT_LEN  (sizeof(LED_MATRIX_DELTA_TEXT_PREFIX) + 6 + 4*((LED_MATRIX_FULL_LEN+2)/3) + 1)
+
+
+/*
+** Event Message IDs
+*/
+
+#define LED_MATRIX_CONSTRUCTOR_EID  (LED_MATRIX_BASE_EID + 0)
+#define LED_MATRIX_SET_FRAME_EID    (LED_MATRIX_BASE_EID + 1)
+#define LED_MATRIX_RPT_EID          (LED_MATRIX_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Pi frame report working storage. Only used by the Sense HAT ingest task.
+** PktUtil_ParseCsvStr() loads Rpt through CsvEntry[] and Rpt is only copied
+** to Stats.Remote when the whole report parses.
+*/
+typedef struct
+{
+
+   ASTRO_PI_LedRemoteStats_t  Rpt;
+   PKTUTIL_CSV_Entry_t  CsvEntry[LED_MATRIX_RPT_PARAMS];
+   char  ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+
+} LED_MATRIX_FrameRpt_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   uint16  KeyFrameInterval;      /* Max delta frames between full frames */
+
+   bool    PrevValid;             /* Prev[] holds the Pi's current frame */
+   uint16  DeltaFrames;           /* Delta frames since the last full frame */
+   uint16  Seq;
+   uint16  Prev[LED_MATRIX_PIXELS];
+
+   ASTRO_PI_LedMatrixStats_t  Stats;
+
+   /*
+   ** Command processing working buffers. Only used by the main task.
+   */
+
+   uint8  FrameData[LED_MATRIX_FULL_LEN];
+   char   FrameText[LED_MATRIX_TEXT_LEN];
+
+   LED_MATRIX_FrameRpt_t  FrameRpt;
+
+} LED_MATRIX_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: LED_MATRIX_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void LED_MATRIX_Constructor(LED_MATRIX_Class_t *LedMatrixPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: LED_MATRIX_GetStatus
+**
+** Load the LED matrix fields of the app's status telemetry payload.
+**
+*/
+void LED_MATRIX_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: LED_MATRIX_ProcessRpt
+**
+** Process a JMSG CSV telemetry message if it is the Pi's frame report.
+**
+** Notes:
+**   1. Returns true if the message was a frame report, even if it couldn't
+**      be parsed, so the caller doesn't process it as Sense HAT telemetry.
+**   2. Only called by the Sense HAT ingest task.
+**
+*/
+bool LED_MATRIX_ProcessRpt(const char *Name, const char *ParamText);
+
+
+/******************************************************************************
+** Function: LED_MATRIX_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. The Pi's frame counts are not reset since they're owned by the Pi.
+**   2. The next frame is sent as a full frame.
+**
+*/
+void LED_MATRIX_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: LED_MATRIX_SetFrameCmd
+**
+** Send a frame to the Pi's LED matrix.
+**
+*/
+bool LED_MATRIX_SetFrameCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+#endif /* _led_matrix_ */
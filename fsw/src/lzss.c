@@ -0,0 +1,174 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   LZSS compressor used to shrink scripts sent to the Pi
+**
+** Notes:
+**   1. See lzss.h for the compressed stream format.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "lzss.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define WINDOW_MASK  (LZSS_WINDOW_LEN-1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint32 Hash3(const uint8 *Data);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+
+/******************************************************************************
+** Function: LZSS_Compress
+**
+** Notes:
+**   1. Every input position that has LZSS_MIN_MATCH bytes following it is
+**      added to the hash chains, including positions covered by a match.
+**   2. A chain link may point at a position that has left the window. The
+**      search stops there since older links can't be closer.
+**
+*/
+size_t LZSS_Compress(LZSS_Class_t *Lzss, const uint8 *In, size_t InLen, uint8 *Out, size_t OutMax)
+{
+
+   size_t  InPos  = 0;
+   size_t  OutLen = 0;
+   size_t  FlagPos = 0;
+   uint8   FlagBit = 0;
+   size_t  MaxLen;
+   size_t  MatchLen;
+   size_t  BestLen;
+   size_t  BestDist;
+   size_t  Step;
+   int32   Cand;
+   uint32  Hash;
+   uint16  Chain;
+
+   for (uint32 i=0; i < LZSS_HASH_LEN; i++)
+   {
+      Lzss->Head[i] = -1;
+   }
+
+   while (InPos < InLen)
+   {
+
+      if (FlagBit == 0)
+      {
+         if (OutLen >= OutMax)
+         {
+            return 0;
+         }
+         FlagPos = OutLen;
+         Out[OutLen++] = 0;
+         FlagBit = 1;
+      }
+
+      BestLen  = 0;
+      BestDist = 0;
+      if (InPos + LZSS_MIN_MATCH <= InLen)
+      {
+         MaxLen = (InLen - InPos < LZSS_MAX_MATCH) ? InLen - InPos : LZSS_MAX_MATCH;
+         Cand   = Lzss->Head[Hash3(&In[InPos])];
+         Chain  = LZSS_MAX_CHAIN;
+         while (Cand >= 0 && (InPos - (size_t)Cand) < LZSS_WINDOW_LEN && Chain-- > 0)
+         {
+            for (MatchLen=0; MatchLen < MaxLen && In[Cand+MatchLen] == In[InPos+MatchLen]; MatchLen++);
+            if (MatchLen > BestLen)
+            {
+               BestLen  = MatchLen;
+               BestDist = InPos - (size_t)Cand;
+               if (MatchLen == MaxLen)
+               {
+                  break;
+               }
+            }
+            Cand = Lzss->Prev[Cand & WINDOW_MASK];
+         }
+      }
+
+      if (BestLen >= LZSS_MIN_MATCH)
+      {
+         if (OutLen + 2 > OutMax)
+         {
+            return 0;
+         }
+         Out[OutLen++] = (uint8)(BestDist & 0xFF);
+         Out[OutLen++] = (uint8)(((BestDist >> 8) << 4) | (BestLen - LZSS_MIN_MATCH));
+         Step = BestLen;
+      }
+      else
+      {
+         if (OutLen >= OutMax)
+         {
+            return 0;
+         }
+         Out[FlagPos] |= FlagBit;
+         Out[OutLen++] = In[InPos];
+         Step = 1;
+      }
+
+      for (; Step > 0; Step--, InPos++)
+      {
+         if (InPos + LZSS_MIN_MATCH <= InLen)
+         {
+            Hash = Hash3(&In[InPos]);
+            Lzss->Prev[InPos & WINDOW_MASK] = Lzss->Head[Hash];
+            Lzss->Head[Hash] = (int32)InPos;
+         }
+      }
+
+      FlagBit <<= 1;
+
+   } /* End while input */
+
+   return OutLen;
+
+} /* End LZSS_Compress() */
+
+
+/******************************************************************************
+** Function: Hash3
+**
+** Multiplicative hash of the next LZSS_MIN_MATCH bytes.
+**
+*/
+static uint32 Hash3(const uint8 *Data)
+{
+
+   uint32 Key = ((uint32)Data[0] << 16) | ((uint32)Data[1] << 8) | Data[2];
+
+   return (Key * 2654435761u) >> (32 - LZSS_HASH_BITS);
+
+} /* End Hash3() */
@@ -0,0 +1,91 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   LZSS compressor used to shrink scripts sent to the Pi
+**
+** Notes:
+**   1. The compressed stream is a sequence of groups. Each group is a flag
+**      byte followed by up to 8 items. Flag bits are used LSB first: a set
+**      bit is a literal byte and a clear bit is a 2 byte match. A match's
+**      first byte is the low 8 bits of the distance back to the match and
+**      the second byte's upper nibble is the distance's high 4 bits and
+**      the lower nibble is the match length minus LZSS_MIN_MATCH.
+**   2. The stream doesn't encode its length. The decoder must be told the
+**      uncompressed length.
+**   3. Matches are found with hash chains limited to LZSS_MAX_CHAIN links.
+**      The chain tables are in the class so compression doesn't allocate
+**      memory or use much stack.
+**   4. scripts/astro_pi.py has the matching decoder.
+**
+*/
+
+#ifndef _lzss_
+#define _lzss_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define LZSS_WINDOW_LEN  4096   /* Must be a power of 2, distances are 12 bits */
+#define LZSS_MIN_MATCH   3
+#define LZSS_MAX_MATCH   (LZSS_MIN_MATCH + 15)
+#define LZSS_HASH_BITS   12
+#define LZSS_HASH_LEN    (1 << LZSS_HASH_BITS)
+#define LZSS_MAX_CHAIN   32
+
+/*
+** Worst case compressed length of InLen bytes, every item is a literal
+*/
+#define LZSS_MAX_COMPRESSED_LEN(InLen)  ((InLen) + ((InLen)+7)/8)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   int32  Head[LZSS_HASH_LEN];     /* Most recent input position for each hash, -1 if none */
+   int32  Prev[LZSS_WINDOW_LEN];   /* Previous position with the same hash, indexed by position within the window */
+
+} LZSS_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: LZSS_Compress
+**
+** Compress InLen bytes from In to Out and return the compressed length.
+**
+** Notes:
+**   1. Returns 0 if the compressed data doesn't fit in OutMax bytes.
+**
+*/
+size_t LZSS_Compress(LZSS_Class_t *Lzss, const uint8 *In, size_t InLen, uint8 *Out, size_t OutMax);
+
+
+#endif /* _lzss_ */
@@ -24,6 +24,7 @@
 ** Includes
 */
 
+#include <stddef.h>
 #include "py_script.h"
 #include "jmsg_lib_eds_typedefs.h"
 #include "jmsg_platform_eds_defines.h"
@@ -42,8 +43,11 @@
 /** Local File Function Prototypes **/
 /************************************/
 
+static int32 ReadCompressedScriptFile(osal_id_t FileHandle);
 static int32 ReadScriptFile(osal_id_t FileHandle);
-static void SendScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *CmdText, uint16 CmdTextLen);
+static bool SendScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *CmdText, uint16 CmdTextLen);
+static size_t TransmitScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *ScriptFile, size_t ScriptFileLen,
+                                const char *ScriptText, size_t ScriptTextLen);
 
 
 /**********************/
@@ -52,32 +56,33 @@ static void SendScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *Cmd
 
 static PY_SCRIPT_Class_t *PyScript;
 
-static char ReadFileBuf[JMSG_PLATFORM_CHAR_BLOCK]; 
-static char ScriptFileBuf[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN+JMSG_PLATFORM_CHAR_BLOCK+256]; /* Allow one extra block to be read in case file too long. Extra bytes for escaped \n */
-
-static char DisplayHelloScript[] = "from sense_hat import SenseHat\\nsense = SenseHat()\\nsense.show_message('Hello world')\\n";
-static char PrintHelloScript[] = "print('Hello World')\\nprint('Hello Astro Pi')"; // \\nprint('Hello Astro Pi')
-
-static ASTRO_PI_SenseHatTlm_Payload_t SenseHatTlm; /* Working buffer for loads */
-static PKTUTIL_CSV_Entry_t JMsgCsvEntry[] = 
+/*
+** Script status report parameters in the order sent by the Pi
+*/
+static const size_t StatusRptOffset[PY_SCRIPT_STATUS_RPT_PARAMS] =
 {
-   
-   { &SenseHatTlm.RateX,       PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.RateY,       PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.RateZ,       PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.AccelX,      PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.AccelY,      PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.AccelZ,      PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.Pressure,    PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.Temperature, PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.Humidity,    PKTUTIL_CSV_FLOAT,   PKTUTIL_CSV_FLT_LEN},
-   { &SenseHatTlm.Red,         PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN},
-   { &SenseHatTlm.Green,       PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN},
-   { &SenseHatTlm.Blue,        PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN},
-   { &SenseHatTlm.Clear,       PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN}
+
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Running),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Queued),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Completed),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Failed),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Timeout),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Cancelled),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, Rejected),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, LastScriptId),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, CacheHits),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, CacheMisses),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, CacheEntries),
+   offsetof(ASTRO_PI_RemoteScriptStats_t, CompileTimeUs)
 
 };
 
+static const char Base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char DisplayHelloScript[] = "from sense_hat import SenseHat\\nsense = SenseHat()\\nsense.show_message('Hello world')\\n";
+static const char PrintHelloScript[] = "print('Hello World')\\nprint('Hello Astro Pi')"; // \\nprint('Hello Astro Pi')
+
+
 /******************************************************************************
 ** Function: PY_SCRIPT_Constructor
 **
@@ -87,7 +92,7 @@ static PKTUTIL_CSV_Entry_t JMsgCsvEntry[] =
 **   1. This must be called prior to any other member functions.
 **
 */
-void PY_SCRIPT_Constructor(PY_SCRIPT_Class_t *PyScriptPtr, uint32 TopicScriptCmdTopicId, uint32 SenseHatTlmTopicId)
+void PY_SCRIPT_Constructor(PY_SCRIPT_Class_t *PyScriptPtr, uint32 TopicScriptCmdTopicId)
 {
 
    PyScript = PyScriptPtr;
@@ -96,57 +101,224 @@ void PY_SCRIPT_Constructor(PY_SCRIPT_Class_t *PyScriptPtr, uint32 TopicScriptCmd
 
    strcpy(PyScript->LastSent, ASTRO_PI_UNDEF_TLM_STR);
    
-   CFE_MSG_Init(CFE_MSG_PTR(PyScript->TopicScriptCmd.TelemetryHeader), CFE_SB_ValueToMsgId(TopicScriptCmdTopicId),
-                sizeof(JMSG_LIB_TopicScriptCmd_t));
-
-   CFE_MSG_Init(CFE_MSG_PTR(PyScript->SenseHatTlm.TelemetryHeader), CFE_SB_ValueToMsgId(SenseHatTlmTopicId),
-                sizeof(ASTRO_PI_SenseHatTlm_t));
+   PyScript->TopicScriptCmdMid = CFE_SB_ValueToMsgId(TopicScriptCmdTopicId);
+   
+   for (int i=0; i < PY_SCRIPT_STATUS_RPT_PARAMS; i++)
+   {
+      PyScript->StatusRpt.CsvEntry[i] = (PKTUTIL_CSV_Entry_t){ ((uint8 *)&PyScript->StatusRpt.Rpt) + StatusRptOffset[i],
+                                                               PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN };
+   }
                 
 } /* End PY_SCRIPT_Constructor() */
 
 
 /******************************************************************************
-** Function: PY_SCRIPT_CreateSenseHatTlm
+** Function: PY_SCRIPT_Base64Encode
 **
-** Notes:
-**   1. Loads Sense Hat telemetry parameter fields from the JMSG and sends
-**      the Sense Hat message. The parameter order must match the
-**      ASTRO_PI_SenseHatTlmParams_Enum_t definition.
-**   2. The LocalPayload variable is needed because PktUtil_ParseCsvStr()
-**      modifies the CSV parameter text.
+*/
+size_t PY_SCRIPT_Base64Encode(const uint8 *In, size_t InLen, char *Out)
+{
+
+   size_t  OutLen = 0;
+   size_t  i;
+   uint32  Triple;
+
+   for (i=0; i+2 < InLen; i+=3)
+   {
+      Triple = ((uint32)In[i] << 16) | ((uint32)In[i+1] << 8) | In[i+2];
+      Out[OutLen++] = Base64Alphabet[(Triple >> 18) & 0x3F];
+      Out[OutLen++] = Base64Alphabet[(Triple >> 12) & 0x3F];
+      Out[OutLen++] = Base64Alphabet[(Triple >> 6) & 0x3F];
+      Out[OutLen++] = Base64Alphabet[Triple & 0x3F];
+   }
+
+   if (i < InLen)
+   {
+      Triple = (uint32)In[i] << 16;
+      if (i+1 < InLen)
+      {
+         Triple |= (uint32)In[i+1] << 8;
+      }
+      Out[OutLen++] = Base64Alphabet[(Triple >> 18) & 0x3F];
+      Out[OutLen++] = Base64Alphabet[(Triple >> 12) & 0x3F];
+      Out[OutLen++] = (i+1 < InLen) ? Base64Alphabet[(Triple >> 6) & 0x3F] : '=';
+      Out[OutLen++] = '=';
+   }
+
+   Out[OutLen] = '\0';
+
+   return OutLen;
+
+} /* End PY_SCRIPT_Base64Encode() */
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_Base64Decode
 **
 */
-bool PY_SCRIPT_CreateSenseHatTlm(const CFE_MSG_Message_t *JMsgCsvTlm)
+bool PY_SCRIPT_Base64Decode(const char *In, uint8 *Out, size_t OutMax, size_t *OutLen)
 {
-   
-   const JMSG_LIB_TopicCsvTlm_Payload_t *JMsgPayload = CMDMGR_PAYLOAD_PTR(JMsgCsvTlm, JMSG_LIB_TopicCsvTlm_t);   
 
-   bool   RetStatus = false;
-   int    CsvEntries;
-   JMSG_LIB_TopicCsvTlm_Payload_t LocalPayload;
-   
-   memcpy(&LocalPayload, JMsgPayload, sizeof(JMSG_LIB_TopicCsvTlm_Payload_t));
+   size_t  InLen = strlen(In);
+   size_t  Len = 0;
+   size_t  PadCnt = 0;
+   uint32  Quad;
+   const char *Char;
 
-   CsvEntries = PktUtil_ParseCsvStr(LocalPayload.ParamText, JMsgCsvEntry, ASTRO_PI_SenseHatTlmParams_Enum_t_MAX);
-   
-   if (CsvEntries == ASTRO_PI_SenseHatTlmParams_Enum_t_MAX)
+   *OutLen = 0;
+
+   if ((InLen % 4) != 0)
+   {
+      return false;
+   }
+
+   if (InLen > 0 && In[InLen-1] == '=')
    {
-      memcpy(&PyScript->SenseHatTlm.Payload, &SenseHatTlm,  sizeof(ASTRO_PI_SenseHatTlm_Payload_t));
-      CFE_SB_TimeStampMsg(CFE_MSG_PTR(PyScript->SenseHatTlm.TelemetryHeader));
-      CFE_SB_TransmitMsg(CFE_MSG_PTR(PyScript->SenseHatTlm.TelemetryHeader), true);
+      PadCnt = (In[InLen-2] == '=') ? 2 : 1;
+   }
+
+   if ((InLen/4)*3 - PadCnt > OutMax)
+   {
+      return false;
+   }
+
+   for (size_t i=0; i < InLen; i+=4)
+   {
+      Quad = 0;
+      for (int j=0; j < 4; j++)
+      {
+         Quad <<= 6;
+         if (In[i+j] == '=' && i+4 == InLen && j >= 4-(int)PadCnt)
+         {
+            continue;
+         }
+         Char = (In[i+j] != '\0') ? strchr(Base64Alphabet, In[i+j]) : NULL;
+         if (Char == NULL)
+         {
+            return false;
+         }
+         Quad |= (uint32)(Char - Base64Alphabet);
+      }
+      Out[Len++] = (uint8)(Quad >> 16);
+      if (i+4 < InLen || PadCnt < 2)
+      {
+         Out[Len++] = (uint8)(Quad >> 8);
+      }
+      if (i+4 < InLen || PadCnt < 1)
+      {
+         Out[Len++] = (uint8)Quad;
+      }
+   }
+
+   *OutLen = Len;
+
+   return true;
+
+} /* End PY_SCRIPT_Base64Decode() */
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_CancelCmd
+**
+*/
+bool PY_SCRIPT_CancelCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const ASTRO_PI_CancelScript_CmdPayload_t *CancelScriptCmd = CMDMGR_PAYLOAD_PTR(MsgPtr, ASTRO_PI_CancelScript_t);
+
+   bool  RetStatus = false;
+   char  CancelText[sizeof(PY_SCRIPT_CANCEL_TEXT_PREFIX)+12];
+
+   snprintf(CancelText, sizeof(CancelText), PY_SCRIPT_CANCEL_TEXT_PREFIX "%u", (unsigned int)CancelScriptCmd->ScriptId);
+
+   if (SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, CancelText, sizeof(CancelText)))
+   {
+      CFE_EVS_SendEvent(PY_SCRIPT_CANCEL_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                        "Sucessfully sent cancel request for script ID %u (0 = all scripts)",
+                        (unsigned int)CancelScriptCmd->ScriptId);
       RetStatus = true;
-      OS_printf("Sent sense hat telemetry\n");
-   } 
+   }
    else
    {
-      CFE_EVS_SendEvent(PY_SCRIPT_CREATE_SENSE_HAT_EID, CFE_EVS_EventType_ERROR, 
-                        "Incorrect number of sense hat parameters. Received %d expected %d", 
-                        CsvEntries, ASTRO_PI_SenseHatTlmParams_Enum_t_MAX);         
+      CFE_EVS_SendEvent(PY_SCRIPT_CANCEL_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Cancel script command failed. Software Bus error sending cancel request");
    }
-   
-   return RetStatus;  
-   
-} /* End PY_SCRIPT_CreateSenseHatTlm() */
+
+   return RetStatus;
+
+} /* End PY_SCRIPT_CancelCmd() */
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_GetStatus
+**
+*/
+void PY_SCRIPT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->SentScriptCnt       = PyScript->SentCnt;
+   Payload->ScriptSbErrCnt      = __atomic_load_n(&PyScript->SbErrCnt, __ATOMIC_RELAXED);
+   Payload->ScriptLastMsgLen    = PyScript->LastMsgLen;
+   Payload->ScriptMsgSbBytes      = PyScript->MsgSbBytes;
+   Payload->ScriptMsgSbBytesSaved = PyScript->MsgSbBytesSaved;
+   Payload->ScriptLastFileBytes      = PyScript->LastFileBytes;
+   Payload->ScriptLastTextBytes      = PyScript->LastTextBytes;
+   Payload->ScriptLastCompressTimeUs = PyScript->LastCompressTimeUs;
+   strncpy(Payload->LastSentScript, PyScript->LastSent, OS_MAX_PATH_LEN);
+
+   Payload->ScriptStatusRptCnt         = PyScript->StatusRpt.RptCnt;
+   Payload->ScriptStatusRptParseErrCnt = PyScript->StatusRpt.RptParseErrCnt;
+   Payload->RemoteScript               = PyScript->Remote;
+
+} /* End PY_SCRIPT_GetStatus() */
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_ProcessStatusRpt
+**
+** Notes:
+**   1. The parameter text is copied because PktUtil_ParseCsvStr() modifies
+**      it and the SB buffer is shared with other subscribers.
+**   2. Reports are periodic so only the first parse error since a reset
+**      sends an event, later errors are only counted.
+**
+*/
+bool PY_SCRIPT_ProcessStatusRpt(const char *Name, const char *ParamText)
+{
+
+   PY_SCRIPT_StatusRpt_t *StatusRpt = &PyScript->StatusRpt;
+   int CsvEntries;
+
+   if (strncmp(Name, PY_SCRIPT_STATUS_RPT_NAME, OS_MAX_API_NAME) != 0)
+   {
+      return false;
+   }
+
+   StatusRpt->RptCnt++;
+
+   strncpy(StatusRpt->ParamText, ParamText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+   StatusRpt->ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1] = '\0';
+
+   memset(&StatusRpt->Rpt, 0, sizeof(StatusRpt->Rpt));
+   CsvEntries = PktUtil_ParseCsvStr(StatusRpt->ParamText, StatusRpt->CsvEntry, PY_SCRIPT_STATUS_RPT_PARAMS);
+
+   if (CsvEntries == PY_SCRIPT_STATUS_RPT_PARAMS)
+   {
+      PyScript->Remote = StatusRpt->Rpt;
+   }
+   else
+   {
+      if (++StatusRpt->RptParseErrCnt == 1)
+      {
+         CFE_EVS_SendEvent(PY_SCRIPT_STATUS_RPT_EID, CFE_EVS_EventType_ERROR,
+                           "Incorrect number of script status parameters. Received %d expected %d",
+                           CsvEntries, PY_SCRIPT_STATUS_RPT_PARAMS);
+      }
+   }
+
+   return true;
+
+} /* End PY_SCRIPT_ProcessStatusRpt() */
 
 
 /******************************************************************************
@@ -154,16 +326,83 @@ bool PY_SCRIPT_CreateSenseHatTlm(const CFE_MSG_Message_t *JMsgCsvTlm)
 **
 ** Reset counters and status flags to a known reset state.
 **
+** Notes:
+**   1. The Pi's script counts are not reset since they're owned by the Pi.
+**
 */
 void PY_SCRIPT_ResetStatus(void)
 {
 
-   PyScript->SentCnt = 0;
+   PyScript->SentCnt  = 0;
+   __atomic_store_n(&PyScript->SbErrCnt, 0, __ATOMIC_RELAXED);
+   PyScript->LastMsgLen    = 0;
+   PyScript->MsgSbBytes      = 0;
+   PyScript->MsgSbBytesSaved = 0;
+   PyScript->LastFileBytes      = 0;
+   PyScript->LastTextBytes      = 0;
+   PyScript->PeakScriptFileBytes = 0;
+   PyScript->PeakRawFileBytes    = 0;
+   PyScript->LastCompressTimeUs = 0;
+   PyScript->StatusRpt.RptCnt         = 0;
+   PyScript->StatusRpt.RptParseErrCnt = 0;
    strcpy(PyScript->LastSent, ASTRO_PI_UNDEF_TLM_STR);
    
 } /* End PY_SCRIPT_ResetStatus() */
 
 
+/******************************************************************************
+** Function: PY_SCRIPT_RestoreState
+**
+*/
+void PY_SCRIPT_RestoreState(const PY_SCRIPT_SavedState_t *State)
+{
+
+   PyScript->SentCnt  = State->SentCnt;
+   PyScript->SbErrCnt = State->SbErrCnt;
+   PyScript->LastMsgLen    = State->LastMsgLen;
+   PyScript->MsgSbBytes      = State->MsgSbBytes;
+   PyScript->MsgSbBytesSaved = State->MsgSbBytesSaved;
+   PyScript->LastFileBytes      = State->LastFileBytes;
+   PyScript->LastTextBytes      = State->LastTextBytes;
+   PyScript->LastCompressTimeUs = State->LastCompressTimeUs;
+   PyScript->StatusRpt.RptCnt         = State->StatusRptCnt;
+   PyScript->StatusRpt.RptParseErrCnt = State->StatusRptParseErrCnt;
+   strncpy(PyScript->LastSent, State->LastSent, OS_MAX_PATH_LEN-1);
+   PyScript->LastSent[OS_MAX_PATH_LEN-1] = '\0';
+
+   PyScript->Remote = State->Remote;
+
+} /* End PY_SCRIPT_RestoreState() */
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_SaveState
+**
+** Notes:
+**   1. The Pi's script status is written by the Sense HAT ingest task. Like
+**      the status telemetry, the copy may mix two consecutive reports.
+**
+*/
+void PY_SCRIPT_SaveState(PY_SCRIPT_SavedState_t *State)
+{
+
+   State->SentCnt  = PyScript->SentCnt;
+   State->SbErrCnt = __atomic_load_n(&PyScript->SbErrCnt, __ATOMIC_RELAXED);
+   State->LastMsgLen    = PyScript->LastMsgLen;
+   State->MsgSbBytes      = PyScript->MsgSbBytes;
+   State->MsgSbBytesSaved = PyScript->MsgSbBytesSaved;
+   State->LastFileBytes      = PyScript->LastFileBytes;
+   State->LastTextBytes      = PyScript->LastTextBytes;
+   State->LastCompressTimeUs = PyScript->LastCompressTimeUs;
+   State->StatusRptCnt         = PyScript->StatusRpt.RptCnt;
+   State->StatusRptParseErrCnt = PyScript->StatusRpt.RptParseErrCnt;
+   memcpy(State->LastSent, PyScript->LastSent, OS_MAX_PATH_LEN);
+
+   State->Remote = PyScript->Remote;
+
+} /* End PY_SCRIPT_SaveState() */
+
+
 /******************************************************************************
 ** Function: PY_SCRIPT_SendLocalCmd
 **
@@ -191,17 +430,35 @@ bool PY_SCRIPT_SendLocalCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
       if (SysStatus == OS_SUCCESS)
       {
          /*
-         ** ReadScriptFile() - Loads ScriptFileBuf[] & returns number of bytes read 
-         ** SendScriptMsg()  - Loads tlm msg payload & assumes SB success 
+         ** ReadScriptFile()           - Loads ScriptFileBuf[] & returns number of bytes read 
+         ** ReadCompressedScriptFile() - Loads ScriptFileBuf[] with the encoded compressed file
+         ** SendScriptMsg()            - Loads tlm msg payload & returns false if SB fails
          */
-         FileBytesRead = ReadScriptFile(FileHandle);
+         if (SendLocalScriptCmd->Encoding == ASTRO_PI_ScriptEncoding_LZSS_BASE64)
+         {
+            FileBytesRead = ReadCompressedScriptFile(FileHandle);
+         }
+         else
+         {
+            FileBytesRead = ReadScriptFile(FileHandle);
+         }
          if (FileBytesRead >= 0)
          { 
-            SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, ScriptFileBuf, FileBytesRead);
-            strncpy(PyScript->LastSent,SendLocalScriptCmd->Filename,OS_MAX_PATH_LEN);
-            CFE_EVS_SendEvent(PY_SCRIPT_SEND_LOCAL_CMD_EID, CFE_EVS_EventType_INFORMATION,
-                              "Sucessfully sent script %s", PyScript->LastSent);
-            RetStatus = true;
+            if (SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, PyScript->ScriptFileBuf, FileBytesRead))
+            {
+               strncpy(PyScript->LastSent,SendLocalScriptCmd->Filename,OS_MAX_PATH_LEN);
+               PyScript->LastTextBytes = FileBytesRead-1;
+               CFE_EVS_SendEvent(PY_SCRIPT_SEND_LOCAL_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                                 "Sucessfully sent script %s. %u file bytes sent as %u script text bytes",
+                                 PyScript->LastSent, (unsigned int)PyScript->LastFileBytes,
+                                 (unsigned int)PyScript->LastTextBytes);
+               RetStatus = true;
+            }
+            else
+            {
+               CFE_EVS_SendEvent(PY_SCRIPT_SEND_LOCAL_CMD_EID, CFE_EVS_EventType_ERROR,
+                                 "Send script command failed. Error sending %s", SendLocalScriptCmd->Filename);
+            }
          }
          else
          {
@@ -237,25 +494,50 @@ bool PY_SCRIPT_SendTestCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
 {
    const ASTRO_PI_SendTestScript_CmdPayload_t *SendTestScriptCmd = CMDMGR_PAYLOAD_PTR(MsgPtr, ASTRO_PI_SendTestScript_t);
 
+   bool        RetStatus;
+   const char  *ScriptName;
+
    if (SendTestScriptCmd->Script == ASTRO_PI_TestScript_PRINT_HELLO)
    {
-      SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, PrintHelloScript, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);
-      strncpy(PyScript->LastSent,"Print Hello World test script",OS_MAX_PATH_LEN); 
+      RetStatus  = SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, PrintHelloScript, sizeof(PrintHelloScript));
+      ScriptName = "Print Hello World test script";
    }
    else
    {
-      SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, DisplayHelloScript, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);
-      strncpy(PyScript->LastSent,"Display Hello World test script",OS_MAX_PATH_LEN); 
+      RetStatus  = SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, DisplayHelloScript, sizeof(DisplayHelloScript));
+      ScriptName = "Display Hello World test script";
    }
    
-   CFE_EVS_SendEvent(PY_SCRIPT_SEND_TEST_CMD_EID, CFE_EVS_EventType_INFORMATION,
-                     "Sucessfully sent %s", PyScript->LastSent);
+   if (RetStatus)
+   {
+      strncpy(PyScript->LastSent,ScriptName,OS_MAX_PATH_LEN); 
+      CFE_EVS_SendEvent(PY_SCRIPT_SEND_TEST_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                        "Sucessfully sent %s", PyScript->LastSent);
+   }
+   else
+   {
+      CFE_EVS_SendEvent(PY_SCRIPT_SEND_TEST_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Send test script command failed. Software Bus error sending %s", ScriptName);
+   }
 
-   return true;
+   return RetStatus;
       
 } /* End PY_SCRIPT_SendTestCmd() */
 
 
+/******************************************************************************
+** Function: PY_SCRIPT_SendText
+**
+*/
+bool PY_SCRIPT_SendText(const char *Text, size_t Len)
+{
+
+   return (TransmitScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT, ASTRO_PI_UNDEF_TLM_STR, OS_MAX_PATH_LEN-1,
+                             Text, strnlen(Text, Len)) > 0);
+
+} /* End PY_SCRIPT_SendText() */
+
+
 /******************************************************************************
 ** Function: PY_SCRIPT_StartRemoteCmd
 **
@@ -270,11 +552,18 @@ bool PY_SCRIPT_StartRemoteCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
    
    if (FileUtil_VerifyFilenameStr(StartRemoteScriptCmd->Filename))
    {
-      SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_FILE, StartRemoteScriptCmd->Filename, OS_MAX_PATH_LEN);
-      strncpy(PyScript->LastSent,StartRemoteScriptCmd->Filename,OS_MAX_PATH_LEN);
-      CFE_EVS_SendEvent(PY_SCRIPT_START_REMOTE_CMD_EID, CFE_EVS_EventType_INFORMATION,
-                        "Sucessfully sent start remote script %s", PyScript->LastSent);
-      RetStatus = true;
+      if (SendScriptMsg(JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_FILE, StartRemoteScriptCmd->Filename, OS_MAX_PATH_LEN))
+      {
+         strncpy(PyScript->LastSent,StartRemoteScriptCmd->Filename,OS_MAX_PATH_LEN);
+         CFE_EVS_SendEvent(PY_SCRIPT_START_REMOTE_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                           "Sucessfully sent start remote script %s", PyScript->LastSent);
+         RetStatus = true;
+      }
+      else
+      {
+         CFE_EVS_SendEvent(PY_SCRIPT_START_REMOTE_CMD_EID, CFE_EVS_EventType_ERROR,
+                           "Start remote script command failed. Software Bus error sending %s", StartRemoteScriptCmd->Filename);
+      }
    }
    else
    {
@@ -287,11 +576,114 @@ bool PY_SCRIPT_StartRemoteCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
 } /* End PY_SCRIPT_StartRemoteCmd() */
 
 
+/******************************************************************************
+** Function: ReadCompressedScriptFile
+**
+** Load ScriptFileBuf[] with PY_SCRIPT_LZB64_TEXT_PREFIX followed by the file
+** length and the base64 encoded LZSS compressed file contents.
+**
+** Notes:
+**   1. Returns the script text length including the terminator or -1 if the
+**      file can't be read or the encoded text is too long. Event messages
+**      are issued for error cases.
+**   2. Carriage returns are removed. Linefeeds don't need to be escaped
+**      since they're inside the compressed data.
+**   3. The compression time includes the base64 encoding.
+**
+*/
+static int32 ReadCompressedScriptFile(osal_id_t FileHandle)
+{
+
+   int32   RetStatus = -1;
+   int32   FileBytesRead;
+   uint32  TotalBytesRead = 0;
+   uint32  RawLen = 0;
+   size_t  CompressedLen;
+   size_t  TextLen;
+   int     PrefixLen;
+   OS_time_t      StartTime;
+   OS_time_t      EndTime;
+   os_err_name_t  OsErrStr;
+
+   do
+   {
+      FileBytesRead = OS_read(FileHandle, &PyScript->RawFileBuf[TotalBytesRead], JMSG_PLATFORM_CHAR_BLOCK);
+      if (FileBytesRead > 0)
+      {
+         TotalBytesRead += FileBytesRead;
+      }
+   } while (FileBytesRead == JMSG_PLATFORM_CHAR_BLOCK && TotalBytesRead <= PY_SCRIPT_RAW_FILE_MAX_LEN);
+
+   OS_close(FileHandle);
+
+   if (TotalBytesRead > PyScript->PeakRawFileBytes)
+   {
+      PyScript->PeakRawFileBytes = TotalBytesRead;
+   }
+
+   if (FileBytesRead < 0)
+   {
+      OS_GetErrorName(FileBytesRead, &OsErrStr);
+      CFE_EVS_SendEvent(PY_SCRIPT_READ_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Error reading contents of script file. Status = %s", OsErrStr);
+      return RetStatus;
+   }
+
+   if (TotalBytesRead > PY_SCRIPT_RAW_FILE_MAX_LEN)
+   {
+      CFE_EVS_SendEvent(PY_SCRIPT_READ_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Compressed script file length greater than %d bytes", PY_SCRIPT_RAW_FILE_MAX_LEN);
+      return RetStatus;
+   }
+
+   for (uint32 i=0; i < TotalBytesRead; i++)
+   {
+      if (PyScript->RawFileBuf[i] != '\r')
+      {
+         PyScript->RawFileBuf[RawLen++] = PyScript->RawFileBuf[i];
+      }
+   }
+
+   OS_GetLocalTime(&StartTime);
+
+   CompressedLen = LZSS_Compress(&PyScript->Lzss, PyScript->RawFileBuf, RawLen,
+                                 PyScript->CompressBuf, PY_SCRIPT_COMPRESS_BUF_LEN);
+   PrefixLen = snprintf(PyScript->ScriptFileBuf, sizeof(PyScript->ScriptFileBuf),
+                        PY_SCRIPT_LZB64_TEXT_PREFIX "%u:", (unsigned int)RawLen);
+
+   if ((RawLen > 0 && CompressedLen == 0) ||
+       (PrefixLen + 4*((CompressedLen+2)/3)) >= JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
+   {
+      CFE_EVS_SendEvent(PY_SCRIPT_READ_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Compressed script text length greater than %d characters", JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);
+      return RetStatus;
+   }
+
+   TextLen = PrefixLen + PY_SCRIPT_Base64Encode(PyScript->CompressBuf, CompressedLen, &PyScript->ScriptFileBuf[PrefixLen]);
+
+   OS_GetLocalTime(&EndTime);
+
+   PyScript->LastFileBytes      = TotalBytesRead;
+   PyScript->LastCompressTimeUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+
+   RetStatus = (int32)TextLen + 1;
+   if ((uint32)RetStatus > PyScript->PeakScriptFileBytes)
+   {
+      PyScript->PeakScriptFileBytes = RetStatus;
+   }
+
+   return RetStatus;
+
+} /* End ReadCompressedScriptFile() */
+
+
 /******************************************************************************
 ** Function: ReadScriptFile
 **
 ** Notes:
 **   1. Event messages are issued for error cases.
+**   2. Line feeds are escaped so the text limit applies to the escaped
+**      length. Files longer than the limit are rejected, not truncated.
 **
 */
 static int32 ReadScriptFile(osal_id_t FileHandle)
@@ -299,14 +691,15 @@ static int32 ReadScriptFile(osal_id_t FileHandle)
 
    int32   RetStatus = -1;
    bool    ReadFile  = true;
-   char    *ScriptFileBufPtr = ScriptFileBuf;
-   uint16  DeltaChars = 0;
+   char    *ReadFileBuf = PyScript->ReadFileBuf;
+   char    *ScriptFileBufPtr = PyScript->ScriptFileBuf;
    int32   FileBytesRead;
    uint16  TotalBytesRead = 0;
+   size_t  TextLen = 0;
    os_err_name_t OsErrStr;
                                 
-   memset(ReadFileBuf, 0, sizeof(ReadFileBuf));
-   memset(ScriptFileBuf, 0, sizeof(ScriptFileBuf));
+   memset(PyScript->ReadFileBuf, 0, sizeof(PyScript->ReadFileBuf));
+   memset(PyScript->ScriptFileBuf, 0, sizeof(PyScript->ScriptFileBuf));
    
    while (ReadFile)
    {      
@@ -339,34 +732,36 @@ static int32 ReadScriptFile(osal_id_t FileHandle)
                   ScriptFileBufPtr++;
                   *ScriptFileBufPtr = 'n'; 
                   ScriptFileBufPtr++;               
-                  DeltaChars++;
                }
             }
-            else
-            {
-               DeltaChars--;
-            }
          }
+         TextLen = ScriptFileBufPtr - PyScript->ScriptFileBuf;
 
          if (FileBytesRead < JMSG_PLATFORM_CHAR_BLOCK)
          {
             ReadFile = false;
          }         
 
-         if (TotalBytesRead+DeltaChars > JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
+         if (TextLen >= JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
          {
             ReadFile = false;
             CFE_EVS_SendEvent(PY_SCRIPT_READ_FILE_EID, CFE_EVS_EventType_ERROR,
-                              "Script file length greater than %d characters", JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);
+                              "Script text length with escaped line feeds greater than %d characters", JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
          }
       } /* End if valid file read */
       
    } /* End read file loop */
 
    *ScriptFileBufPtr = '\0'; 
-   if (TotalBytesRead <= JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
+   if ((uint32)(TextLen+1) > PyScript->PeakScriptFileBytes)
+   {
+      PyScript->PeakScriptFileBytes = TextLen+1;
+   }
+   if (TextLen < JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
    {
-      RetStatus = TotalBytesRead+DeltaChars+1;
+      RetStatus = TextLen+1;
+      PyScript->LastFileBytes      = TotalBytesRead;
+      PyScript->LastCompressTimeUs = 0;
    }
    
    OS_close(FileHandle);   
@@ -381,34 +776,104 @@ static int32 ReadScriptFile(osal_id_t FileHandle)
 **
 ** Notes:
 **   1. Loads script message fields and sets unused fields to defaults 
-**   2. Assume valid command passed and SB calls are successful
+**   2. CmdTextLen is the maximum length of CmdText, not its string length.
+**   3. Assumes a valid command. Returns false if the script text is too
+**      long or an SB call fails.
+**   4. MsgSbBytesSaved is measured against a full length SB message. The
+**      JMSG library encodes the message for the Pi so the bytes saved on
+**      the wire aren't known here.
 **
 */
-static void SendScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *CmdText, uint16 CmdTextLen)
+static bool SendScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *CmdText, uint16 CmdTextLen)
 {
 
-   JMSG_LIB_TopicScriptCmd_Payload_t *Payload = &PyScript->TopicScriptCmd.Payload;
-   
-   Payload->Command = Command;
-
-   memset(Payload->ScriptFile, 0, OS_MAX_PATH_LEN);
-   memset(Payload->ScriptText, 0, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);
+   size_t  MsgLen;
    
    if (Command == JMSG_LIB_ExecScriptCmd_RUN_SCRIPT_TEXT)
    {
-      strncpy(Payload->ScriptFile, ASTRO_PI_UNDEF_TLM_STR, OS_MAX_PATH_LEN);
-      strncpy(Payload->ScriptText, CmdText, CmdTextLen);
+      MsgLen = TransmitScriptMsg(Command, ASTRO_PI_UNDEF_TLM_STR, OS_MAX_PATH_LEN-1, CmdText,
+                                 strnlen(CmdText, CmdTextLen));
    }
    else
    {
-      strncpy(Payload->ScriptFile, CmdText, CmdTextLen);
-      strncpy(Payload->ScriptText, ASTRO_PI_UNDEF_TLM_STR, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN);      
+      MsgLen = TransmitScriptMsg(Command, CmdText, CmdTextLen < OS_MAX_PATH_LEN ? CmdTextLen : OS_MAX_PATH_LEN-1,
+                                 ASTRO_PI_UNDEF_TLM_STR, strlen(ASTRO_PI_UNDEF_TLM_STR));
    }
    
-   CFE_SB_TimeStampMsg(CFE_MSG_PTR(PyScript->TopicScriptCmd.TelemetryHeader));
-   CFE_SB_TransmitMsg(CFE_MSG_PTR(PyScript->TopicScriptCmd.TelemetryHeader), true);
+   if (MsgLen == 0)
+   {
+      return false;
+   }
    
    PyScript->SentCnt++;
+   PyScript->LastMsgLen       = MsgLen;
+   PyScript->MsgSbBytes      += MsgLen;
+   PyScript->MsgSbBytesSaved += sizeof(JMSG_LIB_TopicScriptCmd_t) - MsgLen;
 
+   return true;
+   
 } /* End SendScriptMsg() */
 
+
+/******************************************************************************
+** Function: TransmitScriptMsg
+**
+** Notes:
+**   1. The message is built in an SB buffer and sent with a zero copy
+**      transmit. CFE_MSG_Init() zeroes the buffer so string fields are
+**      always terminated.
+**   2. ScriptText is the last payload field so the message is trimmed to
+**      end at the script text's terminator. ScriptTextLen is the text's
+**      string length.
+**   3. Returns the message length or zero if the script text is too long
+**      or an SB call fails. Text is rejected rather than truncated since a
+**      truncated script or control message would be misread by the Pi. SB
+**      failures are counted atomically since PY_SCRIPT_SendText() callers
+**      run in other tasks.
+**
+*/
+static size_t TransmitScriptMsg(JMSG_LIB_ExecScriptCmd_Enum_t Command, const char *ScriptFile, size_t ScriptFileLen,
+                                const char *ScriptText, size_t ScriptTextLen)
+{
+
+   CFE_SB_Buffer_t                   *SbBufPtr;
+   JMSG_LIB_TopicScriptCmd_t         *TopicScriptCmd;
+   JMSG_LIB_TopicScriptCmd_Payload_t *Payload;
+   size_t  MsgLen;
+   
+   if (ScriptTextLen >= JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
+   {
+      CFE_EVS_SendEvent(PY_SCRIPT_SEND_MSG_EID, CFE_EVS_EventType_ERROR,
+                        "Script message rejected. Script text has %u characters, the limit is %d",
+                        (unsigned int)ScriptTextLen, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+      return 0;
+   }
+
+   MsgLen = offsetof(JMSG_LIB_TopicScriptCmd_t, Payload.ScriptText) + ScriptTextLen + 1;
+   
+   SbBufPtr = CFE_SB_AllocateMessageBuffer(MsgLen);
+   if (SbBufPtr == NULL)
+   {
+      __atomic_fetch_add(&PyScript->SbErrCnt, 1, __ATOMIC_RELAXED);
+      return 0;
+   }
+   
+   TopicScriptCmd = (JMSG_LIB_TopicScriptCmd_t *)SbBufPtr;
+   Payload = &TopicScriptCmd->Payload;
+   CFE_MSG_Init(CFE_MSG_PTR(TopicScriptCmd->TelemetryHeader), PyScript->TopicScriptCmdMid, MsgLen);
+   
+   Payload->Command = Command;
+   strncpy(Payload->ScriptFile, ScriptFile, ScriptFileLen);
+   memcpy(Payload->ScriptText, ScriptText, ScriptTextLen);
+   
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(TopicScriptCmd->TelemetryHeader));
+   if (CFE_SB_TransmitBuffer(SbBufPtr, true) != CFE_SUCCESS)
+   {
+      CFE_SB_ReleaseMessageBuffer(SbBufPtr);
+      __atomic_fetch_add(&PyScript->SbErrCnt, 1, __ATOMIC_RELAXED);
+      return 0;
+   }
+
+   return MsgLen;
+   
+} /* End TransmitScriptMsg() */
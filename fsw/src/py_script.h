@@ -16,7 +16,17 @@
 **   Manage sending python scripts to the Astro Pi  
 **
 ** Notes:
-**   None
+**   1. Script messages are built directly in SB allocated buffers and sent
+**      with zero copy transmits.
+**   2. Script messages are variable length. The message size ends at the
+**      script text's terminator so the JMSG translation and UDP layers only
+**      move the bytes that are used.
+**   3. The Pi runs scripts on a pool of workers and periodically sends a
+**      JMSG CSV telemetry message named PY_SCRIPT_STATUS_RPT_NAME with its
+**      script counts. The Sense HAT ingest task receives the CSV topic and
+**      passes these reports to PY_SCRIPT_ProcessStatusRpt(). The cancel
+**      request is sent as script text that starts with a python comment so
+**      older Pi endpoints ignore it.
 **
 */
 
@@ -28,6 +38,7 @@
 */
 
 #include "app_cfg.h"
+#include "lzss.h"
 #include "jmsg_platform_eds_defines.h"
 #include "jmsg_lib_eds_interface.h"
 
@@ -35,6 +46,18 @@
 /** Macro Definitions **/
 /***********************/
 
+#define PY_SCRIPT_STATUS_RPT_NAME     "script-status"   /* JMSG CSV 'name' of the Pi's script status report */
+#define PY_SCRIPT_STATUS_RPT_PARAMS   12
+#define PY_SCRIPT_CANCEL_TEXT_PREFIX  "#cancel "
+#define PY_SCRIPT_LZB64_TEXT_PREFIX   "#lzb64:"          /* Followed by "<file bytes>:<base64 LZSS data>" */
+
+/*
+** Compressed script buffers. A compressed script file can be larger than the
+** script text field since only its base64 encoding has to fit.
+*/
+#define PY_SCRIPT_RAW_FILE_MAX_LEN    (4*JMSG_PLATFORM_TOPIC_STRING_MAX_LEN)
+#define PY_SCRIPT_COMPRESS_BUF_LEN    ((JMSG_PLATFORM_TOPIC_STRING_MAX_LEN/4)*3)
+
 
 /*
 ** Event Message IDs
@@ -44,7 +67,9 @@
 #define PY_SCRIPT_SEND_LOCAL_CMD_EID    (PY_SCRIPT_BASE_EID + 1)
 #define PY_SCRIPT_SEND_TEST_CMD_EID     (PY_SCRIPT_BASE_EID + 2)
 #define PY_SCRIPT_START_REMOTE_CMD_EID  (PY_SCRIPT_BASE_EID + 3)
-#define PY_SCRIPT_CREATE_SENSE_HAT_EID  (PY_SCRIPT_BASE_EID + 4)
+#define PY_SCRIPT_CANCEL_CMD_EID        (PY_SCRIPT_BASE_EID + 4)
+#define PY_SCRIPT_STATUS_RPT_EID        (PY_SCRIPT_BASE_EID + 5)
+#define PY_SCRIPT_SEND_MSG_EID          (PY_SCRIPT_BASE_EID + 6)
 
 
 /**********************/
@@ -52,15 +77,81 @@
 /**********************/
 
 
+/*
+** Remote script status report working storage. Only used by the Sense HAT
+** ingest task. PktUtil_ParseCsvStr() loads Rpt through CsvEntry[] and Rpt
+** is only copied to Remote when the whole report parses.
+*/
+typedef struct
+{
+
+   uint32  RptCnt;
+   uint32  RptParseErrCnt;
+
+   ASTRO_PI_RemoteScriptStats_t  Rpt;
+   PKTUTIL_CSV_Entry_t  CsvEntry[PY_SCRIPT_STATUS_RPT_PARAMS];
+   char  ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+
+} PY_SCRIPT_StatusRpt_t;
+
+
+/*
+** Counters and the Pi's latest script status kept in the app's Critical Data
+** Store so they survive a warm restart
+*/
+typedef struct
+{
+
+   uint32  SentCnt;
+   uint32  SbErrCnt;
+   uint16  LastMsgLen;
+   uint32  MsgSbBytes;
+   uint32  MsgSbBytesSaved;
+   uint32  LastFileBytes;
+   uint32  LastTextBytes;
+   uint32  LastCompressTimeUs;
+   uint32  StatusRptCnt;
+   uint32  StatusRptParseErrCnt;
+   char    LastSent[OS_MAX_PATH_LEN];
+
+   ASTRO_PI_RemoteScriptStats_t  Remote;
+
+} PY_SCRIPT_SavedState_t;
+
+
 typedef struct
 {
    
-   JMSG_LIB_TopicScriptCmd_t  TopicScriptCmd;
-   ASTRO_PI_SenseHatTlm_t     SenseHatTlm;
+   CFE_SB_MsgId_t  TopicScriptCmdMid;
    
    uint32   SentCnt;
+   uint32   SbErrCnt;       /* SB failures for all script topic messages, written atomically */
+   uint16   LastMsgLen;       /* SB length of the last script message sent */
+   uint32   MsgSbBytes;       /* Total SB length of the script messages sent */
+   uint32   MsgSbBytesSaved;  /* SB bytes saved by trimming messages, not the JMSG wire saving */
+   uint32   LastFileBytes;       /* Size of the last local script file sent */
+   uint32   LastTextBytes;       /* Script text bytes used to send the last local script file */
+   uint32   LastCompressTimeUs;  /* Zero if the last local script wasn't compressed */
+   uint32   PeakScriptFileBytes; /* ScriptFileBuf[] high-water mark since the last reset */
+   uint32   PeakRawFileBytes;    /* RawFileBuf[] high-water mark since the last reset */
    char     LastSent[OS_MAX_PATH_LEN];
 
+   /*
+   ** Command processing working buffers. Only used by the main task.
+   */
+   
+   char  ReadFileBuf[JMSG_PLATFORM_CHAR_BLOCK]; 
+   char  ScriptFileBuf[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN+JMSG_PLATFORM_CHAR_BLOCK+256]; /* Allow one extra block to be read in case file too long. Extra bytes for escaped \n */
+   uint8 RawFileBuf[PY_SCRIPT_RAW_FILE_MAX_LEN+JMSG_PLATFORM_CHAR_BLOCK];  /* Allow one extra block to be read in case file too long */
+   uint8 CompressBuf[PY_SCRIPT_COMPRESS_BUF_LEN];
+   LZSS_Class_t  Lzss;
+
+   /*
+   ** Latest script status reported by the Pi
+   */
+   
+   ASTRO_PI_RemoteScriptStats_t  Remote;
+   PY_SCRIPT_StatusRpt_t         StatusRpt;
 
 } PY_SCRIPT_Class_t;
 
@@ -77,19 +168,72 @@ typedef struct
 **   1. This must be called prior to any other member functions.
 **
 */
-void PY_SCRIPT_Constructor(PY_SCRIPT_Class_t *PyScriptPtr, uint32 TopicScriptCmdTopicId, uint32 SenseHatTlmTopicId);
+void PY_SCRIPT_Constructor(PY_SCRIPT_Class_t *PyScriptPtr, uint32 TopicScriptCmdTopicId);
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_Base64Encode
+**
+** Encode InLen bytes as null terminated base64 text and return the text
+** length.
+**
+** Notes:
+**   1. Out must have room for 4*((InLen+2)/3)+1 characters.
+**   2. Doesn't use the object's data so it may be called from any task.
+**
+*/
+size_t PY_SCRIPT_Base64Encode(const uint8 *In, size_t InLen, char *Out);
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_Base64Decode
+**
+** Decode null terminated base64 text into at most OutMax bytes.
+**
+** Notes:
+**   1. Returns false if the text length isn't a multiple of 4, the text has
+**      a character outside the base64 alphabet or padding before its end,
+**      or the decoded data is longer than OutMax.
+**   2. Doesn't use the object's data so it may be called from any task.
+**
+*/
+bool PY_SCRIPT_Base64Decode(const char *In, uint8 *Out, size_t OutMax, size_t *OutLen);
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_CancelCmd
+**
+** Request the Pi to cancel a running or queued script.
+**
+** Notes:
+**   1. A script ID of zero cancels all scripts.
+**
+*/
+bool PY_SCRIPT_CancelCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
 
 
 /******************************************************************************
-** Function: PY_SCRIPT_CreateSenseHatTlm
+** Function: PY_SCRIPT_GetStatus
+**
+** Load the script fields of the app's status telemetry payload.
+**
+*/
+void PY_SCRIPT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_ProcessStatusRpt
+**
+** Process a JMSG CSV telemetry message if it is a script status report.
 **
 ** Notes:
-**   1. Loads Sense Hat telemetry parameters fields from the JMsg and sends
-**      the Sense Hat message. The order of parameters must match the
-**      ASTRO_PI_SenseHatTlmParams_Enum_t definition.
+**   1. Returns true if the message was a script status report, even if it
+**      couldn't be parsed, so the caller doesn't process it as Sense HAT
+**      telemetry.
+**   2. Only called by the Sense HAT ingest task.
 **
 */
-bool PY_SCRIPT_CreateSenseHatTlm(const CFE_MSG_Message_t *JMsgScriptTlm);
+bool PY_SCRIPT_ProcessStatusRpt(const char *Name, const char *ParamText);
 
 
 /******************************************************************************
@@ -101,6 +245,27 @@ bool PY_SCRIPT_CreateSenseHatTlm(const CFE_MSG_Message_t *JMsgScriptTlm);
 void PY_SCRIPT_ResetStatus(void);
 
 
+/******************************************************************************
+** Function: PY_SCRIPT_RestoreState
+**
+** Restore the state saved by PY_SCRIPT_SaveState().
+**
+** Notes:
+**   1. Only called during app initialization before the child tasks start.
+**
+*/
+void PY_SCRIPT_RestoreState(const PY_SCRIPT_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: PY_SCRIPT_SaveState
+**
+** Copy the state that's preserved across warm restarts into State.
+**
+*/
+void PY_SCRIPT_SaveState(PY_SCRIPT_SavedState_t *State);
+
+
 /******************************************************************************
 ** Function: PY_SCRIPT_SendLocalCmd
 **
@@ -115,6 +280,21 @@ bool PY_SCRIPT_SendLocalCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
 bool PY_SCRIPT_SendTestCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
 
 
+/******************************************************************************
+** Function: PY_SCRIPT_SendText
+**
+** Send Text to the Pi in a script text message.
+**
+** Notes:
+**   1. Used by the objects that share the script topic with their own text
+**      protocols. Len is the maximum length of Text, not its string length.
+**   2. May be called from any task. SB failures are counted in the script
+**      SB error counter, the caller's own send counters aren't touched.
+**
+*/
+bool PY_SCRIPT_SendText(const char *Text, size_t Len);
+
+
 /******************************************************************************
 ** Function: PY_SCRIPT_StartRemoteCmd
 **
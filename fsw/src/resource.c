@@ -0,0 +1,196 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Account for the CPU time and stack used by each of the app's tasks
+**
+** Notes:
+**   1. See resource.h for the accounting design.
+**   2. Stacks are assumed to grow down, which is true for every processor
+**      the app runs on.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "resource.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static RESOURCE_Class_t *Resource;
+
+
+/******************************************************************************
+** Function: RESOURCE_Constructor
+**
+** Notes:
+**   1. The child task stack sizes are the ones they are created with. The
+**      main task's size is read from ES, it's left zero if that fails.
+**
+*/
+void RESOURCE_Constructor(RESOURCE_Class_t *ResourcePtr, INITBL_Class_t *IniTbl)
+{
+
+   int32             SysStatus;
+   CFE_ES_TaskId_t   TaskId;
+   CFE_ES_TaskInfo_t TaskInfo;
+
+   Resource = ResourcePtr;
+
+   memset(Resource, 0, sizeof(RESOURCE_Class_t));
+
+   Resource->Task[ASTRO_PI_ResourceTask_INGEST].StackSize      = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_INGEST_CHILD_STACK_SIZE);
+   Resource->Task[ASTRO_PI_ResourceTask_PUBLISH].StackSize     = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_PUB_CHILD_STACK_SIZE);
+   Resource->Task[ASTRO_PI_ResourceTask_SPECTRUM].StackSize    = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_CHILD_STACK_SIZE);
+   Resource->Task[ASTRO_PI_ResourceTask_SCRIPT_SYNC].StackSize = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_CHILD_STACK_SIZE);
+
+   SysStatus = CFE_ES_GetTaskID(&TaskId);
+   if (SysStatus == CFE_SUCCESS)
+   {
+      SysStatus = CFE_ES_GetTaskInfo(&TaskInfo, TaskId);
+   }
+   if (SysStatus == CFE_SUCCESS)
+   {
+      Resource->Task[ASTRO_PI_ResourceTask_MAIN].StackSize = (uint32)TaskInfo.StackSize;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(RESOURCE_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Error reading the main task's stack size. Status = 0x%08X", (unsigned int)SysStatus);
+   }
+
+   OS_GetLocalTime(&Resource->LastUsageTime);
+
+} /* End RESOURCE_Constructor() */
+
+
+/******************************************************************************
+** Function: RESOURCE_BeginWork
+**
+*/
+void RESOURCE_BeginWork(uint16 Task)
+{
+
+   OS_GetLocalTime(&Resource->Task[Task].StartTime);
+
+} /* End RESOURCE_BeginWork() */
+
+
+/******************************************************************************
+** Function: RESOURCE_EndWork
+**
+*/
+void RESOURCE_EndWork(uint16 Task)
+{
+
+   RESOURCE_Task_t *TaskPtr = &Resource->Task[Task];
+   OS_time_t  EndTime;
+   uint32     WorkUs;
+
+   OS_GetLocalTime(&EndTime);
+   WorkUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, TaskPtr->StartTime));
+
+   __atomic_store_n(&TaskPtr->BusyUs, TaskPtr->BusyUs + WorkUs, __ATOMIC_RELAXED);
+   __atomic_store_n(&TaskPtr->WorkCnt, TaskPtr->WorkCnt + 1, __ATOMIC_RELAXED);
+   if (WorkUs > TaskPtr->MaxBusyUs)
+   {
+      __atomic_store_n(&TaskPtr->MaxBusyUs, WorkUs, __ATOMIC_RELAXED);
+   }
+
+} /* End RESOURCE_EndWork() */
+
+
+/******************************************************************************
+** Function: RESOURCE_GetTaskUsage
+**
+** Notes:
+**   1. The work time since the last call is the difference of the free
+**      running BusyUs values, which is correct across a wrap as long as
+**      calls are less than 71 minutes apart.
+**
+*/
+void RESOURCE_GetTaskUsage(ASTRO_PI_ResourceTlm_Payload_t *Payload)
+{
+
+   RESOURCE_Task_t *TaskPtr;
+   OS_time_t  Now;
+   uint32     PeriodUs;
+   uint32     BusyUs;
+   uint32     DeltaUs;
+   uint16     i;
+
+   OS_GetLocalTime(&Now);
+   PeriodUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(Now, Resource->LastUsageTime));
+   Resource->LastUsageTime = Now;
+   Resource->PeriodMs = PeriodUs / 1000;
+
+   Payload->PeriodMs = Resource->PeriodMs;
+
+   for (i=0; i < RESOURCE_TASKS; i++)
+   {
+
+      TaskPtr = &Resource->Task[i];
+
+      BusyUs  = __atomic_load_n(&TaskPtr->BusyUs, __ATOMIC_RELAXED);
+      DeltaUs = BusyUs - TaskPtr->LastBusyUs;
+      TaskPtr->LastBusyUs   = BusyUs;
+      TaskPtr->TotalBusyUs += DeltaUs;
+
+      Payload->Task[i].Task      = i;
+      Payload->Task[i].BusyPct   = (PeriodUs > 0) ? (100.0f * (float)DeltaUs / (float)PeriodUs) : 0.0f;
+      Payload->Task[i].BusyMs    = (uint32)(TaskPtr->TotalBusyUs / 1000);
+      Payload->Task[i].MaxBusyUs = __atomic_load_n(&TaskPtr->MaxBusyUs, __ATOMIC_RELAXED);
+      Payload->Task[i].WorkCnt   = __atomic_load_n(&TaskPtr->WorkCnt, __ATOMIC_RELAXED);
+      Payload->Task[i].StackSize = TaskPtr->StackSize;
+
+   }
+
+} /* End RESOURCE_GetTaskUsage() */
+
+
+/******************************************************************************
+** Function: RESOURCE_ResetStatus
+**
+*/
+void RESOURCE_ResetStatus(void)
+{
+
+   uint16 i;
+
+   for (i=0; i < RESOURCE_TASKS; i++)
+   {
+      __atomic_store_n(&Resource->Task[i].WorkCnt, 0, __ATOMIC_RELAXED);
+      __atomic_store_n(&Resource->Task[i].MaxBusyUs, 0, __ATOMIC_RELAXED);
+   }
+
+} /* End RESOURCE_ResetStatus() */
@@ -0,0 +1,163 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Account for the CPU time used by each of the app's tasks
+**
+** Notes:
+**   1. OSAL doesn't provide a task's CPU time, so each task measures the
+**      time it spends working. A task calls RESOURCE_BeginWork() when its
+**      blocking receive, queue wait or semaphore take returns and
+**      RESOURCE_EndWork() before it blocks again. Preemption by higher
+**      priority tasks is counted as work so BusyPct is an upper bound.
+**   2. OSAL doesn't provide a task's stack base or high-water mark so
+**      only the configured stack size is reported. Use the OS's stack
+**      checking to size stacks.
+**   3. Each task only writes its own slot. The work time totals are
+**      32-bit and written atomically so the main task can read them while
+**      the child tasks run.
+**   4. Per message handler times are in the dispatch telemetry and buffer
+**      and queue peaks are kept by the objects that own them.
+**
+*/
+
+#ifndef _resource_
+#define _resource_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/*
+** Event Message IDs
+*/
+
+#define RESOURCE_CONSTRUCTOR_EID  (RESOURCE_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   /*
+   ** Written by the slot's task
+   */
+
+   uint32     BusyUs;       /* Free running, wraps */
+   uint32     WorkCnt;
+   uint32     MaxBusyUs;
+   OS_time_t  StartTime;
+
+   /*
+   ** Main task accounting
+   */
+
+   uint32     StackSize;
+   uint32     LastBusyUs;   /* BusyUs at the last RESOURCE_GetTaskUsage() */
+   uint64     TotalBusyUs;
+
+} RESOURCE_Task_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   OS_time_t  LastUsageTime;
+   uint32     PeriodMs;      /* Time between the last two RESOURCE_GetTaskUsage() calls */
+
+   RESOURCE_Task_t  Task[RESOURCE_TASKS];
+
+} RESOURCE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: RESOURCE_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Must be called by the main task before the child tasks are started.
+**
+*/
+void RESOURCE_Constructor(RESOURCE_Class_t *ResourcePtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: RESOURCE_BeginWork
+**
+** Start timing a task's work.
+**
+** Notes:
+**   1. Task is an ASTRO_PI_ResourceTask_Enum_t and must be the caller's.
+**   2. The first call sets the task's stack depth reference so it must be
+**      called from the task's loop function.
+**
+*/
+void RESOURCE_BeginWork(uint16 Task);
+
+
+/******************************************************************************
+** Function: RESOURCE_EndWork
+**
+** Add the time since RESOURCE_BeginWork() to a task's work time.
+**
+*/
+void RESOURCE_EndWork(uint16 Task);
+
+
+/******************************************************************************
+** Function: RESOURCE_GetTaskUsage
+**
+** Load the task usage array of the resource telemetry payload.
+**
+** Notes:
+**   1. Only called by the main task. BusyPct covers the time since the
+**      previous call.
+**
+*/
+void RESOURCE_GetTaskUsage(ASTRO_PI_ResourceTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: RESOURCE_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. The work time totals and sampled stack depths are kept.
+**
+*/
+void RESOURCE_ResetStatus(void);
+
+
+#endif /* _resource_ */
@@ -0,0 +1,193 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Lock-free single-producer/single-consumer queue of decoded Sense HAT
+**   samples used to hand samples between child task stages
+**
+** Notes:
+**   1. The producer stores Head then loads Tail and the consumer stores
+**      Tail then loads Head, both sequentially consistent. At least one of
+**      them observes the other's store so a consumer can't sleep on a
+**      queue that the producer saw as non-empty.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "sample_queue.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Constructor
+**
+*/
+bool SAMPLE_QUEUE_Constructor(SAMPLE_QUEUE_Class_t *SampleQueue, const char *SemName)
+{
+
+   memset(SampleQueue, 0, sizeof(SAMPLE_QUEUE_Class_t));
+
+   return (OS_CountSemCreate(&SampleQueue->WakeSem, SemName, 0, 0) == OS_SUCCESS);
+
+} /* End SAMPLE_QUEUE_Constructor() */
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_GetStats
+**
+*/
+void SAMPLE_QUEUE_GetStats(const SAMPLE_QUEUE_Class_t *SampleQueue, ASTRO_PI_SampleQueueStats_t *Stats)
+{
+
+   uint32 Head = __atomic_load_n(&SampleQueue->Head, __ATOMIC_RELAXED);
+   uint32 Tail = __atomic_load_n(&SampleQueue->Tail, __ATOMIC_RELAXED);
+
+   Stats->Depth     = Head - Tail;
+   Stats->PeakDepth = SampleQueue->PeakDepth;
+   Stats->PushCnt   = SampleQueue->PushCnt;
+   Stats->DropCnt   = SampleQueue->DropCnt;
+
+} /* End SAMPLE_QUEUE_GetStats() */
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Pop
+**
+*/
+uint32 SAMPLE_QUEUE_Pop(SAMPLE_QUEUE_Class_t *SampleQueue, SAMPLE_QUEUE_Entry_t *EntryBuf, uint32 MaxEntries)
+{
+
+   uint32 Tail = SampleQueue->Tail;
+   uint32 Head = __atomic_load_n(&SampleQueue->Head, __ATOMIC_ACQUIRE);
+   uint32 PopCnt = Head - Tail;
+
+   if (PopCnt > MaxEntries)
+   {
+      PopCnt = MaxEntries;
+   }
+
+   for (uint32 i=0; i < PopCnt; i++)
+   {
+      EntryBuf[i] = SampleQueue->Entry[(Tail+i) & SAMPLE_QUEUE_MASK];
+   }
+
+   if (PopCnt > 0)
+   {
+      __atomic_store_n(&SampleQueue->Tail, Tail+PopCnt, __ATOMIC_SEQ_CST);
+      SampleQueue->PopCnt += PopCnt;
+   }
+
+   return PopCnt;
+
+} /* End SAMPLE_QUEUE_Pop() */
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Push
+**
+*/
+bool SAMPLE_QUEUE_Push(SAMPLE_QUEUE_Class_t *SampleQueue, const SAMPLE_QUEUE_Entry_t *Entry)
+{
+
+   uint32 Head  = SampleQueue->Head;
+   uint32 Depth = Head - __atomic_load_n(&SampleQueue->Tail, __ATOMIC_ACQUIRE);
+
+   if (__atomic_exchange_n(&SampleQueue->ResetRequest, 0, __ATOMIC_ACQUIRE))
+   {
+      SampleQueue->PushCnt   = 0;
+      SampleQueue->DropCnt   = 0;
+      SampleQueue->PeakDepth = 0;
+   }
+
+   if (Depth >= SAMPLE_QUEUE_DEPTH)
+   {
+      SampleQueue->DropCnt++;
+      return false;
+   }
+
+   SampleQueue->Entry[Head & SAMPLE_QUEUE_MASK] = *Entry;
+   __atomic_store_n(&SampleQueue->Head, Head+1, __ATOMIC_SEQ_CST);
+
+   SampleQueue->PushCnt++;
+   if (Depth >= SampleQueue->PeakDepth)
+   {
+      SampleQueue->PeakDepth = Depth + 1;
+   }
+
+   /* Only wake the consumer if it had drained the queue */
+   if (__atomic_load_n(&SampleQueue->Tail, __ATOMIC_SEQ_CST) == Head)
+   {
+      OS_CountSemGive(SampleQueue->WakeSem);
+   }
+
+   return true;
+
+} /* End SAMPLE_QUEUE_Push() */
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_ResetStatus
+**
+** Notes:
+**   1. The counters are reset by the producer's next SAMPLE_QUEUE_Push().
+**
+*/
+void SAMPLE_QUEUE_ResetStatus(SAMPLE_QUEUE_Class_t *SampleQueue)
+{
+
+   __atomic_store_n(&SampleQueue->ResetRequest, 1, __ATOMIC_RELEASE);
+
+} /* End SAMPLE_QUEUE_ResetStatus() */
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Wait
+**
+** Notes:
+**   1. Extra semaphore counts from wakeups that were not needed cause an
+**      early return with an empty queue which callers must tolerate.
+**
+*/
+bool SAMPLE_QUEUE_Wait(SAMPLE_QUEUE_Class_t *SampleQueue, uint32 TimeoutMs)
+{
+
+   if (__atomic_load_n(&SampleQueue->Head, __ATOMIC_SEQ_CST) == SampleQueue->Tail)
+   {
+      OS_CountSemTimedWait(SampleQueue->WakeSem, TimeoutMs);
+   }
+
+   return (__atomic_load_n(&SampleQueue->Head, __ATOMIC_ACQUIRE) != SampleQueue->Tail);
+
+} /* End SAMPLE_QUEUE_Wait() */
@@ -0,0 +1,172 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Lock-free single-producer/single-consumer queue of decoded Sense HAT
+**   samples used to hand samples between child task stages
+**
+** Notes:
+**   1. Exactly one task may push and exactly one task may pop. Head is only
+**      written by the producer and Tail is only written by the consumer.
+**      They are kept on separate cache lines to avoid false sharing.
+**   2. Head and Tail are free running counters. The queue depth must be a
+**      power of 2 so the entry index is a mask of the counter.
+**   3. The counting semaphore is only used to wake a consumer that found the
+**      queue empty. The producer only gives it when its push made the queue
+**      non-empty so a steady stream of samples costs no OS calls.
+**   4. GCC/Clang __atomic builtins are used for the index loads and stores.
+**   5. The producer's counters are only written by the producer. A status
+**      reset from another task sets ResetRequest and the producer clears
+**      the counters on its next push.
+**
+*/
+
+#ifndef _sample_queue_
+#define _sample_queue_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SAMPLE_QUEUE_CACHE_LINE  64
+#define SAMPLE_QUEUE_MASK        (SAMPLE_QUEUE_DEPTH-1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   ASTRO_PI_SenseHatTlm_Payload_t  Payload;
+   CFE_TIME_SysTime_t  RcvTime;
+   uint32  SeqCount;
+   int16   SourceIdx;
+
+} SAMPLE_QUEUE_Entry_t;
+
+
+typedef struct
+{
+
+   uint8   LeadPad[SAMPLE_QUEUE_CACHE_LINE];
+
+   /*
+   ** Producer owned
+   */
+
+   uint32  Head;
+   uint32  PushCnt;
+   uint32  DropCnt;
+   uint32  PeakDepth;
+   uint32  ResetRequest;   /* Set by SAMPLE_QUEUE_ResetStatus(), cleared by the producer */
+   uint8   ProducerPad[SAMPLE_QUEUE_CACHE_LINE-5*sizeof(uint32)];
+
+   /*
+   ** Consumer owned
+   */
+
+   uint32  Tail;
+   uint32  PopCnt;
+   uint8   ConsumerPad[SAMPLE_QUEUE_CACHE_LINE-2*sizeof(uint32)];
+
+   osal_id_t  WakeSem;
+
+   SAMPLE_QUEUE_Entry_t Entry[SAMPLE_QUEUE_DEPTH];
+
+} SAMPLE_QUEUE_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Constructor
+**
+** Notes:
+**   1. Returns false if the wake semaphore can't be created.
+**
+*/
+bool SAMPLE_QUEUE_Constructor(SAMPLE_QUEUE_Class_t *SampleQueue, const char *SemName);
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_GetStats
+**
+** Load a telemetry snapshot of the queue's counters.
+**
+** Notes:
+**   1. May be called from any task. The values are not an atomic snapshot.
+**
+*/
+void SAMPLE_QUEUE_GetStats(const SAMPLE_QUEUE_Class_t *SampleQueue, ASTRO_PI_SampleQueueStats_t *Stats);
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Pop
+**
+** Copy up to MaxEntries from the queue into EntryBuf.
+**
+** Notes:
+**   1. Consumer only. Returns the number of entries copied.
+**
+*/
+uint32 SAMPLE_QUEUE_Pop(SAMPLE_QUEUE_Class_t *SampleQueue, SAMPLE_QUEUE_Entry_t *EntryBuf, uint32 MaxEntries);
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Push
+**
+** Notes:
+**   1. Producer only. Returns false and counts a drop if the queue is full.
+**
+*/
+bool SAMPLE_QUEUE_Push(SAMPLE_QUEUE_Class_t *SampleQueue, const SAMPLE_QUEUE_Entry_t *Entry);
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_ResetStatus
+**
+** Notes:
+**   1. Only resets the telemetry counters, queued entries are not affected.
+**   2. May be called by any task. The producer resets its counters on its
+**      next push so the counts seen until then are the old ones.
+**
+*/
+void SAMPLE_QUEUE_ResetStatus(SAMPLE_QUEUE_Class_t *SampleQueue);
+
+
+/******************************************************************************
+** Function: SAMPLE_QUEUE_Wait
+**
+** Pend until the queue is not empty or the timeout expires.
+**
+** Notes:
+**   1. Consumer only. Returns true if the queue is not empty.
+**
+*/
+bool SAMPLE_QUEUE_Wait(SAMPLE_QUEUE_Class_t *SampleQueue, uint32 TimeoutMs);
+
+
+#endif /* _sample_queue_ */
@@ -0,0 +1,351 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Request Sense HAT samples from the Pi on scheduler ticks
+**
+** Notes:
+**   1. See sample_sync.h for the request and latency definitions.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stddef.h>
+#include "sample_sync.h"
+#include "diag.h"
+#include "py_script.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define REQ_SLOT_MASK  (SAMPLE_SYNC_REQ_SLOTS-1)
+
+#define REQ_TEXT_LEN   (sizeof(SAMPLE_SYNC_TEXT_PREFIX) + 10)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint16 GetMode(void);
+static bool SendReqMsg(uint32 ReqId);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SAMPLE_SYNC_Class_t *SampleSync;
+
+CompileTimeAssert((SAMPLE_SYNC_REQ_SLOTS & REQ_SLOT_MASK) == 0, SAMPLE_SYNC_REQ_SLOTS_NotPowerOf2);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_Constructor
+**
+*/
+void SAMPLE_SYNC_Constructor(SAMPLE_SYNC_Class_t *SampleSyncPtr, INITBL_Class_t *IniTbl)
+{
+
+   SampleSync = SampleSyncPtr;
+
+   memset(SampleSync, 0, sizeof(SAMPLE_SYNC_Class_t));
+
+   SampleSync->Mode      = INITBL_GetIntConfig(IniTbl, CFG_SAMPLE_SYNC_MODE);
+   SampleSync->NextReqId = 1;
+
+} /* End SAMPLE_SYNC_Constructor() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_GetStatus
+**
+*/
+void SAMPLE_SYNC_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   ASTRO_PI_SampleSyncStats_t *Stats = &SampleSync->Stats;
+
+   Stats->Mode = GetMode();
+   Stats->AvgLatencyUs = (Stats->RspCnt > 0) ? (uint32)(SampleSync->LatencySumUs / Stats->RspCnt) : 0;
+
+   Payload->SampleSync = *Stats;
+
+} /* End SAMPLE_SYNC_GetStatus() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_ProcessSample
+**
+** Notes:
+**   1. An answer that doesn't match an outstanding request is a duplicate,
+**      an answer to a request that has left the ring or an answer sent
+**      before the mode was changed to FREE_RUN.
+**
+*/
+bool SAMPLE_SYNC_ProcessSample(const char *Name, uint32 SeqCount, CFE_TIME_SysTime_t RcvTime)
+{
+
+   ASTRO_PI_SampleSyncStats_t *Stats = &SampleSync->Stats;
+   SAMPLE_SYNC_Req_t  *Req = &SampleSync->Req[SeqCount & REQ_SLOT_MASK];
+   CFE_TIME_SysTime_t Latency;
+   uint32  LatencyUs;
+
+   if (strncmp(Name, SAMPLE_SYNC_RSP_NAME, sizeof(SAMPLE_SYNC_RSP_NAME)) != 0)
+   {
+      return false;
+   }
+
+   if (GetMode() != ASTRO_PI_SampleMode_SCHEDULED)
+   {
+      return true;
+   }
+
+   if (SeqCount == 0 || __atomic_load_n(&Req->ReqId, __ATOMIC_ACQUIRE) != SeqCount ||
+       __atomic_exchange_n(&Req->Answered, true, __ATOMIC_ACQ_REL))
+   {
+      Stats->UnmatchedRspCnt++;
+      return true;
+   }
+
+   Latency   = CFE_TIME_Subtract(RcvTime, Req->ReqTime);
+   LatencyUs = Latency.Seconds*1000000 + CFE_TIME_Sub2MicroSecs(Latency.Subseconds);
+
+   Stats->RspCnt++;
+   if (SeqCount != __atomic_load_n(&SampleSync->LastReqId, __ATOMIC_ACQUIRE))
+   {
+      Stats->LateRspCnt++;
+   }
+
+   Stats->LastLatencyUs = LatencyUs;
+   if (Stats->RspCnt == 1 || LatencyUs < Stats->MinLatencyUs)
+   {
+      Stats->MinLatencyUs = LatencyUs;
+   }
+   if (LatencyUs > Stats->MaxLatencyUs)
+   {
+      Stats->MaxLatencyUs = LatencyUs;
+   }
+   SampleSync->LatencySumUs += LatencyUs;
+
+   return true;
+
+} /* End SAMPLE_SYNC_ProcessSample() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_ResetStatus
+**
+*/
+void SAMPLE_SYNC_ResetStatus(void)
+{
+
+   memset(&SampleSync->Stats, 0, sizeof(SampleSync->Stats));
+   SampleSync->LatencySumUs = 0;
+
+} /* End SAMPLE_SYNC_ResetStatus() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_RestoreState
+**
+** Notes:
+**   1. Request slots that don't match their request ID's ring index are
+**      cleared.
+**
+*/
+void SAMPLE_SYNC_RestoreState(const SAMPLE_SYNC_SavedState_t *State)
+{
+
+   SampleSync->Mode = (State->Mode == ASTRO_PI_SampleMode_SCHEDULED) ?
+                      ASTRO_PI_SampleMode_SCHEDULED : ASTRO_PI_SampleMode_FREE_RUN;
+   SampleSync->LastReqId = State->LastReqId;
+   SampleSync->NextReqId = (State->NextReqId != 0) ? State->NextReqId : 1;
+
+   SampleSync->LatencySumUs = State->LatencySumUs;
+   SampleSync->Stats        = State->Stats;
+
+   for (uint32 i=0; i < SAMPLE_SYNC_REQ_SLOTS; i++)
+   {
+      SampleSync->Req[i] = State->Req[i];
+      if ((State->Req[i].ReqId & REQ_SLOT_MASK) != i)
+      {
+         SampleSync->Req[i].ReqId    = 0;
+         SampleSync->Req[i].Answered = false;
+      }
+   }
+
+   if (SampleSync->Req[SampleSync->LastReqId & REQ_SLOT_MASK].ReqId != SampleSync->LastReqId)
+   {
+      SampleSync->LastReqId = 0;
+   }
+
+} /* End SAMPLE_SYNC_RestoreState() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_SaveState
+**
+** Notes:
+**   1. Only the answered flags are written by the ingest task. A request
+**      answered after its flag is copied is restored as unanswered so the
+**      first tick after a restart may count it as missed.
+**
+*/
+void SAMPLE_SYNC_SaveState(SAMPLE_SYNC_SavedState_t *State)
+{
+
+   State->Mode      = GetMode();
+   State->LastReqId = SampleSync->LastReqId;
+   State->NextReqId = SampleSync->NextReqId;
+
+   State->LatencySumUs = SampleSync->LatencySumUs;
+   State->Stats        = SampleSync->Stats;
+
+   for (uint32 i=0; i < SAMPLE_SYNC_REQ_SLOTS; i++)
+   {
+      State->Req[i].ReqId    = SampleSync->Req[i].ReqId;
+      State->Req[i].Answered = __atomic_load_n(&SampleSync->Req[i].Answered, __ATOMIC_ACQUIRE);
+      State->Req[i].ReqTime  = SampleSync->Req[i].ReqTime;
+   }
+
+} /* End SAMPLE_SYNC_SaveState() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_SetModeCmd
+**
+*/
+bool SAMPLE_SYNC_SetModeCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   const ASTRO_PI_SetSampleMode_CmdPayload_t *SetSampleModeCmd = CMDMGR_PAYLOAD_PTR(MsgPtr, ASTRO_PI_SetSampleMode_t);
+
+   if (SetSampleModeCmd->Mode != ASTRO_PI_SampleMode_FREE_RUN &&
+       SetSampleModeCmd->Mode != ASTRO_PI_SampleMode_SCHEDULED)
+   {
+      CFE_EVS_SendEvent(SAMPLE_SYNC_SET_MODE_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Invalid sample mode %d", SetSampleModeCmd->Mode);
+      return false;
+   }
+
+   __atomic_store_n(&SampleSync->LastReqId, 0, __ATOMIC_RELEASE);
+   __atomic_store_n(&SampleSync->Mode, SetSampleModeCmd->Mode, __ATOMIC_RELEASE);
+
+   CFE_EVS_SendEvent(SAMPLE_SYNC_SET_MODE_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                     "Sample mode set to %s",
+                     SetSampleModeCmd->Mode == ASTRO_PI_SampleMode_SCHEDULED ? "scheduled" : "free running");
+
+   return true;
+
+} /* End SAMPLE_SYNC_SetModeCmd() */
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_TickMsg
+**
+** Notes:
+**   1. The slot's request time is written before its request ID is
+**      published so the ingest task never pairs an ID with a stale time.
+**
+*/
+bool SAMPLE_SYNC_TickMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   ASTRO_PI_SampleSyncStats_t *Stats = &SampleSync->Stats;
+   SAMPLE_SYNC_Req_t *Req;
+   uint32  LastReqId;
+   uint32  ReqId;
+
+   if (GetMode() != ASTRO_PI_SampleMode_SCHEDULED)
+   {
+      return true;
+   }
+
+   Stats->TickCnt++;
+
+   LastReqId = __atomic_load_n(&SampleSync->LastReqId, __ATOMIC_ACQUIRE);
+   if (LastReqId != 0 && !__atomic_load_n(&SampleSync->Req[LastReqId & REQ_SLOT_MASK].Answered, __ATOMIC_ACQUIRE))
+   {
+      Stats->MissedTickCnt++;
+      if (DIAG_Count(DIAG_SAMPLE_MISSED_TICK))
+      {
+         CFE_EVS_SendEvent(SAMPLE_SYNC_TICK_EID, CFE_EVS_EventType_INFORMATION,
+                           "Sample request %u not answered within a scheduler tick", (unsigned int)LastReqId);
+      }
+   }
+
+   ReqId = SampleSync->NextReqId++;
+   if (SampleSync->NextReqId == 0)
+   {
+      SampleSync->NextReqId = 1;
+   }
+
+   Req = &SampleSync->Req[ReqId & REQ_SLOT_MASK];
+   __atomic_store_n(&Req->ReqId, 0, __ATOMIC_RELEASE);
+   Req->ReqTime = CFE_TIME_GetTime();
+   __atomic_store_n(&Req->Answered, false, __ATOMIC_RELEASE);
+   __atomic_store_n(&Req->ReqId, ReqId, __ATOMIC_RELEASE);
+
+   if (SendReqMsg(ReqId))
+   {
+      Stats->ReqCnt++;
+      __atomic_store_n(&SampleSync->LastReqId, ReqId, __ATOMIC_RELEASE);
+   }
+   else
+   {
+      Stats->SbErrCnt++;
+      __atomic_store_n(&SampleSync->LastReqId, 0, __ATOMIC_RELEASE);
+   }
+
+   return true;
+
+} /* End SAMPLE_SYNC_TickMsg() */
+
+
+/******************************************************************************
+** Function: GetMode
+**
+*/
+static uint16 GetMode(void)
+{
+
+   return __atomic_load_n(&SampleSync->Mode, __ATOMIC_ACQUIRE);
+
+} /* End GetMode() */
+
+
+/******************************************************************************
+** Function: SendReqMsg
+**
+*/
+static bool SendReqMsg(uint32 ReqId)
+{
+
+   char  ReqText[REQ_TEXT_LEN];
+
+   snprintf(ReqText, sizeof(ReqText), SAMPLE_SYNC_TEXT_PREFIX "%u", (unsigned int)ReqId);
+
+   return PY_SCRIPT_SendText(ReqText, sizeof(ReqText));
+
+} /* End SendReqMsg() */
@@ -0,0 +1,219 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Request Sense HAT samples from the Pi on scheduler ticks
+**
+** Notes:
+**   1. In SCHEDULED mode each scheduler tick sends a sample request with a
+**      request ID. The Pi takes a sample when it receives a request and
+**      sends it with the JMSG name SAMPLE_SYNC_RSP_NAME and the request ID
+**      as its sequence count. The Pi returns to free running sampling when
+**      requests stop.
+**   2. Request-to-sample latency is the time from sending a request to the
+**      ingest task receiving the sample, so it includes both link delays
+**      and the Pi's sensor read time.
+**   3. A tick is missed when the previous request hasn't been answered by
+**      the time the next tick fires. Answers that arrive after that are
+**      counted as late and still contribute to the latency statistics.
+**   4. Requests are recorded in a small ring indexed by request ID. The main
+**      task writes a slot's time before publishing its ID and the ingest
+**      task claims a slot with an atomic exchange of its answered flag, so
+**      no lock is needed.
+**   5. JMSG topics can't be added from this app so requests are sent with
+**      PY_SCRIPT_SendText() as script text starting with
+**      SAMPLE_SYNC_TEXT_PREFIX followed by the request ID.
+**   6. Request answers have their own JMSG name so free running sample
+**      sequence counts aren't mixed with request IDs. Answers aren't
+**      sequence tracked, requests the Pi merged or never answered are
+**      counted as missed ticks instead of lost samples.
+**
+*/
+
+#ifndef _sample_sync_
+#define _sample_sync_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SAMPLE_SYNC_TEXT_PREFIX  "#sample "
+#define SAMPLE_SYNC_RSP_NAME     "RPI-0-sync"   /* JMSG CSV 'name' of the Pi's request answers */
+
+
+/*
+** Event Message IDs
+*/
+
+#define SAMPLE_SYNC_SET_MODE_CMD_EID  (SAMPLE_SYNC_BASE_EID + 0)
+#define SAMPLE_SYNC_TICK_EID          (SAMPLE_SYNC_BASE_EID + 1)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint32  ReqId;       /* Zero if the slot is unused */
+   bool    Answered;
+   CFE_TIME_SysTime_t  ReqTime;
+
+} SAMPLE_SYNC_Req_t;
+
+
+/*
+** Sampling mode, request IDs and outstanding request times kept in the
+** app's Critical Data Store. Restoring them lets samples answering requests
+** sent before a warm restart still be matched to their request time and
+** keeps new request IDs from colliding with requests the Pi already has.
+*/
+typedef struct
+{
+
+   uint16  Mode;
+   uint32  LastReqId;
+   uint32  NextReqId;
+
+   uint64  LatencySumUs;
+   ASTRO_PI_SampleSyncStats_t  Stats;
+
+   SAMPLE_SYNC_Req_t  Req[SAMPLE_SYNC_REQ_SLOTS];
+
+} SAMPLE_SYNC_SavedState_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   uint16  Mode;          /* ASTRO_PI_SampleMode_Enum_t, read and written with __atomic builtins */
+   uint32  LastReqId;     /* Last request sent, zero if the last tick's request wasn't sent */
+   uint32  NextReqId;
+
+   uint64  LatencySumUs;
+   ASTRO_PI_SampleSyncStats_t  Stats;
+
+   SAMPLE_SYNC_Req_t  Req[SAMPLE_SYNC_REQ_SLOTS];
+
+} SAMPLE_SYNC_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void SAMPLE_SYNC_Constructor(SAMPLE_SYNC_Class_t *SampleSyncPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_GetStatus
+**
+** Load the sample sync fields of the app's status telemetry payload.
+**
+*/
+void SAMPLE_SYNC_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_ProcessSample
+**
+** Match a received Sense HAT sample to its request.
+**
+** Notes:
+**   1. Returns true if the sample is a request answer, the caller doesn't
+**      sequence track answers.
+**   2. Only called by the Sense HAT ingest task. Answers are only matched
+**      when the mode is SCHEDULED.
+**
+*/
+bool SAMPLE_SYNC_ProcessSample(const char *Name, uint32 SeqCount, CFE_TIME_SysTime_t RcvTime);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+*/
+void SAMPLE_SYNC_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_RestoreState
+**
+** Restore the state saved by SAMPLE_SYNC_SaveState().
+**
+** Notes:
+**   1. Only called during app initialization before the child tasks start.
+**   2. The restored mode replaces the ini file's SAMPLE_SYNC_MODE so a
+**      commanded mode survives the restart.
+**
+*/
+void SAMPLE_SYNC_RestoreState(const SAMPLE_SYNC_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_SaveState
+**
+** Copy the state that's preserved across warm restarts into State.
+**
+** Notes:
+**   1. Must be called by the main task, the task that sends requests.
+**
+*/
+void SAMPLE_SYNC_SaveState(SAMPLE_SYNC_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_SetModeCmd
+**
+** Select free running or scheduler requested sampling.
+**
+*/
+bool SAMPLE_SYNC_SetModeCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+/******************************************************************************
+** Function: SAMPLE_SYNC_TickMsg
+**
+** Send a sample request if the mode is SCHEDULED.
+**
+** Notes:
+**   1. Registered with the main task's dispatcher for the scheduler topic.
+**
+*/
+bool SAMPLE_SYNC_TickMsg(void *ObjDataPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+#endif /* _sample_sync_ */
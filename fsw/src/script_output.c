@@ -0,0 +1,636 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Page the Pi's captured script output into telemetry
+**
+** Notes:
+**   1. Output batches sent by the Pi:
+**      - "id,<script id>,seq,<batch seq>,stream,<0|1>,final,<0|1>,text,<base64 text>"
+**      Batch sequence numbers start at 0 for each script. The final batch
+**      may have no text.
+**   2. Log file lines are "[<script id> out|err] <text>".
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stddef.h>
+#include "script_output.h"
+#include "py_script.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void AddBatch(size_t TextLen);
+static void AppendText(SCRIPT_OUTPUT_Script_t *Script, uint8 Stream, uint32 LostBatches, size_t TextLen);
+static SCRIPT_OUTPUT_Script_t *FindScript(uint32 ScriptId);
+static void LogBatch(uint32 ScriptId, uint8 Stream, size_t TextLen);
+static SCRIPT_OUTPUT_Page_t *NewPage(SCRIPT_OUTPUT_Script_t *Script, uint8 Stream);
+static void RefillTokens(void);
+static void SendPage(SCRIPT_OUTPUT_Script_t *Script);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SCRIPT_OUTPUT_Class_t *ScriptOutput;
+
+/*
+** Output batch parameters in the order sent by the Pi
+*/
+static const struct
+{
+
+   size_t              Offset;
+   PKTUTIL_CSV_Type_t  Type;
+   uint16              Len;
+
+} RptParam[SCRIPT_OUTPUT_RPT_PARAMS] =
+{
+
+   { offsetof(SCRIPT_OUTPUT_Rpt_t, ScriptId), PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(SCRIPT_OUTPUT_Rpt_t, BatchSeq), PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(SCRIPT_OUTPUT_Rpt_t, Stream),   PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(SCRIPT_OUTPUT_Rpt_t, Final),    PKTUTIL_CSV_INTEGER, PKTUTIL_CSV_INT_LEN },
+   { offsetof(SCRIPT_OUTPUT_Rpt_t, Text),     PKTUTIL_CSV_STRING,  JMSG_PLATFORM_TOPIC_STRING_MAX_LEN }
+
+};
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_Constructor
+**
+*/
+void SCRIPT_OUTPUT_Constructor(SCRIPT_OUTPUT_Class_t *ScriptOutputPtr, INITBL_Class_t *IniTbl)
+{
+
+   int32      SysStatus;
+   int32      LogOffset;
+   OS_time_t  Now;
+   const char *LogFilename;
+
+   ScriptOutput = ScriptOutputPtr;
+
+   memset(ScriptOutput, 0, sizeof(SCRIPT_OUTPUT_Class_t));
+
+   ScriptOutput->PageRate    = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_OUTPUT_PAGE_RATE);
+   ScriptOutput->PageBurst   = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_OUTPUT_PAGE_BURST);
+   ScriptOutput->LogMaxBytes = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_OUTPUT_LOG_MAX_BYTES);
+   if (ScriptOutput->PageRate == 0)
+   {
+      ScriptOutput->PageRate = 1;
+   }
+   if (ScriptOutput->PageBurst == 0)
+   {
+      ScriptOutput->PageBurst = 1;
+   }
+
+   ScriptOutput->Tokens = ScriptOutput->PageBurst;
+   OS_GetLocalTime(&Now);
+   ScriptOutput->LastRefillMs = OS_TimeGetTotalMilliseconds(Now);
+
+   for (int i=0; i < SCRIPT_OUTPUT_RPT_PARAMS; i++)
+   {
+      ScriptOutput->CsvEntry[i] = (PKTUTIL_CSV_Entry_t){ ((uint8 *)&ScriptOutput->Rpt) + RptParam[i].Offset,
+                                                         RptParam[i].Type, RptParam[i].Len };
+   }
+
+   ScriptOutput->ScriptOutputTlmMid = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(IniTbl, CFG_ASTRO_PI_SCRIPT_OUTPUT_TLM_TOPICID));
+
+   if (ScriptOutput->LogMaxBytes > 0)
+   {
+      LogFilename = INITBL_GetStrConfig(IniTbl, CFG_SCRIPT_OUTPUT_LOG_FILE);
+      SysStatus = OS_OpenCreate(&ScriptOutput->LogFile, LogFilename, OS_FILE_FLAG_CREATE, OS_WRITE_ONLY);
+      if (SysStatus == OS_SUCCESS)
+      {
+         LogOffset = OS_lseek(ScriptOutput->LogFile, 0, OS_SEEK_END);
+         if (LogOffset >= 0)
+         {
+            ScriptOutput->LogOpen      = true;
+            ScriptOutput->LogFileBytes = (uint32)LogOffset;
+            ScriptOutput->LogFull      = (ScriptOutput->LogFileBytes >= ScriptOutput->LogMaxBytes);
+         }
+         else
+         {
+            SysStatus = LogOffset;
+            OS_close(ScriptOutput->LogFile);
+         }
+      }
+      if (!ScriptOutput->LogOpen)
+      {
+         CFE_EVS_SendEvent(SCRIPT_OUTPUT_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                           "Error opening script output log %s, output will not be logged. Status = %d",
+                           LogFilename, (int)SysStatus);
+      }
+   }
+
+} /* End SCRIPT_OUTPUT_Constructor() */
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_GetStatus
+**
+*/
+void SCRIPT_OUTPUT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->ScriptOutput = ScriptOutput->Stats;
+
+} /* End SCRIPT_OUTPUT_GetStatus() */
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_ProcessRpt
+**
+** Notes:
+**   1. The parameter text is copied because PktUtil_ParseCsvStr() modifies
+**      it and the SB buffer is shared with other subscribers.
+**   2. The text is the last parameter so a final batch without text may be
+**      parsed as one parameter short.
+**
+*/
+bool SCRIPT_OUTPUT_ProcessRpt(const char *Name, const char *ParamText)
+{
+
+   SCRIPT_OUTPUT_Rpt_t *Rpt = &ScriptOutput->Rpt;
+   int     CsvEntries;
+   size_t  TextLen = 0;
+   bool    ValidRpt = false;
+
+   if (strncmp(Name, SCRIPT_OUTPUT_RPT_NAME, OS_MAX_API_NAME) != 0)
+   {
+      return false;
+   }
+
+   ScriptOutput->Stats.BatchCnt++;
+
+   strncpy(ScriptOutput->ParamText, ParamText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+   ScriptOutput->ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1] = '\0';
+
+   memset(Rpt, 0, sizeof(SCRIPT_OUTPUT_Rpt_t));
+   CsvEntries = PktUtil_ParseCsvStr(ScriptOutput->ParamText, ScriptOutput->CsvEntry, SCRIPT_OUTPUT_RPT_PARAMS);
+
+   if (CsvEntries == SCRIPT_OUTPUT_RPT_PARAMS || (CsvEntries == SCRIPT_OUTPUT_RPT_PARAMS-1 && Rpt->Final == 1))
+   {
+      ValidRpt = (Rpt->Stream <= ASTRO_PI_ScriptOutputStream_STDERR && Rpt->Final <= 1 &&
+                  PY_SCRIPT_Base64Decode(Rpt->Text, ScriptOutput->BatchText, SCRIPT_OUTPUT_BATCH_LEN, &TextLen));
+   }
+
+   if (ValidRpt)
+   {
+      AddBatch(TextLen);
+   }
+   else
+   {
+      ScriptOutput->Stats.BatchErrCnt++;
+      CFE_EVS_SendEvent(SCRIPT_OUTPUT_RPT_EID, CFE_EVS_EventType_ERROR,
+                        "Invalid script output batch from the Pi with %d parameters: %.60s",
+                        CsvEntries, ParamText);
+   }
+
+   return true;
+
+} /* End SCRIPT_OUTPUT_ProcessRpt() */
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_ResetStatus
+**
+*/
+void SCRIPT_OUTPUT_ResetStatus(void)
+{
+
+   uint32 BufferedPages = ScriptOutput->Stats.BufferedPages;
+
+   memset(&ScriptOutput->Stats, 0, sizeof(ScriptOutput->Stats));
+   ScriptOutput->Stats.BufferedPages = BufferedPages;
+   ScriptOutput->PeakBufferedPages   = BufferedPages;
+
+} /* End SCRIPT_OUTPUT_ResetStatus() */
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_SendPages
+**
+*/
+void SCRIPT_OUTPUT_SendPages(void)
+{
+
+   uint16 ScriptIdx;
+
+   if (ScriptOutput->Stats.BufferedPages == 0)
+   {
+      return;
+   }
+
+   RefillTokens();
+
+   while (ScriptOutput->Stats.BufferedPages > 0)
+   {
+      if (ScriptOutput->Tokens == 0)
+      {
+         ScriptOutput->Stats.RateLimitCnt++;
+         break;
+      }
+
+      for (uint16 i=0; i < SCRIPT_OUTPUT_SCRIPTS; i++)
+      {
+         ScriptIdx = (ScriptOutput->NextScript + i) % SCRIPT_OUTPUT_SCRIPTS;
+         if (ScriptOutput->Script[ScriptIdx].Count > 0)
+         {
+            SendPage(&ScriptOutput->Script[ScriptIdx]);
+            ScriptOutput->NextScript = (ScriptIdx + 1) % SCRIPT_OUTPUT_SCRIPTS;
+            ScriptOutput->Tokens--;
+            break;
+         }
+      }
+   }
+
+} /* End SCRIPT_OUTPUT_SendPages() */
+
+
+/******************************************************************************
+** Function: AddBatch
+**
+** Add a parsed batch's decoded text to its script's pages and the log.
+**
+*/
+static void AddBatch(size_t TextLen)
+{
+
+   SCRIPT_OUTPUT_Rpt_t    *Rpt = &ScriptOutput->Rpt;
+   SCRIPT_OUTPUT_Script_t *Script;
+   SCRIPT_OUTPUT_Page_t   *Page;
+   uint32  LostBatches;
+
+   Script = FindScript(Rpt->ScriptId);
+
+   if (Rpt->BatchSeq < Script->NextBatchSeq)
+   {
+      ScriptOutput->Stats.LateBatchCnt++;
+      return;
+   }
+
+   LostBatches = Rpt->BatchSeq - Script->NextBatchSeq;
+   ScriptOutput->Stats.LostBatchCnt += LostBatches;
+   Script->NextBatchSeq = Rpt->BatchSeq + 1;
+   Script->LastBatch    = ScriptOutput->Stats.BatchCnt;
+
+   LogBatch(Script->ScriptId, (uint8)Rpt->Stream, TextLen);
+   AppendText(Script, (uint8)Rpt->Stream, LostBatches, TextLen);
+
+   if (Rpt->Final)
+   {
+      Script->Final = true;
+      Page = (Script->Count > 0) ? &Script->Page[(Script->Head + Script->Count - 1) % SCRIPT_OUTPUT_PAGES]
+                                 : NewPage(Script, (uint8)Rpt->Stream);
+      Page->Final = true;
+   }
+
+} /* End AddBatch() */
+
+
+/******************************************************************************
+** Function: AppendText
+**
+** Append BatchText to the script's newest unsent page, starting new pages
+** as needed.
+**
+** Notes:
+**   1. Text following lost batches always starts a new page so the page's
+**      LostBatches marks where the output is missing.
+**
+*/
+static void AppendText(SCRIPT_OUTPUT_Script_t *Script, uint8 Stream, uint32 LostBatches, size_t TextLen)
+{
+
+   SCRIPT_OUTPUT_Page_t *Page;
+   size_t  Offset = 0;
+   size_t  CopyLen;
+
+   if (TextLen == 0 && LostBatches == 0)
+   {
+      return;
+   }
+
+   do
+   {
+      Page = (Script->Count > 0) ? &Script->Page[(Script->Head + Script->Count - 1) % SCRIPT_OUTPUT_PAGES] : NULL;
+
+      if (Page == NULL || Page->Stream != Stream || Page->Final || Page->Len == SCRIPT_OUTPUT_PAGE_LEN || LostBatches > 0)
+      {
+         Page = NewPage(Script, Stream);
+         Page->LostBatches = (LostBatches > 0xFFFF) ? 0xFFFF : (uint16)LostBatches;
+         LostBatches = 0;
+      }
+
+      CopyLen = TextLen - Offset;
+      if (CopyLen > (size_t)(SCRIPT_OUTPUT_PAGE_LEN - Page->Len))
+      {
+         CopyLen = SCRIPT_OUTPUT_PAGE_LEN - Page->Len;
+      }
+      memcpy(&Page->Text[Page->Len], &ScriptOutput->BatchText[Offset], CopyLen);
+      Page->Len += CopyLen;
+      Offset    += CopyLen;
+
+   } while (Offset < TextLen);
+
+} /* End AppendText() */
+
+
+/******************************************************************************
+** Function: FindScript
+**
+** Return the output buffer for ScriptId, assigning one if it doesn't have
+** one.
+**
+** Notes:
+**   1. A new script uses an unused buffer or the buffer of a finished
+**      script whose pages have been sent. If every buffer is busy the
+**      buffer of the script that has been quiet longest is taken and its
+**      unsent pages are dropped.
+**
+*/
+static SCRIPT_OUTPUT_Script_t *FindScript(uint32 ScriptId)
+{
+
+   SCRIPT_OUTPUT_Script_t *Script;
+   SCRIPT_OUTPUT_Script_t *Free   = NULL;
+   SCRIPT_OUTPUT_Script_t *Oldest = NULL;
+
+   for (uint16 i=0; i < SCRIPT_OUTPUT_SCRIPTS; i++)
+   {
+      Script = &ScriptOutput->Script[i];
+      if (Script->InUse && Script->ScriptId == ScriptId)
+      {
+         return Script;
+      }
+      if (!Script->InUse || (Script->Final && Script->Count == 0))
+      {
+         if (Free == NULL)
+         {
+            Free = Script;
+         }
+      }
+      else if (Oldest == NULL || Script->LastBatch < Oldest->LastBatch)
+      {
+         Oldest = Script;
+      }
+   }
+
+   if (Free == NULL)
+   {
+      Free = Oldest;
+      ScriptOutput->Stats.DroppedPageCnt += Free->Count;
+      ScriptOutput->Stats.BufferedPages  -= Free->Count;
+   }
+
+   memset(Free, 0, sizeof(SCRIPT_OUTPUT_Script_t));
+   Free->InUse    = true;
+   Free->ScriptId = ScriptId;
+
+   return Free;
+
+} /* End FindScript() */
+
+
+/******************************************************************************
+** Function: LogBatch
+**
+** Append BatchText to the log file with each line prefixed by the script
+** ID and stream.
+**
+** Notes:
+**   1. A newline is added to text that doesn't end with one. The Pi splits
+**      long lines into several batches so these are logged as separate
+**      lines.
+**   2. A batch that would take the log past LogMaxBytes isn't logged and
+**      no more batches are logged.
+**
+*/
+static void LogBatch(uint32 ScriptId, uint8 Stream, size_t TextLen)
+{
+
+   const uint8 *Text = ScriptOutput->BatchText;
+   size_t  PrefixLen;
+   size_t  LogLen;
+   size_t  LineStart;
+   size_t  LineLen;
+   bool    WriteErr = false;
+
+   if (!ScriptOutput->LogOpen || ScriptOutput->LogFull || TextLen == 0)
+   {
+      return;
+   }
+
+   PrefixLen = snprintf(ScriptOutput->LogPrefix, sizeof(ScriptOutput->LogPrefix), "[%u %s] ",
+                        (unsigned int)ScriptId, (Stream == ASTRO_PI_ScriptOutputStream_STDERR) ? "err" : "out");
+
+   LogLen = TextLen + ((Text[TextLen-1] == '\n') ? 0 : 1);
+   for (size_t i=0; i < TextLen; i++)
+   {
+      if (i == 0 || Text[i-1] == '\n')
+      {
+         LogLen += PrefixLen;
+      }
+   }
+
+   if (ScriptOutput->LogFileBytes + LogLen > ScriptOutput->LogMaxBytes)
+   {
+      ScriptOutput->LogFull = true;
+      ScriptOutput->Stats.LogErrCnt++;
+      CFE_EVS_SendEvent(SCRIPT_OUTPUT_LOG_EID, CFE_EVS_EventType_INFORMATION,
+                        "Script output log is full at %u bytes, no more output will be logged",
+                        (unsigned int)ScriptOutput->LogFileBytes);
+      return;
+   }
+
+   LineStart = 0;
+   while (LineStart < TextLen && !WriteErr)
+   {
+      LineLen = 0;
+      while (LineStart + LineLen < TextLen && Text[LineStart + LineLen] != '\n')
+      {
+         LineLen++;
+      }
+      WriteErr = (OS_write(ScriptOutput->LogFile, ScriptOutput->LogPrefix, PrefixLen) != (int32)PrefixLen ||
+                  OS_write(ScriptOutput->LogFile, &Text[LineStart], LineLen) != (int32)LineLen ||
+                  OS_write(ScriptOutput->LogFile, "\n", 1) != 1);
+      LineStart += LineLen + 1;
+   }
+
+   if (WriteErr)
+   {
+      ScriptOutput->Stats.LogErrCnt++;
+   }
+   else
+   {
+      ScriptOutput->LogFileBytes   += LogLen;
+      ScriptOutput->Stats.LogBytes += LogLen;
+   }
+
+} /* End LogBatch() */
+
+
+/******************************************************************************
+** Function: NewPage
+**
+** Add an empty page to the end of the script's unsent pages.
+**
+** Notes:
+**   1. The oldest unsent page is dropped if the script's buffer is full.
+**      Page sequence numbers are assigned here so the ground sees a gap
+**      for each dropped page.
+**
+*/
+static SCRIPT_OUTPUT_Page_t *NewPage(SCRIPT_OUTPUT_Script_t *Script, uint8 Stream)
+{
+
+   SCRIPT_OUTPUT_Page_t *Page;
+
+   if (Script->Count == SCRIPT_OUTPUT_PAGES)
+   {
+      Script->Head = (Script->Head + 1) % SCRIPT_OUTPUT_PAGES;
+      Script->Count--;
+      ScriptOutput->Stats.BufferedPages--;
+      ScriptOutput->Stats.DroppedPageCnt++;
+   }
+
+   Page = &Script->Page[(Script->Head + Script->Count) % SCRIPT_OUTPUT_PAGES];
+   Script->Count++;
+   ScriptOutput->Stats.BufferedPages++;
+   if (ScriptOutput->Stats.BufferedPages > ScriptOutput->PeakBufferedPages)
+   {
+      ScriptOutput->PeakBufferedPages = ScriptOutput->Stats.BufferedPages;
+   }
+
+   memset(Page, 0, sizeof(SCRIPT_OUTPUT_Page_t));
+   Page->Seq    = Script->PageSeq++;
+   Page->Stream = Stream;
+
+   return Page;
+
+} /* End NewPage() */
+
+
+/******************************************************************************
+** Function: RefillTokens
+**
+** Add the tokens earned since the last refill, up to PageBurst.
+**
+*/
+static void RefillTokens(void)
+{
+
+   OS_time_t Now;
+   int64     NowMs;
+   int64     NewTokens;
+
+   OS_GetLocalTime(&Now);
+   NowMs = OS_TimeGetTotalMilliseconds(Now);
+
+   if (NowMs < ScriptOutput->LastRefillMs)
+   {
+      ScriptOutput->LastRefillMs = NowMs;
+   }
+
+   NewTokens = (NowMs - ScriptOutput->LastRefillMs) * ScriptOutput->PageRate / 1000;
+   if (NewTokens > 0)
+   {
+      ScriptOutput->LastRefillMs += NewTokens * 1000 / ScriptOutput->PageRate;
+      if (ScriptOutput->Tokens + NewTokens >= ScriptOutput->PageBurst)
+      {
+         ScriptOutput->Tokens = ScriptOutput->PageBurst;
+         ScriptOutput->LastRefillMs = NowMs;
+      }
+      else
+      {
+         ScriptOutput->Tokens += (uint32)NewTokens;
+      }
+   }
+
+} /* End RefillTokens() */
+
+
+/******************************************************************************
+** Function: SendPage
+**
+** Send the script's oldest unsent page.
+**
+** Notes:
+**   1. The packet is built in an SB buffer trimmed to the page's text and
+**      sent with a zero copy transmit. A page that can't be sent is counted
+**      and discarded.
+**
+*/
+static void SendPage(SCRIPT_OUTPUT_Script_t *Script)
+{
+
+   SCRIPT_OUTPUT_Page_t *Page = &Script->Page[Script->Head];
+   CFE_SB_Buffer_t            *SbBufPtr;
+   ASTRO_PI_ScriptOutputTlm_t *Tlm;
+   size_t  MsgLen;
+
+   MsgLen = offsetof(ASTRO_PI_ScriptOutputTlm_t, Payload.Text) + Page->Len;
+
+   SbBufPtr = CFE_SB_AllocateMessageBuffer(MsgLen);
+   if (SbBufPtr != NULL)
+   {
+      Tlm = (ASTRO_PI_ScriptOutputTlm_t *)SbBufPtr;
+      CFE_MSG_Init(CFE_MSG_PTR(Tlm->TelemetryHeader), ScriptOutput->ScriptOutputTlmMid, MsgLen);
+
+      Tlm->Payload.ScriptId    = Script->ScriptId;
+      Tlm->Payload.PageSeq     = Page->Seq;
+      Tlm->Payload.Stream      = Page->Stream;
+      Tlm->Payload.Final       = Page->Final;
+      Tlm->Payload.LostBatches = Page->LostBatches;
+      Tlm->Payload.TextLen     = Page->Len;
+      memcpy(Tlm->Payload.Text, Page->Text, Page->Len);
+
+      CFE_SB_TimeStampMsg(CFE_MSG_PTR(Tlm->TelemetryHeader));
+      if (CFE_SB_TransmitBuffer(SbBufPtr, true) == CFE_SUCCESS)
+      {
+         ScriptOutput->Stats.PageCnt++;
+      }
+      else
+      {
+         CFE_SB_ReleaseMessageBuffer(SbBufPtr);
+         ScriptOutput->Stats.SbErrCnt++;
+      }
+   }
+   else
+   {
+      ScriptOutput->Stats.SbErrCnt++;
+   }
+
+   Script->Head = (Script->Head + 1) % SCRIPT_OUTPUT_PAGES;
+   Script->Count--;
+   ScriptOutput->Stats.BufferedPages--;
+
+} /* End SendPage() */
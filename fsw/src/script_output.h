@@ -0,0 +1,233 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Page the Pi's captured script output into telemetry
+**
+** Notes:
+**   1. The Pi captures each script's stdout and stderr and sends it in
+**      line batches. Each batch is JMSG CSV telemetry named
+**      SCRIPT_OUTPUT_RPT_NAME with the script ID, a per script batch
+**      sequence number, the stream, a final batch flag and the base64
+**      encoded output text. The text is base64 encoded because the JMSG
+**      CSV parameters are carried in a JSON string.
+**   2. Batches are reassembled into a bounded buffer of SCRIPT_OUTPUT_PAGES
+**      pages for each of SCRIPT_OUTPUT_SCRIPTS scripts. Text is appended
+**      to the script's newest unsent page while it has room, so output
+**      that arrives faster than pages are sent is packed into full pages.
+**      When a script's buffer is full its oldest unsent page is dropped.
+**   3. A batch sequence gap is reported in the LostBatches field of the
+**      page holding the text that follows the gap. Duplicate and out of
+**      order batches are discarded.
+**   4. Pages are sent as ScriptOutputTlm packets that end after the page
+**      text. A token bucket limits the pages sent to PageRate per second
+**      with bursts of PageBurst, so a chatty script can't flood the SB.
+**      Scripts with buffered pages take turns sending.
+**   5. Each batch is appended to the output log file when it's received.
+**      The log is closed to new output when it reaches LogMaxBytes, zero
+**      disables the log.
+**   6. All processing is done by the Sense HAT ingest task. The main task
+**      only reads the counters for the status telemetry.
+**
+*/
+
+#ifndef _script_output_
+#define _script_output_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_platform_eds_defines.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SCRIPT_OUTPUT_RPT_NAME    "script-output"   /* JMSG CSV 'name' of the Pi's output batches */
+#define SCRIPT_OUTPUT_RPT_PARAMS  5
+#define SCRIPT_OUTPUT_BATCH_LEN   (3*(JMSG_PLATFORM_TOPIC_STRING_MAX_LEN/4))   /* Max decoded batch text bytes */
+
+
+/*
+** Event Message IDs
+*/
+
+#define SCRIPT_OUTPUT_CONSTRUCTOR_EID  (SCRIPT_OUTPUT_BASE_EID + 0)
+#define SCRIPT_OUTPUT_RPT_EID          (SCRIPT_OUTPUT_BASE_EID + 1)
+#define SCRIPT_OUTPUT_LOG_EID          (SCRIPT_OUTPUT_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Output batch report loaded by PktUtil_ParseCsvStr() through CsvEntry[]
+*/
+typedef struct
+{
+
+   uint32  ScriptId;
+   uint32  BatchSeq;
+   uint32  Stream;
+   uint32  Final;
+   char    Text[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];   /* Base64 */
+
+} SCRIPT_OUTPUT_Rpt_t;
+
+
+typedef struct
+{
+
+   uint16  Seq;
+   uint8   Stream;        /* ASTRO_PI_ScriptOutputStream_Enum_t */
+   bool    Final;
+   uint16  LostBatches;
+   uint16  Len;
+   uint8   Text[SCRIPT_OUTPUT_PAGE_LEN];
+
+} SCRIPT_OUTPUT_Page_t;
+
+
+/*
+** A script's output buffer. Page[] is a ring of unsent pages starting at
+** Head.
+*/
+typedef struct
+{
+
+   bool    InUse;
+   bool    Final;          /* The script's final batch has been received */
+   uint32  ScriptId;
+   uint32  NextBatchSeq;
+   uint16  PageSeq;        /* Sequence of the next page added */
+   uint32  LastBatch;      /* Class BatchCnt when the script's last batch was received */
+
+   uint16  Head;
+   uint16  Count;
+   SCRIPT_OUTPUT_Page_t  Page[SCRIPT_OUTPUT_PAGES];
+
+} SCRIPT_OUTPUT_Script_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   CFE_SB_MsgId_t  ScriptOutputTlmMid;
+
+   uint32  PageRate;       /* Pages per second */
+   uint32  PageBurst;
+   uint32  Tokens;         /* Pages that may be sent now */
+   int64   LastRefillMs;
+
+   osal_id_t  LogFile;
+   bool    LogOpen;
+   bool    LogFull;
+   uint32  LogMaxBytes;
+   uint32  LogFileBytes;   /* Includes output logged before the app started */
+
+   uint16  NextScript;     /* Next script to send a page, scripts take turns */
+
+   ASTRO_PI_ScriptOutputStats_t  Stats;
+   uint32  PeakBufferedPages;   /* Since the last reset */
+
+   SCRIPT_OUTPUT_Script_t  Script[SCRIPT_OUTPUT_SCRIPTS];
+
+   /*
+   ** Ingest task working buffers
+   */
+
+   SCRIPT_OUTPUT_Rpt_t  Rpt;
+   PKTUTIL_CSV_Entry_t  CsvEntry[SCRIPT_OUTPUT_RPT_PARAMS];
+   char    ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+   uint8   BatchText[SCRIPT_OUTPUT_BATCH_LEN];
+   char    LogPrefix[32];
+
+} SCRIPT_OUTPUT_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Opens the output log file. Output is still paged if the log can't
+**      be opened.
+**
+*/
+void SCRIPT_OUTPUT_Constructor(SCRIPT_OUTPUT_Class_t *ScriptOutputPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_GetStatus
+**
+** Load the script output fields of the app's status telemetry payload.
+**
+*/
+void SCRIPT_OUTPUT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_ProcessRpt
+**
+** Process a JMSG CSV telemetry message if it is a script output batch.
+**
+** Notes:
+**   1. Returns true if the message was an output batch, even if it couldn't
+**      be parsed, so the caller doesn't process it as Sense HAT telemetry.
+**   2. Only called by the Sense HAT ingest task.
+**
+*/
+bool SCRIPT_OUTPUT_ProcessRpt(const char *Name, const char *ParamText);
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. The buffered page count is kept and the peak restarts from it.
+**
+*/
+void SCRIPT_OUTPUT_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: SCRIPT_OUTPUT_SendPages
+**
+** Send the buffered pages allowed by the page rate limit.
+**
+** Notes:
+**   1. Only called by the Sense HAT ingest task. It's called after each
+**      message and when the ingest pipe receive times out, so pages are
+**      sent while the Pi is quiet.
+**
+*/
+void SCRIPT_OUTPUT_SendPages(void);
+
+
+#endif /* _script_output_ */
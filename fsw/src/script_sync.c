@@ -0,0 +1,883 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Synchronize a local script directory with the Pi's remote script store
+**
+** Notes:
+**   1. Sync messages are sent to the Pi with PY_SCRIPT_SendText():
+**      - "#sync-manifest <block len>:<max blocks>"
+**      - "#sync-block <file>:<offset>:<base64 data>"
+**      - "#sync-end <file>:<file len>:<file crc>"
+**      - "#sync-delete <file>"
+**      - "#sync-commit"
+**   2. Sync reports sent by the Pi:
+**      - "file,<file>,size,<file len>,crc,<4 hex digits per block>"
+**      - "files,<file count>", sent after the last manifest file report.
+**        The manifest is rejected if the count doesn't match the number of
+**        file reports loaded.
+**      - "verified,<file count>,errors,<file count>", the commit response
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include "script_sync.h"
+#include "py_script.h"
+#include "resource.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define BLOCK_TEXT_PREFIX_LEN  (sizeof(SCRIPT_SYNC_TEXT_PREFIX "block ") + OS_MAX_FILE_NAME + 24)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool ChangeState(uint16 FromState, uint16 ToState);
+static SCRIPT_SYNC_RemoteFile_t *FindRemoteFile(const char *Name);
+static uint16 GetState(void);
+static char *NextCsvField(char **Text);
+static bool ParseFileRpt(char *ParamText, SCRIPT_SYNC_RemoteFile_t *RemoteFile);
+static void RunSync(void);
+static bool SendBlock(const char *Name, uint32 Offset, uint16 BlockLen);
+static bool SendSyncMsg(const char *SyncText);
+static void SetState(uint16 State);
+static bool SyncFile(const char *Name);
+static bool SyncTask(CHILDMGR_Class_t *ChildMgr);
+static bool ValidFileName(const char *Name);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SCRIPT_SYNC_Class_t *ScriptSync;
+
+/*
+** Sync messages are sized for the largest block message
+*/
+CompileTimeAssert((BLOCK_TEXT_PREFIX_LEN + 4*((SCRIPT_SYNC_BLOCK_LEN+2)/3)) < JMSG_PLATFORM_TOPIC_STRING_MAX_LEN,
+                  SCRIPT_SYNC_BLOCK_LEN_TooLarge);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_Constructor
+**
+*/
+bool SCRIPT_SYNC_Constructor(SCRIPT_SYNC_Class_t *ScriptSyncPtr, INITBL_Class_t *IniTbl)
+{
+
+   bool    RetStatus = false;
+   int32   SysStatus;
+   size_t  DirLen;
+   CHILDMGR_TaskInit_t ChildTaskInit;
+
+   ScriptSync = ScriptSyncPtr;
+
+   memset(ScriptSync, 0, sizeof(SCRIPT_SYNC_Class_t));
+
+   ScriptSync->ManifestTimeoutMs = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_MANIFEST_TIMEOUT);
+   ScriptSync->BlocksPerDelay    = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_BLOCKS_PER_DELAY);
+   ScriptSync->DelayMs           = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_DELAY);
+
+   strncpy(ScriptSync->LocalDir, INITBL_GetStrConfig(IniTbl, CFG_SCRIPT_SYNC_LOCAL_DIR), OS_MAX_PATH_LEN-1);
+   DirLen = strlen(ScriptSync->LocalDir);
+   if (DirLen > 1 && ScriptSync->LocalDir[DirLen-1] == '/')
+   {
+      ScriptSync->LocalDir[DirLen-1] = '\0';
+   }
+
+   SysStatus = OS_CountSemCreate(&ScriptSync->StartSem, "SYNC_START", 0, 0);
+   if (SysStatus == OS_SUCCESS)
+   {
+      SysStatus = OS_CountSemCreate(&ScriptSync->ManifestSem, "SYNC_MANIFEST", 0, 0);
+   }
+   if (SysStatus != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync constructor failed to create semaphores. Status = %d", (int)SysStatus);
+      return RetStatus;
+   }
+
+   ChildTaskInit.TaskName  = INITBL_GetStrConfig(IniTbl, CFG_SCRIPT_SYNC_CHILD_NAME);
+   ChildTaskInit.StackSize = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_CHILD_STACK_SIZE);
+   ChildTaskInit.Priority  = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_CHILD_PRIORITY);
+   ChildTaskInit.PerfId    = INITBL_GetIntConfig(IniTbl, CFG_SCRIPT_SYNC_CHILD_PERF_ID);
+   SysStatus = CHILDMGR_Constructor(&ScriptSync->ChildMgr, ChildMgr_TaskMainCallback,
+                                    SyncTask, &ChildTaskInit);
+
+   if (SysStatus == CFE_SUCCESS)
+   {
+      RetStatus = true;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync constructor failed to create child task. Status = 0x%08X", SysStatus);
+   }
+
+   return RetStatus;
+
+} /* End SCRIPT_SYNC_Constructor() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_GetStatus
+**
+*/
+void SCRIPT_SYNC_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->ScriptSync       = ScriptSync->Stats;
+   Payload->ScriptSync.State = GetState();
+
+} /* End SCRIPT_SYNC_GetStatus() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_ProcessRpt
+**
+** Notes:
+**   1. The parameter text is copied because it's split in place and the SB
+**      buffer is shared with other subscribers.
+**   2. Manifest reports are ignored unless the sync task is waiting for the
+**      manifest. A remote file is only counted after its entry is loaded.
+**   3. The file count report moves the state from MANIFEST to TRANSFER
+**      with a compare and swap so it can't race the sync task's manifest
+**      timeout. Only the winner of the swap gives ManifestSem.
+**   4. A manifest may have many reports so only the first parse error since
+**      a reset sends an event, later errors are only counted.
+**
+*/
+bool SCRIPT_SYNC_ProcessRpt(const char *Name, const char *ParamText)
+{
+
+   char    *Text = ScriptSync->RptText;
+   char    *Key;
+   char    *Value;
+   bool    ValidRpt = false;
+   uint16  RemoteFileCnt;
+
+   if (strncmp(Name, SCRIPT_SYNC_RPT_NAME, OS_MAX_API_NAME) != 0)
+   {
+      return false;
+   }
+
+   strncpy(ScriptSync->RptText, ParamText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+   ScriptSync->RptText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1] = '\0';
+
+   Key = NextCsvField(&Text);
+   if (strcmp(Key, "file") == 0)
+   {
+      ValidRpt = true;
+      RemoteFileCnt = ScriptSync->RemoteFileCnt;
+      if (GetState() == ASTRO_PI_ScriptSyncState_MANIFEST && RemoteFileCnt < SCRIPT_SYNC_MAX_FILES)
+      {
+         ValidRpt = ParseFileRpt(Text, &ScriptSync->RemoteFile[RemoteFileCnt]);
+         if (ValidRpt)
+         {
+            ScriptSync->RemoteFileCnt++;
+         }
+      }
+   }
+   else if (strcmp(Key, "files") == 0)
+   {
+      Value = NextCsvField(&Text);
+      ValidRpt = (Value != NULL);
+      if (ValidRpt && GetState() == ASTRO_PI_ScriptSyncState_MANIFEST)
+      {
+         ScriptSync->ManifestFileCnt = strtoul(Value, NULL, 10);
+         if (ChangeState(ASTRO_PI_ScriptSyncState_MANIFEST, ASTRO_PI_ScriptSyncState_TRANSFER))
+         {
+            OS_CountSemGive(ScriptSync->ManifestSem);
+         }
+      }
+   }
+   else if (strcmp(Key, "verified") == 0)
+   {
+      Value = NextCsvField(&Text);
+      if (Value != NULL)
+      {
+         ScriptSync->Stats.RemoteVerifiedCnt += strtoul(Value, NULL, 10);
+         Key   = NextCsvField(&Text);
+         Value = NextCsvField(&Text);
+         if (Key != NULL && Value != NULL && strcmp(Key, "errors") == 0)
+         {
+            ScriptSync->Stats.RemoteVerifyErrCnt += strtoul(Value, NULL, 10);
+            ValidRpt = true;
+         }
+      }
+   }
+
+   if (!ValidRpt)
+   {
+      if (++ScriptSync->Stats.RptParseErrCnt == 1)
+      {
+         CFE_EVS_SendEvent(SCRIPT_SYNC_RPT_EID, CFE_EVS_EventType_ERROR,
+                           "Invalid script sync report from the Pi: %.60s", ParamText);
+      }
+   }
+
+   return true;
+
+} /* End SCRIPT_SYNC_ProcessRpt() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_ResetStatus
+**
+*/
+void SCRIPT_SYNC_ResetStatus(void)
+{
+
+   ScriptSync->Stats.SyncCnt            = 0;
+   ScriptSync->Stats.SyncErrCnt         = 0;
+   ScriptSync->Stats.RptParseErrCnt     = 0;
+   ScriptSync->Stats.RemoteVerifiedCnt  = 0;
+   ScriptSync->Stats.RemoteVerifyErrCnt = 0;
+   ScriptSync->Stats.SbErrCnt           = 0;
+
+} /* End SCRIPT_SYNC_ResetStatus() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_RestoreState
+**
+*/
+void SCRIPT_SYNC_RestoreState(const SCRIPT_SYNC_SavedState_t *State)
+{
+
+   ScriptSync->Stats       = State->Stats;
+   ScriptSync->Stats.State = ASTRO_PI_ScriptSyncState_IDLE;
+
+} /* End SCRIPT_SYNC_RestoreState() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_SaveState
+**
+** Notes:
+**   1. The stats are written by the sync and ingest tasks. Like the status
+**      telemetry, a sync in progress may be copied between two updates.
+**
+*/
+void SCRIPT_SYNC_SaveState(SCRIPT_SYNC_SavedState_t *State)
+{
+
+   State->Stats       = ScriptSync->Stats;
+   State->Stats.State = ASTRO_PI_ScriptSyncState_IDLE;
+
+} /* End SCRIPT_SYNC_SaveState() */
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_StartCmd
+**
+*/
+bool SCRIPT_SYNC_StartCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr)
+{
+
+   if (GetState() != ASTRO_PI_ScriptSyncState_IDLE)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_START_CMD_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync command rejected, a sync is in progress");
+      return false;
+   }
+
+   SetState(ASTRO_PI_ScriptSyncState_STARTING);
+   OS_CountSemGive(ScriptSync->StartSem);
+
+   CFE_EVS_SendEvent(SCRIPT_SYNC_START_CMD_EID, CFE_EVS_EventType_INFORMATION,
+                     "Started script sync of %s", ScriptSync->LocalDir);
+
+   return true;
+
+} /* End SCRIPT_SYNC_StartCmd() */
+
+
+/******************************************************************************
+** Function: ChangeState
+**
+** Move from FromState to ToState and return true if the state is still
+** FromState.
+**
+*/
+static bool ChangeState(uint16 FromState, uint16 ToState)
+{
+
+   return __atomic_compare_exchange_n(&ScriptSync->State, &FromState, ToState, false,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+
+} /* End ChangeState() */
+
+
+/******************************************************************************
+** Function: FindRemoteFile
+**
+** Return the manifest entry for Name or NULL if the Pi doesn't have the file.
+**
+*/
+static SCRIPT_SYNC_RemoteFile_t *FindRemoteFile(const char *Name)
+{
+
+   for (uint16 i=0; i < ScriptSync->RemoteFileCnt; i++)
+   {
+      if (strncmp(ScriptSync->RemoteFile[i].Name, Name, OS_MAX_FILE_NAME) == 0)
+      {
+         return &ScriptSync->RemoteFile[i];
+      }
+   }
+
+   return NULL;
+
+} /* End FindRemoteFile() */
+
+
+/******************************************************************************
+** Function: GetState
+**
+*/
+static uint16 GetState(void)
+{
+
+   return __atomic_load_n(&ScriptSync->State, __ATOMIC_ACQUIRE);
+
+} /* End GetState() */
+
+
+/******************************************************************************
+** Function: NextCsvField
+**
+** Return the next comma separated field and advance Text past it.
+**
+** Notes:
+**   1. The field's comma is replaced with a terminator. Returns NULL when
+**      there are no more fields.
+**
+*/
+static char *NextCsvField(char **Text)
+{
+
+   char *Field = *Text;
+   char *Comma;
+
+   if (Field == NULL)
+   {
+      return NULL;
+   }
+
+   Comma = strchr(Field, ',');
+   if (Comma != NULL)
+   {
+      *Comma = '\0';
+      *Text  = Comma + 1;
+   }
+   else
+   {
+      *Text = NULL;
+   }
+
+   return Field;
+
+} /* End NextCsvField() */
+
+
+/******************************************************************************
+** Function: ParseFileRpt
+**
+** Load a manifest entry from "<file>,size,<file len>,crc,<hex CRCs>".
+**
+*/
+static bool ParseFileRpt(char *ParamText, SCRIPT_SYNC_RemoteFile_t *RemoteFile)
+{
+
+   char    *Name;
+   char    *Key;
+   char    *Value;
+   char    CrcText[5];
+   size_t  CrcTextLen;
+
+   Name = NextCsvField(&ParamText);
+   if (Name == NULL || !ValidFileName(Name))
+   {
+      return false;
+   }
+
+   Key   = NextCsvField(&ParamText);
+   Value = NextCsvField(&ParamText);
+   if (Key == NULL || Value == NULL || strcmp(Key, "size") != 0)
+   {
+      return false;
+   }
+   RemoteFile->Size = strtoul(Value, NULL, 10);
+
+   Key   = NextCsvField(&ParamText);
+   Value = NextCsvField(&ParamText);
+   if (Key == NULL || Value == NULL || strcmp(Key, "crc") != 0)
+   {
+      return false;
+   }
+
+   CrcTextLen = strlen(Value);
+   if ((CrcTextLen % 4) != 0 || CrcTextLen/4 > SCRIPT_SYNC_MAX_FILE_BLOCKS)
+   {
+      return false;
+   }
+
+   strncpy(RemoteFile->Name, Name, OS_MAX_FILE_NAME-1);
+   RemoteFile->Name[OS_MAX_FILE_NAME-1] = '\0';
+   RemoteFile->Matched  = false;
+   RemoteFile->BlockCnt = CrcTextLen/4;
+
+   CrcText[4] = '\0';
+   for (uint16 i=0; i < RemoteFile->BlockCnt; i++)
+   {
+      memcpy(CrcText, &Value[4*i], 4);
+      RemoteFile->BlockCrc[i] = (uint16)strtoul(CrcText, NULL, 16);
+   }
+
+   return true;
+
+} /* End ParseFileRpt() */
+
+
+/******************************************************************************
+** Function: RunSync
+**
+** Notes:
+**   1. Directory entries that can't be synced are counted as skipped and
+**      don't stop the sync.
+**   2. Throughput is the file bytes sent divided by the time from the
+**      manifest request to the commit message.
+**   3. The ingest task moves the state to TRANSFER when the manifest is
+**      complete. If the manifest wait times out just as the ingest task
+**      does this the manifest is used and ManifestSem is taken after its
+**      give.
+**   4. If the Pi has more than SCRIPT_SYNC_MAX_FILES files only the first
+**      SCRIPT_SYNC_MAX_FILES are compared and no remote files are deleted,
+**      since a file missing from the truncated manifest can't be told apart
+**      from a deleted one. Local files that aren't in the truncated
+**      manifest are sent in full.
+**   5. A remote file is matched by any local directory entry with its name,
+**      even one that's skipped, so a local file that can't be synced never
+**      causes its remote copy to be deleted.
+**
+*/
+static void RunSync(void)
+{
+
+   ASTRO_PI_ScriptSyncStats_t *Stats = &ScriptSync->Stats;
+   int32      SysStatus;
+   osal_id_t  DirId;
+   os_dirent_t  DirEntry;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+   const char *Name;
+   bool       Truncated;
+   SCRIPT_SYNC_RemoteFile_t *RemoteFile;
+
+   Stats->FilesChecked  = 0;
+   Stats->FilesUpdated  = 0;
+   Stats->FilesDeleted  = 0;
+   Stats->FilesSkipped  = 0;
+   Stats->BlocksSent    = 0;
+   Stats->BytesSent     = 0;
+   Stats->BytesSaved    = 0;
+   Stats->DurationMs    = 0;
+   Stats->ThroughputBps = 0;
+
+   OS_GetLocalTime(&StartTime);
+
+   /*
+   ** Request the manifest. Discard a late manifest from a previous sync.
+   */
+
+   while (OS_CountSemTimedWait(ScriptSync->ManifestSem, 0) == OS_SUCCESS);
+   ScriptSync->RemoteFileCnt = 0;
+   SetState(ASTRO_PI_ScriptSyncState_MANIFEST);
+
+   snprintf(ScriptSync->MsgText, sizeof(ScriptSync->MsgText), SCRIPT_SYNC_TEXT_PREFIX "manifest %u:%u",
+            SCRIPT_SYNC_BLOCK_LEN, SCRIPT_SYNC_MAX_FILE_BLOCKS);
+   if (!SendSyncMsg(ScriptSync->MsgText))
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync failed. Software Bus error sending manifest request");
+      Stats->SyncErrCnt++;
+      SetState(ASTRO_PI_ScriptSyncState_IDLE);
+      return;
+   }
+
+   SysStatus = OS_CountSemTimedWait(ScriptSync->ManifestSem, ScriptSync->ManifestTimeoutMs);
+   if (SysStatus != OS_SUCCESS)
+   {
+      if (ChangeState(ASTRO_PI_ScriptSyncState_MANIFEST, ASTRO_PI_ScriptSyncState_IDLE))
+      {
+         CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_ERROR,
+                           "Script sync failed. No manifest received from the Pi within %u ms",
+                           (unsigned int)ScriptSync->ManifestTimeoutMs);
+         Stats->SyncErrCnt++;
+         return;
+      }
+      OS_CountSemTake(ScriptSync->ManifestSem);
+   }
+
+   Truncated = (ScriptSync->ManifestFileCnt > SCRIPT_SYNC_MAX_FILES &&
+                ScriptSync->RemoteFileCnt == SCRIPT_SYNC_MAX_FILES);
+   if (Truncated)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_INFORMATION,
+                        "Script sync manifest has %u files, only the first %d are compared and no remote files will be deleted",
+                        (unsigned int)ScriptSync->ManifestFileCnt, SCRIPT_SYNC_MAX_FILES);
+   }
+   else if (ScriptSync->ManifestFileCnt != ScriptSync->RemoteFileCnt)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync failed. The Pi reported %u manifest files and %u were loaded",
+                        (unsigned int)ScriptSync->ManifestFileCnt, (unsigned int)ScriptSync->RemoteFileCnt);
+      Stats->SyncErrCnt++;
+      SetState(ASTRO_PI_ScriptSyncState_IDLE);
+      return;
+   }
+
+   /*
+   ** Send changed blocks for each local file
+   */
+
+   SysStatus = OS_DirectoryOpen(&DirId, ScriptSync->LocalDir);
+   if (SysStatus != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync failed. Error opening local directory %s. Status = %d",
+                        ScriptSync->LocalDir, (int)SysStatus);
+      Stats->SyncErrCnt++;
+      SetState(ASTRO_PI_ScriptSyncState_IDLE);
+      return;
+   }
+
+   while (OS_DirectoryRead(DirId, &DirEntry) == OS_SUCCESS)
+   {
+      Name = OS_DIRENTRY_NAME(DirEntry);
+      if (Name[0] == '.')
+      {
+         continue;
+      }
+      RemoteFile = FindRemoteFile(Name);
+      if (RemoteFile != NULL)
+      {
+         RemoteFile->Matched = true;
+      }
+      if (!ValidFileName(Name))
+      {
+         Stats->FilesSkipped++;
+         CFE_EVS_SendEvent(SCRIPT_SYNC_FILE_EID, CFE_EVS_EventType_ERROR,
+                           "Script sync skipped %s. Names may only contain letters, digits, '.', '_' and '-'", Name);
+         continue;
+      }
+      if (!SyncFile(Name))
+      {
+         Stats->FilesSkipped++;
+      }
+   }
+
+   OS_DirectoryClose(DirId);
+
+   /*
+   ** Delete remote files that aren't in the local directory
+   */
+
+   for (uint16 i=0; i < ScriptSync->RemoteFileCnt && !Truncated; i++)
+   {
+      if (!ScriptSync->RemoteFile[i].Matched)
+      {
+         snprintf(ScriptSync->MsgText, sizeof(ScriptSync->MsgText), SCRIPT_SYNC_TEXT_PREFIX "delete %s",
+                  ScriptSync->RemoteFile[i].Name);
+         if (SendSyncMsg(ScriptSync->MsgText))
+         {
+            Stats->FilesDeleted++;
+         }
+      }
+   }
+
+   SendSyncMsg(SCRIPT_SYNC_TEXT_PREFIX "commit");
+
+   OS_GetLocalTime(&EndTime);
+   Stats->DurationMs = (uint32)OS_TimeGetTotalMilliseconds(OS_TimeSubtract(EndTime, StartTime));
+   Stats->ThroughputBps = (Stats->DurationMs > 0) ? (uint32)(((uint64)Stats->BytesSent * 1000) / Stats->DurationMs) : 0;
+   Stats->SyncCnt++;
+
+   CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_INFORMATION,
+                     "Script sync complete. %u files checked, %u updated, %u deleted, %u skipped. "
+                     "%u bytes sent, %u bytes unchanged in %u ms",
+                     (unsigned int)Stats->FilesChecked, (unsigned int)Stats->FilesUpdated,
+                     (unsigned int)Stats->FilesDeleted, (unsigned int)Stats->FilesSkipped,
+                     (unsigned int)Stats->BytesSent, (unsigned int)Stats->BytesSaved,
+                     (unsigned int)Stats->DurationMs);
+
+   SetState(ASTRO_PI_ScriptSyncState_IDLE);
+
+} /* End RunSync() */
+
+
+/******************************************************************************
+** Function: SendBlock
+**
+** Send BlockLen bytes of the Block[] buffer for the file at Offset.
+**
+*/
+static bool SendBlock(const char *Name, uint32 Offset, uint16 BlockLen)
+{
+
+   int PrefixLen;
+
+   PrefixLen = snprintf(ScriptSync->MsgText, sizeof(ScriptSync->MsgText), SCRIPT_SYNC_TEXT_PREFIX "block %s:%u:",
+                        Name, (unsigned int)Offset);
+   PY_SCRIPT_Base64Encode(ScriptSync->Block, BlockLen, &ScriptSync->MsgText[PrefixLen]);
+
+   return SendSyncMsg(ScriptSync->MsgText);
+
+} /* End SendBlock() */
+
+
+/******************************************************************************
+** Function: SendSyncMsg
+**
+** Notes:
+**   1. SB failures are also counted in the sync statistics so they can be
+**      told apart from the other script topic users.
+**
+*/
+static bool SendSyncMsg(const char *SyncText)
+{
+
+   if (!PY_SCRIPT_SendText(SyncText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN))
+   {
+      ScriptSync->Stats.SbErrCnt++;
+      return false;
+   }
+
+   return true;
+
+} /* End SendSyncMsg() */
+
+
+/******************************************************************************
+** Function: SetState
+**
+*/
+static void SetState(uint16 State)
+{
+
+   __atomic_store_n(&ScriptSync->State, State, __ATOMIC_RELEASE);
+
+} /* End SetState() */
+
+
+/******************************************************************************
+** Function: SyncFile
+**
+** Send a local file's changed blocks and its file end message.
+**
+** Notes:
+**   1. Returns false if the file was skipped.
+**   2. Blocks are compared with the manifest CRCs. A block beyond the end
+**      of the remote file or without a CRC is always sent.
+**   3. The file end message is sent if any block changed or the file sizes
+**      differ so the Pi can create or truncate the file.
+**   4. The task delays after every BlocksPerDelay blocks so a sync doesn't
+**      flood the JMSG link.
+**
+*/
+static bool SyncFile(const char *Name)
+{
+
+   ASTRO_PI_ScriptSyncStats_t *Stats = &ScriptSync->Stats;
+   SCRIPT_SYNC_RemoteFile_t   *RemoteFile;
+   int32      SysStatus;
+   int32      BytesRead;
+   osal_id_t  FileHandle;
+   os_fstat_t FileStat;
+   uint32     FileSize;
+   uint32     Offset = 0;
+   uint16     BlockIdx = 0;
+   uint16     BlockCrc;
+   uint32     FileCrc = 0;
+   bool       Changed;
+
+   snprintf(ScriptSync->FilePath, sizeof(ScriptSync->FilePath), "%s/%s", ScriptSync->LocalDir, Name);
+
+   SysStatus = OS_stat(ScriptSync->FilePath, &FileStat);
+   if (SysStatus != OS_SUCCESS || OS_FILESTAT_ISDIR(FileStat))
+   {
+      return false;
+   }
+
+   FileSize = OS_FILESTAT_SIZE(FileStat);
+   if (FileSize > SCRIPT_SYNC_MAX_FILE_BLOCKS*SCRIPT_SYNC_BLOCK_LEN)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync skipped %s. File length %u is greater than the %u byte limit",
+                        Name, (unsigned int)FileSize, SCRIPT_SYNC_MAX_FILE_BLOCKS*SCRIPT_SYNC_BLOCK_LEN);
+      return false;
+   }
+
+   SysStatus = OS_OpenCreate(&FileHandle, ScriptSync->FilePath, OS_FILE_FLAG_NONE, OS_READ_ONLY);
+   if (SysStatus != OS_SUCCESS)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync skipped %s. Error opening file, status = %d", Name, (int)SysStatus);
+      return false;
+   }
+
+   RemoteFile = FindRemoteFile(Name);
+   Changed = (RemoteFile == NULL || RemoteFile->Size != FileSize);
+
+   while (Offset < FileSize)
+   {
+
+      BytesRead = OS_read(FileHandle, ScriptSync->Block, SCRIPT_SYNC_BLOCK_LEN);
+      if (BytesRead <= 0)
+      {
+         break;
+      }
+
+      BlockCrc = (uint16)CFE_ES_CalculateCRC(ScriptSync->Block, BytesRead, 0, CFE_ES_CrcType_CRC_16);
+      FileCrc  = CFE_ES_CalculateCRC(ScriptSync->Block, BytesRead, FileCrc, CFE_ES_CrcType_CRC_16);
+
+      if (RemoteFile != NULL && BlockIdx < RemoteFile->BlockCnt && RemoteFile->BlockCrc[BlockIdx] == BlockCrc)
+      {
+         Stats->BytesSaved += BytesRead;
+      }
+      else
+      {
+         if (!SendBlock(Name, Offset, BytesRead))
+         {
+            break;
+         }
+         Changed = true;
+         Stats->BlocksSent++;
+         Stats->BytesSent += BytesRead;
+         if (ScriptSync->BlocksPerDelay > 0 && (Stats->BlocksSent % ScriptSync->BlocksPerDelay) == 0)
+         {
+            RESOURCE_EndWork(ASTRO_PI_ResourceTask_SCRIPT_SYNC);
+            OS_TaskDelay(ScriptSync->DelayMs);
+            RESOURCE_BeginWork(ASTRO_PI_ResourceTask_SCRIPT_SYNC);
+         }
+      }
+
+      Offset += BytesRead;
+      BlockIdx++;
+
+   } /* End block loop */
+
+   OS_close(FileHandle);
+
+   if (Offset != FileSize)
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_FILE_EID, CFE_EVS_EventType_ERROR,
+                        "Script sync of %s stopped after %u of %u bytes due to a file read or SB error",
+                        Name, (unsigned int)Offset, (unsigned int)FileSize);
+      return false;
+   }
+
+   if (Changed)
+   {
+      snprintf(ScriptSync->MsgText, sizeof(ScriptSync->MsgText), SCRIPT_SYNC_TEXT_PREFIX "end %s:%u:%u",
+               Name, (unsigned int)FileSize, (unsigned int)FileCrc);
+      if (!SendSyncMsg(ScriptSync->MsgText))
+      {
+         return false;
+      }
+      Stats->FilesUpdated++;
+   }
+
+   Stats->FilesChecked++;
+
+   return true;
+
+} /* End SyncFile() */
+
+
+/******************************************************************************
+** Function: SyncTask
+**
+** Notes:
+**   1. Returning false terminates the child task
+**
+*/
+static bool SyncTask(CHILDMGR_Class_t *ChildMgr)
+{
+
+   int32 SysStatus;
+
+   SysStatus = OS_CountSemTake(ScriptSync->StartSem);
+
+   if (SysStatus == OS_SUCCESS)
+   {
+      RESOURCE_BeginWork(ASTRO_PI_ResourceTask_SCRIPT_SYNC);
+      RunSync();
+      RESOURCE_EndWork(ASTRO_PI_ResourceTask_SCRIPT_SYNC);
+   }
+   else
+   {
+      CFE_EVS_SendEvent(SCRIPT_SYNC_TASK_EID, CFE_EVS_EventType_CRITICAL,
+                        "Script sync task terminating, semaphore take status = %d", (int)SysStatus);
+      return false;
+   }
+
+   return true;
+
+} /* End SyncTask() */
+
+
+/******************************************************************************
+** Function: ValidFileName
+**
+** Names can't contain path separators or characters that need JSON escaping.
+**
+*/
+static bool ValidFileName(const char *Name)
+{
+
+   size_t NameLen = strnlen(Name, OS_MAX_FILE_NAME);
+
+   if (NameLen == 0 || NameLen >= OS_MAX_FILE_NAME || Name[0] == '.')
+   {
+      return false;
+   }
+
+   for (size_t i=0; i < NameLen; i++)
+   {
+      if (!((Name[i] >= 'a' && Name[i] <= 'z') || (Name[i] >= 'A' && Name[i] <= 'Z') ||
+            (Name[i] >= '0' && Name[i] <= '9') || Name[i] == '.' || Name[i] == '_' || Name[i] == '-'))
+      {
+         return false;
+      }
+   }
+
+   return true;
+
+} /* End ValidFileName() */
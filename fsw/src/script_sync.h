@@ -0,0 +1,228 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Synchronize a local script directory with the Pi's remote script store
+**
+** Notes:
+**   1. A sync runs on its own child task so the app keeps processing
+**      commands while files are read and blocks are sent:
+**      - The task asks the Pi for a manifest of its stored files. The Pi
+**        sends each file's size and per block CRCs followed by a file count.
+**      - Each local file's blocks are compared against the manifest and
+**        only the changed blocks are sent. A file end message gives the Pi
+**        the file length and CRC so it can truncate and verify the file.
+**      - Remote files with no local file are deleted. A commit message asks
+**        the Pi to report how many files it verified.
+**   2. JMSG topics can't be added from this app so sync messages are script
+**      text starting with SCRIPT_SYNC_TEXT_PREFIX and the Pi's replies are
+**      CSV telemetry named SCRIPT_SYNC_RPT_NAME. The Pi replies are
+**      processed by the Sense HAT ingest task.
+**   3. Block and file CRCs are the cFE CRC-16 (CRC-16/ARC).
+**   4. File names are limited to characters that don't need JSON escaping.
+**
+*/
+
+#ifndef _script_sync_
+#define _script_sync_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "jmsg_platform_eds_defines.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SCRIPT_SYNC_RPT_NAME     "script-sync"   /* JMSG CSV 'name' of the Pi's sync reports */
+#define SCRIPT_SYNC_TEXT_PREFIX  "#sync-"
+
+
+/*
+** Event Message IDs
+*/
+
+#define SCRIPT_SYNC_CONSTRUCTOR_EID  (SCRIPT_SYNC_BASE_EID + 0)
+#define SCRIPT_SYNC_START_CMD_EID    (SCRIPT_SYNC_BASE_EID + 1)
+#define SCRIPT_SYNC_TASK_EID         (SCRIPT_SYNC_BASE_EID + 2)
+#define SCRIPT_SYNC_FILE_EID         (SCRIPT_SYNC_BASE_EID + 3)
+#define SCRIPT_SYNC_RPT_EID          (SCRIPT_SYNC_BASE_EID + 4)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** A file in the Pi's manifest
+*/
+typedef struct
+{
+
+   char    Name[OS_MAX_FILE_NAME];
+   uint32  Size;
+   uint16  BlockCnt;      /* Blocks with a CRC in the manifest */
+   bool    Matched;       /* A local file with the same name was found */
+   uint16  BlockCrc[SCRIPT_SYNC_MAX_FILE_BLOCKS];
+
+} SCRIPT_SYNC_RemoteFile_t;
+
+
+/*
+** Sync counters and the last sync's results kept in the app's Critical Data
+** Store. A sync in progress is not resumed after a warm restart.
+*/
+typedef struct
+{
+
+   ASTRO_PI_ScriptSyncStats_t  Stats;
+
+} SCRIPT_SYNC_SavedState_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   CHILDMGR_Class_t  ChildMgr;
+
+   /*
+   ** Class State Data
+   */
+
+   osal_id_t       StartSem;      /* Given by the sync command */
+   osal_id_t       ManifestSem;   /* Given by the ingest task when the manifest is complete */
+
+   char    LocalDir[OS_MAX_PATH_LEN];
+   uint32  ManifestTimeoutMs;
+   uint32  BlocksPerDelay;
+   uint32  DelayMs;
+
+   uint16  State;   /* ASTRO_PI_ScriptSyncState_Enum_t, read and written with __atomic builtins */
+   ASTRO_PI_ScriptSyncStats_t  Stats;
+
+   /*
+   ** Manifest written by the ingest task while State is MANIFEST. The sync
+   ** task only reads it after the ingest task moves State to TRANSFER.
+   */
+
+   uint32  ManifestFileCnt;   /* File count reported by the Pi */
+   uint16  RemoteFileCnt;
+   SCRIPT_SYNC_RemoteFile_t  RemoteFile[SCRIPT_SYNC_MAX_FILES];
+   char    RptText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+
+   /*
+   ** Sync task working buffers
+   */
+
+   char    FilePath[OS_MAX_PATH_LEN];
+   uint8   Block[SCRIPT_SYNC_BLOCK_LEN];
+   char    MsgText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+
+} SCRIPT_SYNC_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Creates the sync child task.
+**
+*/
+bool SCRIPT_SYNC_Constructor(SCRIPT_SYNC_Class_t *ScriptSyncPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_GetStatus
+**
+** Load the script sync fields of the app's status telemetry payload.
+**
+*/
+void SCRIPT_SYNC_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_ProcessRpt
+**
+** Process a JMSG CSV telemetry message if it is a script sync report.
+**
+** Notes:
+**   1. Returns true if the message was a script sync report, even if it
+**      couldn't be parsed, so the caller doesn't process it as Sense HAT
+**      telemetry.
+**   2. Only called by the Sense HAT ingest task.
+**
+*/
+bool SCRIPT_SYNC_ProcessRpt(const char *Name, const char *ParamText);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. The last sync's results are kept.
+**
+*/
+void SCRIPT_SYNC_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_RestoreState
+**
+** Restore the state saved by SCRIPT_SYNC_SaveState().
+**
+** Notes:
+**   1. Only called during app initialization before a sync can be started.
+**
+*/
+void SCRIPT_SYNC_RestoreState(const SCRIPT_SYNC_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_SaveState
+**
+** Copy the state that's preserved across warm restarts into State.
+**
+*/
+void SCRIPT_SYNC_SaveState(SCRIPT_SYNC_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SCRIPT_SYNC_StartCmd
+**
+** Start synchronizing the local script directory with the Pi.
+**
+** Notes:
+**   1. Fails if a sync is in progress.
+**
+*/
+bool SCRIPT_SYNC_StartCmd(void *DataObjPtr, const CFE_MSG_Message_t *MsgPtr);
+
+
+#endif /* _script_sync_ */
@@ -0,0 +1,521 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the Sense HAT telemetry pipeline
+**
+** Notes:
+**   1. This object needs to know the JMSG_LIB CSV telemetry definitions
+**   2. sense_hat_schema.h is generated from the EDS at build time by
+**      tools/gen_sense_hat_schema.py.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <stdlib.h>
+#include "sense_hat.h"
+#include "calibrate.h"
+#include "diag.h"
+#include "led_matrix.h"
+#include "py_script.h"
+#include "resource.h"
+#include "sample_sync.h"
+#include "script_output.h"
+#include "script_sync.h"
+#include "seq_track.h"
+#include "spectrum.h"
+#include "jmsg_lib_eds_typedefs.h"
+#include "sense_hat_schema.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static bool DecodeParams(const char *ParamText, ASTRO_PI_SenseHatTlm_Payload_t *Sample, int *FieldCnt);
+static bool DecodeValue(const SENSE_HAT_SCHEMA_Field_t *Field, const char *ValueText,
+                        ASTRO_PI_SenseHatTlm_Payload_t *Sample, const char **NextText);
+static bool IngestCsvTlm(void *ObjDataPtr, const CFE_MSG_Message_t *JMsgCsvTlm);
+static bool IngestTask(CHILDMGR_Class_t *ChildMgr);
+static void PublishSample(const SAMPLE_QUEUE_Entry_t *Sample);
+static bool PublishTask(CHILDMGR_Class_t *ChildMgr);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SENSE_HAT_Class_t *SenseHat;
+
+/******************************************************************************
+** Function: SENSE_HAT_Constructor
+**
+** Notes:
+**   1. The publish task is created before the ingest task so the queue
+**      always has a consumer.
+**
+*/
+bool SENSE_HAT_Constructor(SENSE_HAT_Class_t *SenseHatPtr, INITBL_Class_t *IniTbl)
+{
+
+   bool   RetStatus = false;
+   int32  SysStatus;
+   CHILDMGR_TaskInit_t ChildTaskInit;
+
+   SenseHat = SenseHatPtr;
+
+   memset(SenseHat, 0, sizeof(SENSE_HAT_Class_t));
+
+   SenseHat->SenseHatTlmMid     = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(IniTbl, CFG_ASTRO_PI_SENSE_HAT_TLM_TOPICID));
+   SenseHat->JmsgTopicCsvTlmMid = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(IniTbl, CFG_JMSG_LIB_TOPIC_CSV_TLM_TOPICID));
+
+   if (!SAMPLE_QUEUE_Constructor(&SenseHat->PubQueue, "SH_PUB_Q"))
+   {
+      CFE_EVS_SendEvent(SENSE_HAT_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Sense HAT constructor failed to create the publish queue semaphore");
+      return RetStatus;
+   }
+
+   SysStatus = CFE_SB_CreatePipe(&SenseHat->Ingest.Pipe, INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_PIPE_DEPTH),
+                                 INITBL_GetStrConfig(IniTbl, CFG_SENSE_HAT_PIPE_NAME));
+   if (SysStatus != CFE_SUCCESS)
+   {
+      CFE_EVS_SendEvent(SENSE_HAT_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Sense HAT constructor failed to create the ingest pipe. Status = 0x%08X", SysStatus);
+      return RetStatus;
+   }
+
+   DISPATCH_Constructor(&SenseHat->Ingest.Dispatch, SenseHat->Ingest.Pipe);
+   if (!DISPATCH_RegisterFunc(&SenseHat->Ingest.Dispatch, SenseHat->JmsgTopicCsvTlmMid, &SenseHat->Ingest, IngestCsvTlm))
+   {
+      return RetStatus;
+   }
+
+   ChildTaskInit.TaskName  = INITBL_GetStrConfig(IniTbl, CFG_SENSE_HAT_PUB_CHILD_NAME);
+   ChildTaskInit.StackSize = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_PUB_CHILD_STACK_SIZE);
+   ChildTaskInit.Priority  = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_PUB_CHILD_PRIORITY);
+   ChildTaskInit.PerfId    = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_PUB_CHILD_PERF_ID);
+   SysStatus = CHILDMGR_Constructor(&SenseHat->PubChildMgr, ChildMgr_TaskMainCallback,
+                                    PublishTask, &ChildTaskInit);
+
+   if (SysStatus == CFE_SUCCESS)
+   {
+      ChildTaskInit.TaskName  = INITBL_GetStrConfig(IniTbl, CFG_SENSE_HAT_INGEST_CHILD_NAME);
+      ChildTaskInit.StackSize = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_INGEST_CHILD_STACK_SIZE);
+      ChildTaskInit.Priority  = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_INGEST_CHILD_PRIORITY);
+      ChildTaskInit.PerfId    = INITBL_GetIntConfig(IniTbl, CFG_SENSE_HAT_INGEST_CHILD_PERF_ID);
+      SysStatus = CHILDMGR_Constructor(&SenseHat->Ingest.ChildMgr, ChildMgr_TaskMainCallback,
+                                       IngestTask, &ChildTaskInit);
+   }
+
+   if (SysStatus == CFE_SUCCESS)
+   {
+      RetStatus = true;
+   }
+   else
+   {
+      CFE_EVS_SendEvent(SENSE_HAT_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Sense HAT constructor failed to create child tasks. Status = 0x%08X", SysStatus);
+   }
+
+   return RetStatus;
+
+} /* End SENSE_HAT_Constructor() */
+
+
+/******************************************************************************
+** Function: SENSE_HAT_GetStatus
+**
+*/
+void SENSE_HAT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->SenseHatRcvCnt      = SenseHat->RcvCnt;
+   Payload->SenseHatParseErrCnt = SenseHat->ParseErrCnt;
+   Payload->SenseHatSentCnt     = SenseHat->SentCnt;
+   Payload->SenseHatSbErrCnt    = SenseHat->SbErrCnt;
+
+   SAMPLE_QUEUE_GetStats(&SenseHat->PubQueue, &Payload->PubQueue);
+
+} /* End SENSE_HAT_GetStatus() */
+
+
+/******************************************************************************
+** Function: SENSE_HAT_ResetStatus
+**
+*/
+void SENSE_HAT_ResetStatus(void)
+{
+
+   SenseHat->RcvCnt      = 0;
+   SenseHat->ParseErrCnt = 0;
+   SenseHat->SentCnt     = 0;
+   SenseHat->SbErrCnt    = 0;
+
+   SAMPLE_QUEUE_ResetStatus(&SenseHat->PubQueue);
+   DISPATCH_ResetStatus(&SenseHat->Ingest.Dispatch);
+
+} /* End SENSE_HAT_ResetStatus() */
+
+
+/******************************************************************************
+** Function: DecodeParams
+**
+** Load Sample from the "name,value,name,value,..." parameter text.
+**
+** Notes:
+**   1. Parameters may be in any order. Names are found with the perfect hash
+**      generated from the EDS SenseHatTlm_Payload definition so each lookup
+**      is one hash and one compare.
+**   2. Returns true if every schema field is loaded exactly once. Decoding
+**      stops at the first unknown name, repeated name or invalid value.
+**      FieldCnt is the number of fields loaded before the stop.
+**
+*/
+static bool DecodeParams(const char *ParamText, ASTRO_PI_SenseHatTlm_Payload_t *Sample, int *FieldCnt)
+{
+
+   const char *Name = ParamText;
+   const char *Value;
+   const SENSE_HAT_SCHEMA_Field_t *Field;
+   uint32  FieldBit;
+   uint32  FieldMask = 0;
+
+   *FieldCnt = 0;
+
+   while (*Name != '\0')
+   {
+
+      Value = strchr(Name, ',');
+      if (Value == NULL)
+      {
+         return false;
+      }
+
+      Field = SENSE_HAT_SCHEMA_Lookup(Name, (size_t)(Value - Name));
+      if (Field == NULL)
+      {
+         return false;
+      }
+
+      FieldBit = 1u << (Field - SENSE_HAT_SCHEMA_Field);
+      if (FieldMask & FieldBit)
+      {
+         return false;
+      }
+
+      if (!DecodeValue(Field, Value+1, Sample, &Name))
+      {
+         return false;
+      }
+
+      FieldMask |= FieldBit;
+      (*FieldCnt)++;
+
+      if (*Name == ',')
+      {
+         Name++;
+      }
+      else if (*Name != '\0')
+      {
+         return false;
+      }
+
+   } /* End while parameters */
+
+   return (FieldMask == SENSE_HAT_SCHEMA_ALL_FIELDS);
+
+} /* End DecodeParams() */
+
+
+/******************************************************************************
+** Function: DecodeValue
+**
+** Convert the value text to the field's type and store it in Sample.
+**
+** Notes:
+**   1. NextText is set to the character following the value.
+**   2. Integer values outside the field type's range are rejected.
+**
+*/
+static bool DecodeValue(const SENSE_HAT_SCHEMA_Field_t *Field, const char *ValueText,
+                        ASTRO_PI_SenseHatTlm_Payload_t *Sample, const char **NextText)
+{
+
+   uint8     *Data = (uint8 *)Sample + Field->Offset;
+   char      *End;
+   long long IntValue = 0;
+   long long IntMin   = 0;
+   long long IntMax   = 0;
+
+   switch (Field->Type)
+   {
+      case SENSE_HAT_SCHEMA_FLOAT:
+         *(float *)Data = strtof(ValueText, &End);
+         break;
+      case SENSE_HAT_SCHEMA_DOUBLE:
+         *(double *)Data = strtod(ValueText, &End);
+         break;
+      default:
+         IntValue = strtoll(ValueText, &End, 10);
+         break;
+   }
+
+   if (End == ValueText)
+   {
+      return false;
+   }
+   *NextText = End;
+
+   switch (Field->Type)
+   {
+      case SENSE_HAT_SCHEMA_INT8:   IntMin = INT8_MIN;  IntMax = INT8_MAX;   break;
+      case SENSE_HAT_SCHEMA_INT16:  IntMin = INT16_MIN; IntMax = INT16_MAX;  break;
+      case SENSE_HAT_SCHEMA_INT32:  IntMin = INT32_MIN; IntMax = INT32_MAX;  break;
+      case SENSE_HAT_SCHEMA_UINT8:  IntMax = UINT8_MAX;  break;
+      case SENSE_HAT_SCHEMA_UINT16: IntMax = UINT16_MAX; break;
+      case SENSE_HAT_SCHEMA_UINT32: IntMax = UINT32_MAX; break;
+      default:
+         return true;
+   }
+
+   if (IntValue < IntMin || IntValue > IntMax)
+   {
+      return false;
+   }
+
+   switch (Field->Type)
+   {
+      case SENSE_HAT_SCHEMA_INT8:   *(int8 *)Data   = (int8)IntValue;   break;
+      case SENSE_HAT_SCHEMA_INT16:  *(int16 *)Data  = (int16)IntValue;  break;
+      case SENSE_HAT_SCHEMA_INT32:  *(int32 *)Data  = (int32)IntValue;  break;
+      case SENSE_HAT_SCHEMA_UINT8:  *(uint8 *)Data  = (uint8)IntValue;  break;
+      case SENSE_HAT_SCHEMA_UINT16: *(uint16 *)Data = (uint16)IntValue; break;
+      default:                      *(uint32 *)Data = (uint32)IntValue; break;
+   }
+
+   return true;
+
+} /* End DecodeValue() */
+
+
+/******************************************************************************
+** Function: IngestCsvTlm
+**
+** Notes:
+**   1. Loads Sense Hat telemetry parameter fields from the JMSG and queues
+**      the decoded sample for publishing.
+**   2. The parameter text is copied so it is null terminated for the value
+**      conversions regardless of what the sender put in the JMSG.
+**   3. The sequence count is tracked before the parameters are parsed so a
+**      parse failure is not also reported as a sequence gap.
+**   4. Event messages are rate limited by DIAG since this is called for
+**      every sample.
+**   5. The Pi's script status, script sync, LED frame and script output
+**      reports share the CSV telemetry topic and are identified by their JMSG name.
+**      They are routed first so only Sense HAT samples are counted and
+**      take sequence tracking sources.
+**   6. Samples are matched to scheduler sample requests before they're
+**      decoded so request latency doesn't depend on the sample contents.
+**      Request answers aren't sequence tracked, see sample_sync.h.
+**
+*/
+static bool IngestCsvTlm(void *ObjDataPtr, const CFE_MSG_Message_t *JMsgCsvTlm)
+{
+
+   SENSE_HAT_Ingest_t *Ingest = (SENSE_HAT_Ingest_t *)ObjDataPtr;
+   const JMSG_LIB_TopicCsvTlm_Payload_t *JMsgPayload = CMDMGR_PAYLOAD_PTR(JMsgCsvTlm, JMSG_LIB_TopicCsvTlm_t);
+
+   bool   RetStatus = false;
+   int    FieldCnt;
+   SAMPLE_QUEUE_Entry_t Sample;
+
+   Sample.RcvTime = CFE_TIME_GetTime();
+
+   if (PY_SCRIPT_ProcessStatusRpt(JMsgPayload->Name, JMsgPayload->ParamText) ||
+       SCRIPT_SYNC_ProcessRpt(JMsgPayload->Name, JMsgPayload->ParamText) ||
+       LED_MATRIX_ProcessRpt(JMsgPayload->Name, JMsgPayload->ParamText) ||
+       SCRIPT_OUTPUT_ProcessRpt(JMsgPayload->Name, JMsgPayload->ParamText))
+   {
+      return true;
+   }
+
+   SenseHat->RcvCnt++;
+   Sample.SeqCount  = JMsgPayload->SeqCount;
+   Sample.SourceIdx = SEQ_TRACK_UNDEF_SOURCE;
+   if (!SAMPLE_SYNC_ProcessSample(JMsgPayload->Name, Sample.SeqCount, Sample.RcvTime))
+   {
+      Sample.SourceIdx = SEQ_TRACK_ProcessSeqCount(JMsgPayload->Name, JMsgPayload->SeqCount);
+   }
+
+   strncpy(Ingest->ParamText, JMsgPayload->ParamText, JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1);
+   Ingest->ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN-1] = '\0';
+
+   if (DecodeParams(Ingest->ParamText, &Sample.Payload, &FieldCnt))
+   {
+      RetStatus = SAMPLE_QUEUE_Push(&SenseHat->PubQueue, &Sample);
+   }
+   else
+   {
+      SenseHat->ParseErrCnt++;
+      SEQ_TRACK_CountParseErr(Sample.SourceIdx);
+      if (DIAG_Count(DIAG_SENSE_HAT_PARSE_ERR))
+      {
+         CFE_EVS_SendEvent(SENSE_HAT_CREATE_TLM_EID, CFE_EVS_EventType_ERROR,
+                           "Invalid sense hat parameters. Decoded %d of %d fields before error",
+                           FieldCnt, SENSE_HAT_SCHEMA_FIELD_CNT);
+      }
+   }
+
+   return RetStatus;
+
+} /* End IngestCsvTlm() */
+
+
+/******************************************************************************
+** Function: IngestTask
+**
+** Notes:
+**   1. Returning false terminates the child task
+**   2. The receive times out so buffered script output pages are sent
+**      when no JMSGs are arriving.
+**
+*/
+static bool IngestTask(CHILDMGR_Class_t *ChildMgr)
+{
+
+   bool   RetStatus = true;
+   int32  SysStatus;
+
+   CFE_SB_Buffer_t  *SbBufPtr;
+
+
+   SysStatus = CFE_SB_ReceiveBuffer(&SbBufPtr, SenseHat->Ingest.Pipe, SENSE_HAT_INGEST_WAIT_MS);
+
+   RESOURCE_BeginWork(ASTRO_PI_ResourceTask_INGEST);
+
+   if (SysStatus == CFE_SUCCESS)
+   {
+      DISPATCH_ProcessMsg(&SenseHat->Ingest.Dispatch, SbBufPtr);
+   }
+
+   if (SysStatus == CFE_SUCCESS || SysStatus == CFE_SB_TIME_OUT || SysStatus == CFE_SB_NO_MESSAGE)
+   {
+      SCRIPT_OUTPUT_SendPages();
+   }
+   else
+   {
+      CFE_EVS_SendEvent(SENSE_HAT_INGEST_TASK_EID, CFE_EVS_EventType_CRITICAL,
+                        "Sense HAT ingest task terminating, SB receive status = 0x%08X", SysStatus);
+      RetStatus = false;
+   }
+
+   RESOURCE_EndWork(ASTRO_PI_ResourceTask_INGEST);
+
+   return RetStatus;
+
+} /* End IngestTask() */
+
+
+/******************************************************************************
+** Function: PublishSample
+**
+** Notes:
+**   1. The packet is built in an SB buffer and sent with a zero copy
+**      transmit. Ownership of the buffer passes to the SB on success.
+**   2. The packet time is the time the JMSG was received by the ingest task
+**      so queueing latency doesn't skew the sample time.
+**
+*/
+static void PublishSample(const SAMPLE_QUEUE_Entry_t *Sample)
+{
+
+   CFE_SB_Buffer_t        *SbBufPtr;
+   ASTRO_PI_SenseHatTlm_t *SenseHatTlm;
+
+   SbBufPtr = CFE_SB_AllocateMessageBuffer(sizeof(ASTRO_PI_SenseHatTlm_t));
+   if (SbBufPtr == NULL)
+   {
+      SenseHat->SbErrCnt++;
+      return;
+   }
+
+   SenseHatTlm = (ASTRO_PI_SenseHatTlm_t *)SbBufPtr;
+   CFE_MSG_Init(CFE_MSG_PTR(SenseHatTlm->TelemetryHeader), SenseHat->SenseHatTlmMid, sizeof(ASTRO_PI_SenseHatTlm_t));
+   SenseHatTlm->Payload = Sample->Payload;
+   CFE_MSG_SetMsgTime(CFE_MSG_PTR(SenseHatTlm->TelemetryHeader), Sample->RcvTime);
+
+   if (CFE_SB_TransmitBuffer(SbBufPtr, true) != CFE_SUCCESS)
+   {
+      CFE_SB_ReleaseMessageBuffer(SbBufPtr);
+      SenseHat->SbErrCnt++;
+      return;
+   }
+
+   SenseHat->SentCnt++;
+   if (DIAG_Count(DIAG_SENSE_HAT_SENT))
+   {
+      CFE_EVS_SendEvent(SENSE_HAT_CREATE_TLM_EID, CFE_EVS_EventType_DEBUG,
+                        "Sent sense hat telemetry, sequence count %u", (unsigned int)Sample->SeqCount);
+   }
+
+} /* End PublishSample() */
+
+
+/******************************************************************************
+** Function: PublishTask
+**
+** Notes:
+**   1. Samples are popped in batches to amortize the queue index updates.
+**   2. Each batch is calibrated as a whole before its samples are published.
+**   3. Each sample is passed on to the spectrum stage after it's published.
+**
+*/
+static bool PublishTask(CHILDMGR_Class_t *ChildMgr)
+{
+
+   uint32 SampleCnt;
+
+   if (SAMPLE_QUEUE_Wait(&SenseHat->PubQueue, SENSE_HAT_PUB_WAIT_MS))
+   {
+      RESOURCE_BeginWork(ASTRO_PI_ResourceTask_PUBLISH);
+
+      SampleCnt = SAMPLE_QUEUE_Pop(&SenseHat->PubQueue, SenseHat->PubBatch, SENSE_HAT_PUB_BATCH_LEN);
+
+      CALIBRATE_ApplyBatch(SenseHat->PubBatch, SampleCnt);
+
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         PublishSample(&SenseHat->PubBatch[i]);
+         SPECTRUM_PushSample(&SenseHat->PubBatch[i]);
+      }
+
+      RESOURCE_EndWork(ASTRO_PI_ResourceTask_PUBLISH);
+   }
+
+   return true;
+
+} /* End PublishTask() */
@@ -0,0 +1,149 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Manage the Sense HAT telemetry pipeline
+**
+** Notes:
+**   1. The pipeline is split into stages that each run on their own child
+**      task and are connected by SAMPLE_QUEUE lock-free queues:
+**        Ingest   - Receive JMSG CSV telemetry from its own SB pipe, track
+**                   sequence counts, decode and push to the publish queue
+**        Publish  - Pop decoded samples, calibrate them, send Sense HAT
+**                   telemetry and push to the spectrum queue
+**        Spectrum - Compute accelerometer PSDs, owned by SPECTRUM
+**   2. A slow publish stage only fills the queue, it doesn't delay ingest.
+**      When the queue is full samples are dropped and counted.
+**   3. Telemetry packets are built directly in SB allocated buffers and sent
+**      with zero copy transmits. Each stage only uses working storage in its
+**      own part of the class structure so there is no shared static state.
+**
+*/
+
+#ifndef _sense_hat_
+#define _sense_hat_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "dispatch.h"
+#include "sample_queue.h"
+#include "jmsg_platform_eds_defines.h"
+#include "jmsg_lib_eds_interface.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SENSE_HAT_PUB_WAIT_MS     1000   /* Publish task queue pend timeout */
+#define SENSE_HAT_INGEST_WAIT_MS   250   /* Ingest task SB receive timeout, limits script output paging latency */
+
+
+/*
+** Event Message IDs
+*/
+
+#define SENSE_HAT_CONSTRUCTOR_EID  (SENSE_HAT_BASE_EID + 0)
+#define SENSE_HAT_CREATE_TLM_EID   (SENSE_HAT_BASE_EID + 1)
+#define SENSE_HAT_INGEST_TASK_EID  (SENSE_HAT_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/*
+** Ingest stage working storage. Each ingest task needs its own copy of the
+** parameter text.
+*/
+typedef struct
+{
+
+   CHILDMGR_Class_t  ChildMgr;
+   CFE_SB_PipeId_t   Pipe;
+   DISPATCH_Class_t  Dispatch;
+
+   char  ParamText[JMSG_PLATFORM_TOPIC_STRING_MAX_LEN];
+
+} SENSE_HAT_Ingest_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   CHILDMGR_Class_t  PubChildMgr;
+
+   /*
+   ** Class State Data
+   */
+
+   CFE_SB_MsgId_t   SenseHatTlmMid;
+   CFE_SB_MsgId_t   JmsgTopicCsvTlmMid;
+
+   uint32  RcvCnt;
+   uint32  ParseErrCnt;
+   uint32  SentCnt;
+   uint32  SbErrCnt;     /* SB buffer allocation or transmit failures */
+
+   SENSE_HAT_Ingest_t    Ingest;
+
+   SAMPLE_QUEUE_Class_t  PubQueue;
+   SAMPLE_QUEUE_Entry_t  PubBatch[SENSE_HAT_PUB_BATCH_LEN];   /* Publish task working buffer */
+
+} SENSE_HAT_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SENSE_HAT_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Creates the ingest SB pipe, the stage queues and the child tasks.
+**      Returns false if any of these fail.
+**
+*/
+bool SENSE_HAT_Constructor(SENSE_HAT_Class_t *SenseHatPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: SENSE_HAT_GetStatus
+**
+** Load the Sense HAT pipeline fields of the app's status telemetry payload.
+**
+*/
+void SENSE_HAT_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: SENSE_HAT_ResetStatus
+**
+** Reset counters and status flags to a known reset state.
+**
+*/
+void SENSE_HAT_ResetStatus(void);
+
+
+#endif /* _sense_hat_ */
@@ -0,0 +1,493 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Track JMSG telemetry sequence counts for each remote source
+**
+** Notes:
+**   1. See seq_track.h for the classification scheme.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "diag.h"
+#include "seq_track.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static int16 AddSource(const char *SourceName, uint16 HashSlot);
+static float ComputeLossRate(uint32 RcvCnt, uint32 MissingCnt);
+static uint16 HashSourceName(const char *SourceName);
+static int16 LookupSource(const char *SourceName);
+static void ResetCounters(void);
+static void ResyncSource(SEQ_TRACK_Source_t *Source, uint32 SeqCount);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SEQ_TRACK_Class_t *SeqTrack;
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void SEQ_TRACK_Constructor(SEQ_TRACK_Class_t *SeqTrackPtr, uint32 SeqTrackTlmTopicId)
+{
+
+   SeqTrack = SeqTrackPtr;
+
+   memset(SeqTrack, 0, sizeof(SEQ_TRACK_Class_t));
+
+   SeqTrack->LastSourceIdx = SEQ_TRACK_UNDEF_SOURCE;
+
+   CFE_MSG_Init(CFE_MSG_PTR(SeqTrack->SeqTrackTlm.TelemetryHeader), CFE_SB_ValueToMsgId(SeqTrackTlmTopicId),
+                sizeof(ASTRO_PI_SeqTrackTlm_t));
+
+} /* End SEQ_TRACK_Constructor() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_CountParseErr
+**
+*/
+void SEQ_TRACK_CountParseErr(int16 SourceIdx)
+{
+
+   if (SourceIdx != SEQ_TRACK_UNDEF_SOURCE)
+   {
+      SeqTrack->Source[SourceIdx].ParseErrCnt++;
+   }
+
+} /* End SEQ_TRACK_CountParseErr() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_ProcessSeqCount
+**
+** Notes:
+**   1. Delta is the signed distance from the highest sequence count received
+**      so wrap around is handled by the unsigned subtraction.
+**   2. A late arrival that fills a previously counted gap decrements
+**      MissingCnt so the loss rate only reflects samples that never arrived
+**      within the window.
+**   3. A reset requested by SEQ_TRACK_ResetStatus() is done here so only the
+**      ingest task writes the counters.
+**
+*/
+int16 SEQ_TRACK_ProcessSeqCount(const char *SourceName, uint32 SeqCount)
+{
+
+   int16   SourceIdx;
+   int32   Delta;
+   uint64  SeqBit;
+   SEQ_TRACK_Source_t *Source;
+
+   if (__atomic_exchange_n(&SeqTrack->ResetRequest, false, __ATOMIC_ACQUIRE))
+   {
+      ResetCounters();
+   }
+
+   SourceIdx = LookupSource(SourceName);
+
+   if (SourceIdx == SEQ_TRACK_UNDEF_SOURCE)
+   {
+      SeqTrack->TableFullCnt++;
+      return SourceIdx;
+   }
+
+   Source = &SeqTrack->Source[SourceIdx];
+   Source->RcvCnt++;
+
+   if (!Source->Synced)
+   {
+      ResyncSource(Source, SeqCount);
+      return SourceIdx;
+   }
+
+   Delta = (int32)(SeqCount - Source->LastSeqCount);
+
+   if (Delta > 0)
+   {
+      if (Delta > SEQ_TRACK_RESYNC_GAP)
+      {
+         Source->ResyncCnt++;
+         if (DIAG_Count(DIAG_SEQ_RESYNC))
+         {
+            CFE_EVS_SendEvent(SEQ_TRACK_RESYNC_EID, CFE_EVS_EventType_INFORMATION,
+                              "Resynchronized source %s sequence count from %u to %u",
+                              Source->Name, (unsigned int)Source->LastSeqCount, (unsigned int)SeqCount);
+         }
+         ResyncSource(Source, SeqCount);
+      }
+      else
+      {
+         if (Delta > 1)
+         {
+            Source->GapCnt++;
+            Source->MissingCnt += (uint32)(Delta - 1);
+         }
+         Source->Window = (Delta < SEQ_TRACK_WINDOW_BITS) ? ((Source->Window << Delta) | 1) : 1;
+         Source->LastSeqCount = SeqCount;
+      }
+   }
+   else if (Delta > -SEQ_TRACK_WINDOW_BITS)
+   {
+      SeqBit = ((uint64)1) << (-Delta);
+      if (Source->Window & SeqBit)
+      {
+         Source->DupCnt++;
+      }
+      else
+      {
+         Source->Window |= SeqBit;
+         Source->ReorderCnt++;
+         if (Source->MissingCnt > 0)
+         {
+            Source->MissingCnt--;
+         }
+      }
+   }
+   else
+   {
+      /* Too old to classify, most likely the source restarted */
+      Source->ResyncCnt++;
+      if (DIAG_Count(DIAG_SEQ_RESYNC))
+      {
+         CFE_EVS_SendEvent(SEQ_TRACK_RESYNC_EID, CFE_EVS_EventType_INFORMATION,
+                           "Resynchronized source %s sequence count from %u to %u",
+                           Source->Name, (unsigned int)Source->LastSeqCount, (unsigned int)SeqCount);
+      }
+      ResyncSource(Source, SeqCount);
+   }
+
+   return SourceIdx;
+
+} /* End SEQ_TRACK_ProcessSeqCount() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_ResetStatus
+**
+*/
+void SEQ_TRACK_ResetStatus(void)
+{
+
+   __atomic_store_n(&SeqTrack->ResetRequest, true, __ATOMIC_RELEASE);
+
+} /* End SEQ_TRACK_ResetStatus() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_RestoreState
+**
+** Notes:
+**   1. Sources without a name were being added when the state was saved
+**      and are dropped.
+**
+*/
+void SEQ_TRACK_RestoreState(const SEQ_TRACK_SavedState_t *State)
+{
+
+   SEQ_TRACK_Source_t *Source;
+   uint16  SourceCnt;
+   uint16  HashSlot;
+
+   SourceCnt = (State->SourceCnt < SEQ_TRACK_MAX_SOURCES) ? State->SourceCnt : SEQ_TRACK_MAX_SOURCES;
+
+   SeqTrack->SourceCnt        = 0;
+   SeqTrack->LastSourceIdx    = SEQ_TRACK_UNDEF_SOURCE;
+   SeqTrack->TableFullCnt     = State->TableFullCnt;
+   memset(SeqTrack->HashTbl, 0, sizeof(SeqTrack->HashTbl));
+
+   for (uint16 i=0; i < SourceCnt; i++)
+   {
+      if (State->Source[i].Name[0] == '\0')
+      {
+         continue;
+      }
+
+      Source  = &SeqTrack->Source[SeqTrack->SourceCnt];
+      *Source = State->Source[i];
+      Source->Name[SEQ_TRACK_NAME_LEN-1] = '\0';
+
+      HashSlot = HashSourceName(Source->Name);
+      while (SeqTrack->HashTbl[HashSlot] != 0)
+      {
+         HashSlot = (HashSlot + 1) & (SEQ_TRACK_HASH_SLOTS-1);
+      }
+      SeqTrack->HashTbl[HashSlot] = (uint8)(++SeqTrack->SourceCnt);
+   }
+
+} /* End SEQ_TRACK_RestoreState() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_SaveState
+**
+** Notes:
+**   1. The source table is written by the Sense HAT ingest task. Like the
+**      sequence telemetry, a source's counters may be copied between two
+**      updates.
+**
+*/
+void SEQ_TRACK_SaveState(SEQ_TRACK_SavedState_t *State)
+{
+
+   State->SourceCnt        = SeqTrack->SourceCnt;
+   State->TableFullCnt     = SeqTrack->TableFullCnt;
+   memcpy(State->Source, SeqTrack->Source, sizeof(State->Source));
+
+} /* End SEQ_TRACK_SaveState() */
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_SendTlm
+**
+*/
+void SEQ_TRACK_SendTlm(void)
+{
+
+   ASTRO_PI_SeqTrackTlm_Payload_t *Payload = &SeqTrack->SeqTrackTlm.Payload;
+   ASTRO_PI_SeqSourceStats_t      *Stats;
+   SEQ_TRACK_Source_t             *Source;
+   uint32  TotalRcvCnt = 0;
+   uint32  TotalMissingCnt = 0;
+
+   memset(Payload, 0, sizeof(ASTRO_PI_SeqTrackTlm_Payload_t));
+
+   Payload->SourceCnt        = SeqTrack->SourceCnt;
+   Payload->TableFullCnt     = SeqTrack->TableFullCnt;
+
+   for (uint16 i=0; i < SeqTrack->SourceCnt; i++)
+   {
+      Source = &SeqTrack->Source[i];
+      Stats  = &Payload->Source[i];
+
+      strncpy(Stats->Name, Source->Name, SEQ_TRACK_NAME_LEN);
+      Stats->LastSeqCount = Source->LastSeqCount;
+      Stats->RcvCnt       = Source->RcvCnt;
+      Stats->GapCnt       = Source->GapCnt;
+      Stats->MissingCnt   = Source->MissingCnt;
+      Stats->DupCnt       = Source->DupCnt;
+      Stats->ReorderCnt   = Source->ReorderCnt;
+      Stats->ParseErrCnt  = Source->ParseErrCnt;
+      Stats->ResyncCnt    = Source->ResyncCnt;
+      Stats->LossRate     = ComputeLossRate(Source->RcvCnt, Source->MissingCnt);
+
+      TotalRcvCnt     += Source->RcvCnt;
+      TotalMissingCnt += Source->MissingCnt;
+   }
+
+   Payload->TotalRcvCnt     = TotalRcvCnt;
+   Payload->TotalMissingCnt = TotalMissingCnt;
+   Payload->LossRate        = ComputeLossRate(TotalRcvCnt, TotalMissingCnt);
+
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(SeqTrack->SeqTrackTlm.TelemetryHeader));
+   CFE_SB_TransmitMsg(CFE_MSG_PTR(SeqTrack->SeqTrackTlm.TelemetryHeader), true);
+
+} /* End SEQ_TRACK_SendTlm() */
+
+
+/******************************************************************************
+** Function: AddSource
+**
+** Notes:
+**   1. HashSlot must be an empty slot found by LookupSource()
+**
+*/
+static int16 AddSource(const char *SourceName, uint16 HashSlot)
+{
+
+   int16 SourceIdx = SEQ_TRACK_UNDEF_SOURCE;
+
+   if (SeqTrack->SourceCnt < SEQ_TRACK_MAX_SOURCES)
+   {
+      SourceIdx = SeqTrack->SourceCnt++;
+      strncpy(SeqTrack->Source[SourceIdx].Name, SourceName, SEQ_TRACK_NAME_LEN-1);
+      SeqTrack->HashTbl[HashSlot] = (uint8)(SourceIdx + 1);
+      CFE_EVS_SendEvent(SEQ_TRACK_NEW_SOURCE_EID, CFE_EVS_EventType_INFORMATION,
+                        "Tracking sequence counts for new source %s", SeqTrack->Source[SourceIdx].Name);
+   }
+   else
+   {
+      CFE_EVS_SendEvent(SEQ_TRACK_TBL_FULL_EID, CFE_EVS_EventType_ERROR,
+                        "Source %s not tracked, all %d source table entries are in use",
+                        SourceName, SEQ_TRACK_MAX_SOURCES);
+   }
+
+   return SourceIdx;
+
+} /* End AddSource() */
+
+
+/******************************************************************************
+** Function: ComputeLossRate
+**
+** Return the percentage of expected messages that were never received.
+**
+*/
+static float ComputeLossRate(uint32 RcvCnt, uint32 MissingCnt)
+{
+
+   float LossRate = 0.0;
+
+   if ((RcvCnt + MissingCnt) > 0)
+   {
+      LossRate = (100.0 * (float)MissingCnt) / (float)(RcvCnt + MissingCnt);
+   }
+
+   return LossRate;
+
+} /* End ComputeLossRate() */
+
+
+/******************************************************************************
+** Function: HashSourceName
+**
+** FNV-1a hash of the source name reduced to a hash table slot.
+**
+*/
+static uint16 HashSourceName(const char *SourceName)
+{
+
+   uint32 Hash = 2166136261u;
+
+   for (uint16 i=0; (i < (SEQ_TRACK_NAME_LEN-1)) && (SourceName[i] != '\0'); i++)
+   {
+      Hash ^= (uint8)SourceName[i];
+      Hash *= 16777619u;
+   }
+
+   return (uint16)(Hash & (SEQ_TRACK_HASH_SLOTS-1));
+
+} /* End HashSourceName() */
+
+
+/******************************************************************************
+** Function: LookupSource
+**
+** Notes:
+**   1. Uses linear probing. The table has twice as many slots as sources so
+**      an empty slot always terminates the probe.
+**   2. New sources are added when an empty slot is reached.
+**
+*/
+static int16 LookupSource(const char *SourceName)
+{
+
+   int16   SourceIdx = SeqTrack->LastSourceIdx;
+   uint16  HashSlot;
+
+
+   if (SourceIdx != SEQ_TRACK_UNDEF_SOURCE)
+   {
+      if (strncmp(SeqTrack->Source[SourceIdx].Name, SourceName, SEQ_TRACK_NAME_LEN-1) == 0)
+      {
+         return SourceIdx;
+      }
+   }
+
+   SourceIdx = SEQ_TRACK_UNDEF_SOURCE;
+   HashSlot  = HashSourceName(SourceName);
+
+   for (uint16 i=0; i < SEQ_TRACK_HASH_SLOTS; i++)
+   {
+      if (SeqTrack->HashTbl[HashSlot] == 0)
+      {
+         SourceIdx = AddSource(SourceName, HashSlot);
+         break;
+      }
+      if (strncmp(SeqTrack->Source[SeqTrack->HashTbl[HashSlot]-1].Name, SourceName, SEQ_TRACK_NAME_LEN-1) == 0)
+      {
+         SourceIdx = SeqTrack->HashTbl[HashSlot] - 1;
+         break;
+      }
+      HashSlot = (HashSlot + 1) & (SEQ_TRACK_HASH_SLOTS-1);
+   }
+
+   if (SourceIdx != SEQ_TRACK_UNDEF_SOURCE)
+   {
+      SeqTrack->LastSourceIdx = SourceIdx;
+   }
+
+   return SourceIdx;
+
+} /* End LookupSource() */
+
+
+/******************************************************************************
+** Function: ResetCounters
+**
+** Notes:
+**   1. Only called by the ingest task. Sources stay registered.
+**
+*/
+static void ResetCounters(void)
+{
+
+   SEQ_TRACK_Source_t *Source;
+
+   SeqTrack->TableFullCnt = 0;
+
+   for (uint16 i=0; i < SeqTrack->SourceCnt; i++)
+   {
+      Source = &SeqTrack->Source[i];
+      Source->Synced       = false;
+      Source->LastSeqCount = 0;
+      Source->Window       = 0;
+      Source->RcvCnt       = 0;
+      Source->GapCnt       = 0;
+      Source->MissingCnt   = 0;
+      Source->DupCnt       = 0;
+      Source->ReorderCnt   = 0;
+      Source->ParseErrCnt  = 0;
+      Source->ResyncCnt    = 0;
+   }
+
+} /* End ResetCounters() */
+
+
+/******************************************************************************
+** Function: ResyncSource
+**
+*/
+static void ResyncSource(SEQ_TRACK_Source_t *Source, uint32 SeqCount)
+{
+
+   Source->Synced       = true;
+   Source->LastSeqCount = SeqCount;
+   Source->Window       = 1;
+
+} /* End ResyncSource() */
@@ -0,0 +1,205 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Track JMSG telemetry sequence counts for each remote source
+**
+** Notes:
+**   1. Each source is identified by the JMSG "name" field and tracked
+**      independently. Sources are added on first reception until the
+**      table is full.
+**   2. A sliding bit window of the most recently received sequence counts
+**      is used to classify each message as in-order, a gap, a duplicate or
+**      a late (reordered) arrival. All operations are O(1) per message.
+**   3. Sequence counts are treated as 32-bit unsigned values that may wrap.
+**
+*/
+
+#ifndef _seq_track_
+#define _seq_track_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+#define SEQ_TRACK_NAME_LEN     OS_MAX_API_NAME
+#define SEQ_TRACK_WINDOW_BITS  64                            /* Width of the received sequence count bit window */
+#define SEQ_TRACK_HASH_SLOTS   (2*SEQ_TRACK_MAX_SOURCES)     /* Must be a power of 2 */
+#define SEQ_TRACK_RESYNC_GAP   1000                          /* Forward jumps larger than this are treated as a source restart */
+#define SEQ_TRACK_UNDEF_SOURCE (-1)
+
+/*
+** Event Message IDs
+*/
+
+#define SEQ_TRACK_NEW_SOURCE_EID   (SEQ_TRACK_BASE_EID + 0)
+#define SEQ_TRACK_TBL_FULL_EID     (SEQ_TRACK_BASE_EID + 1)
+#define SEQ_TRACK_RESYNC_EID       (SEQ_TRACK_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   char    Name[SEQ_TRACK_NAME_LEN];
+   bool    Synced;
+
+   uint32  LastSeqCount;    /* Highest sequence count received */
+   uint64  Window;          /* Bit n set if (LastSeqCount-n) has been received */
+
+   uint32  RcvCnt;
+   uint32  GapCnt;          /* Number of forward jumps in the sequence count */
+   uint32  MissingCnt;      /* Sequence counts skipped and not yet recovered by a late arrival */
+   uint32  DupCnt;
+   uint32  ReorderCnt;
+   uint32  ParseErrCnt;
+   uint32  ResyncCnt;
+
+} SEQ_TRACK_Source_t;
+
+
+/*
+** Source table kept in the app's Critical Data Store so sequence tracking
+** continues across a warm restart without a resync
+*/
+typedef struct
+{
+
+   uint16  SourceCnt;
+   uint32  TableFullCnt;
+
+   SEQ_TRACK_Source_t Source[SEQ_TRACK_MAX_SOURCES];
+
+} SEQ_TRACK_SavedState_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Telemetry Packets
+   */
+
+   ASTRO_PI_SeqTrackTlm_t  SeqTrackTlm;
+
+   /*
+   ** Class State Data
+   */
+
+   uint16  SourceCnt;
+   int16   LastSourceIdx;   /* Most messages come from the same source so check it before hashing */
+   uint32  TableFullCnt;    /* Messages from sources not tracked because the table is full */
+   bool    ResetRequest;    /* Set by the main task, the ingest task resets the counters */
+
+   uint8   HashTbl[SEQ_TRACK_HASH_SLOTS];   /* Source index+1, 0 indicates an empty slot */
+
+   SEQ_TRACK_Source_t Source[SEQ_TRACK_MAX_SOURCES];
+
+} SEQ_TRACK_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**
+*/
+void SEQ_TRACK_Constructor(SEQ_TRACK_Class_t *SeqTrackPtr, uint32 SeqTrackTlmTopicId);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_CountParseErr
+**
+** Notes:
+**   1. SourceIdx is the value returned by SEQ_TRACK_ProcessSeqCount() and
+**      SEQ_TRACK_UNDEF_SOURCE is ignored.
+**
+*/
+void SEQ_TRACK_CountParseErr(int16 SourceIdx);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_ProcessSeqCount
+**
+** Classify a received sequence count and update the source's counters.
+**
+** Notes:
+**   1. Returns the source index or SEQ_TRACK_UNDEF_SOURCE if the source table
+**      is full and the source is not being tracked.
+**
+*/
+int16 SEQ_TRACK_ProcessSeqCount(const char *SourceName, uint32 SeqCount);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_ResetStatus
+**
+** Reset counters and status flags to a known reset state.
+**
+** Notes:
+**   1. Sources remain registered but are resynchronized on their next message.
+**   2. The counters are owned by the Sense HAT ingest task so this only
+**      requests the reset. It's done when the next message is processed.
+**
+*/
+void SEQ_TRACK_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_RestoreState
+**
+** Restore the source table saved by SEQ_TRACK_SaveState().
+**
+** Notes:
+**   1. Only called during app initialization before the child tasks start.
+**   2. The hash table is rebuilt from the restored source names.
+**
+*/
+void SEQ_TRACK_RestoreState(const SEQ_TRACK_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_SaveState
+**
+** Copy the source table into State.
+**
+*/
+void SEQ_TRACK_SaveState(SEQ_TRACK_SavedState_t *State);
+
+
+/******************************************************************************
+** Function: SEQ_TRACK_SendTlm
+**
+*/
+void SEQ_TRACK_SendTlm(void);
+
+
+#endif /* _seq_track_ */
@@ -0,0 +1,413 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compute accelerometer vibration power spectral densities
+**
+** Notes:
+**   1. See spectrum.h for the PSD estimate definition.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include <math.h>
+#include "spectrum.h"
+#include "resource.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SPECTRUM_PI  3.14159265358979323846
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static void AddSample(const SAMPLE_QUEUE_Entry_t *Sample);
+static void ClearPsd(void);
+static void ProcessSegment(void);
+static void SendPsdTlm(void);
+static bool SpectrumTask(CHILDMGR_Class_t *ChildMgr);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static SPECTRUM_Class_t *Spectrum;
+
+
+/******************************************************************************
+** Function: SPECTRUM_Constructor
+**
+** Notes:
+**   1. Each band must span at least one bin so the segment length must be
+**      at least 2*SPECTRUM_PSD_BANDS.
+**
+*/
+bool SPECTRUM_Constructor(SPECTRUM_Class_t *SpectrumPtr, INITBL_Class_t *IniTbl)
+{
+
+   int32  SysStatus;
+   CHILDMGR_TaskInit_t ChildTaskInit;
+
+   Spectrum = SpectrumPtr;
+
+   memset(Spectrum, 0, sizeof(SPECTRUM_Class_t));
+
+   Spectrum->SegmentLen     = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_SEGMENT_LEN);
+   Spectrum->SegmentsPerPsd = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_SEGMENTS_PER_PSD);
+
+   if (Spectrum->SegmentLen < 2*SPECTRUM_PSD_BANDS || Spectrum->SegmentsPerPsd == 0 ||
+       !FFT_Constructor(&Spectrum->Fft, Spectrum->SegmentLen))
+   {
+      CFE_EVS_SendEvent(SPECTRUM_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Invalid spectrum configuration. Segment length %d must be a power of 2 from %d to %d and segments per PSD %d must be non-zero",
+                        Spectrum->SegmentLen, 2*SPECTRUM_PSD_BANDS, FFT_MAX_LEN, Spectrum->SegmentsPerPsd);
+      return false;
+   }
+
+   for (uint16 n=0; n < Spectrum->SegmentLen; n++)
+   {
+      Spectrum->Window[n] = (float)(0.5 - 0.5*cos(2.0*SPECTRUM_PI*n/Spectrum->SegmentLen));
+      Spectrum->WindowPowerSum += Spectrum->Window[n]*Spectrum->Window[n];
+   }
+
+   Spectrum->PsdTlmMid = CFE_SB_ValueToMsgId(INITBL_GetIntConfig(IniTbl, CFG_ASTRO_PI_PSD_TLM_TOPICID));
+
+   if (!SAMPLE_QUEUE_Constructor(&Spectrum->Queue, "SPEC_Q"))
+   {
+      CFE_EVS_SendEvent(SPECTRUM_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Spectrum constructor failed to create the queue semaphore");
+      return false;
+   }
+
+   ChildTaskInit.TaskName  = INITBL_GetStrConfig(IniTbl, CFG_SPECTRUM_CHILD_NAME);
+   ChildTaskInit.StackSize = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_CHILD_STACK_SIZE);
+   ChildTaskInit.Priority  = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_CHILD_PRIORITY);
+   ChildTaskInit.PerfId    = INITBL_GetIntConfig(IniTbl, CFG_SPECTRUM_CHILD_PERF_ID);
+   SysStatus = CHILDMGR_Constructor(&Spectrum->ChildMgr, ChildMgr_TaskMainCallback,
+                                    SpectrumTask, &ChildTaskInit);
+   if (SysStatus != CFE_SUCCESS)
+   {
+      CFE_EVS_SendEvent(SPECTRUM_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Spectrum constructor failed to create child task. Status = 0x%08X", SysStatus);
+      return false;
+   }
+
+   return true;
+
+} /* End SPECTRUM_Constructor() */
+
+
+/******************************************************************************
+** Function: SPECTRUM_GetStatus
+**
+*/
+void SPECTRUM_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   ASTRO_PI_SpectrumStats_t *Stats = &Spectrum->Stats;
+
+   Stats->AvgSegmentUs = (Stats->SegmentCnt > 0) ? (uint32)(Spectrum->SegmentTimeSumUs / Stats->SegmentCnt) : 0;
+   SAMPLE_QUEUE_GetStats(&Spectrum->Queue, &Stats->Queue);
+
+   Payload->Spectrum = *Stats;
+
+} /* End SPECTRUM_GetStatus() */
+
+
+/******************************************************************************
+** Function: SPECTRUM_PushSample
+**
+*/
+void SPECTRUM_PushSample(const SAMPLE_QUEUE_Entry_t *Sample)
+{
+
+   SAMPLE_QUEUE_Push(&Spectrum->Queue, Sample);
+
+} /* End SPECTRUM_PushSample() */
+
+
+/******************************************************************************
+** Function: SPECTRUM_ResetStatus
+**
+*/
+void SPECTRUM_ResetStatus(void)
+{
+
+   memset(&Spectrum->Stats, 0, sizeof(Spectrum->Stats));
+   Spectrum->SegmentTimeSumUs = 0;
+
+   SAMPLE_QUEUE_ResetStatus(&Spectrum->Queue);
+
+} /* End SPECTRUM_ResetStatus() */
+
+
+/******************************************************************************
+** Function: AddSample
+**
+** Notes:
+**   1. A full segment is processed and its second half becomes the first
+**      half of the next segment.
+**   2. A partial segment is discarded if Sample isn't the next sample from
+**      the segment's source. See spectrum.h.
+**
+*/
+static void AddSample(const SAMPLE_QUEUE_Entry_t *Sample)
+{
+
+   uint16 Half = Spectrum->SegmentLen/2;
+
+   if (Spectrum->SampleCnt > 0 &&
+       (Sample->SourceIdx != Spectrum->SourceIdx || Sample->SeqCount != Spectrum->LastSeqCount+1))
+   {
+      Spectrum->Stats.SeqGapCnt++;
+      Spectrum->SampleCnt = 0;
+   }
+   Spectrum->SourceIdx    = Sample->SourceIdx;
+   Spectrum->LastSeqCount = Sample->SeqCount;
+
+   Spectrum->Time[Spectrum->SampleCnt]      = Sample->RcvTime;
+   Spectrum->Sample[0][Spectrum->SampleCnt] = Sample->Payload.AccelX;
+   Spectrum->Sample[1][Spectrum->SampleCnt] = Sample->Payload.AccelY;
+   Spectrum->Sample[2][Spectrum->SampleCnt] = Sample->Payload.AccelZ;
+   Spectrum->SampleCnt++;
+
+   if (Spectrum->SampleCnt == Spectrum->SegmentLen)
+   {
+      ProcessSegment();
+
+      memmove(Spectrum->Time, &Spectrum->Time[Half], Half*sizeof(CFE_TIME_SysTime_t));
+      for (int Axis=0; Axis < SPECTRUM_AXES; Axis++)
+      {
+         memmove(Spectrum->Sample[Axis], &Spectrum->Sample[Axis][Half], Half*sizeof(float));
+      }
+      Spectrum->SampleCnt = Half;
+   }
+
+} /* End AddSample() */
+
+
+/******************************************************************************
+** Function: ClearPsd
+**
+** Clear the PSD accumulators.
+**
+*/
+static void ClearPsd(void)
+{
+
+   memset(Spectrum->Density, 0, sizeof(Spectrum->Density));
+   Spectrum->SampleRateSum = 0.0f;
+   Spectrum->PsdSegmentCnt = 0;
+
+} /* End ClearPsd() */
+
+
+/******************************************************************************
+** Function: ProcessSegment
+**
+** Add the current segment's one-sided densities to the PSD accumulators.
+**
+** Notes:
+**   1. Density = 2*|X[k]|^2/(fs*sum(w^2)) except the DC bin which isn't
+**      doubled.
+**
+*/
+static void ProcessSegment(void)
+{
+
+   ASTRO_PI_SpectrumStats_t *Stats = &Spectrum->Stats;
+   uint16  Len  = Spectrum->SegmentLen;
+   uint16  Half = Len/2;
+   CFE_TIME_SysTime_t Span;
+   float   SpanSec;
+   float   SampleRate;
+   float   Scale;
+   float   Mean;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+   uint32     TimeUs;
+
+   Span    = CFE_TIME_Subtract(Spectrum->Time[Len-1], Spectrum->Time[0]);
+   SpanSec = (float)Span.Seconds + (float)CFE_TIME_Sub2MicroSecs(Span.Subseconds)/1000000.0f;
+
+   /* CFE_TIME_Subtract wraps a negative span to a large positive value */
+   if (CFE_TIME_Compare(Spectrum->Time[Len-1], Spectrum->Time[0]) != CFE_TIME_A_GT_B || SpanSec <= 0.0f)
+   {
+      Stats->SkippedSegmentCnt++;
+      return;
+   }
+   SampleRate = (float)(Len-1)/SpanSec;
+   Scale = 2.0f/(SampleRate*Spectrum->WindowPowerSum);
+
+   OS_GetLocalTime(&StartTime);
+
+   for (int Axis=0; Axis < SPECTRUM_AXES; Axis++)
+   {
+
+      Mean = 0.0f;
+      for (uint16 n=0; n < Len; n++)
+      {
+         Mean += Spectrum->Sample[Axis][n];
+      }
+      Mean /= Len;
+
+      for (uint16 n=0; n < Len; n++)
+      {
+         Spectrum->Work[n] = (Spectrum->Sample[Axis][n] - Mean)*Spectrum->Window[n];
+      }
+
+      FFT_RealPower(&Spectrum->Fft, Spectrum->Work, Spectrum->Power);
+
+      Spectrum->Density[Axis][0] += 0.5f*Scale*Spectrum->Power[0];
+      for (uint16 k=1; k < Half; k++)
+      {
+         Spectrum->Density[Axis][k] += Scale*Spectrum->Power[k];
+      }
+
+   } /* End axis loop */
+
+   OS_GetLocalTime(&EndTime);
+
+   TimeUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+
+   Stats->SegmentCnt++;
+   Stats->LastSegmentUs = TimeUs;
+   if (TimeUs > Stats->MaxSegmentUs)
+   {
+      Stats->MaxSegmentUs = TimeUs;
+   }
+   Spectrum->SegmentTimeSumUs += TimeUs;
+
+   Spectrum->SampleRateSum += SampleRate;
+   Spectrum->PsdSegmentCnt++;
+
+   if (Spectrum->PsdSegmentCnt >= Spectrum->SegmentsPerPsd)
+   {
+      SendPsdTlm();
+   }
+
+} /* End ProcessSegment() */
+
+
+/******************************************************************************
+** Function: SendPsdTlm
+**
+** Average the accumulated densities into bands, send the PSD packet and
+** clear the accumulators.
+**
+** Notes:
+**   1. The packet is built in an SB buffer and sent with a zero copy
+**      transmit. The accumulators are cleared even if the packet can't be
+**      sent so the next PSD only covers its own segments.
+**
+*/
+static void SendPsdTlm(void)
+{
+
+   CFE_SB_Buffer_t           *SbBufPtr;
+   ASTRO_PI_PsdTlm_t         *PsdTlm;
+   ASTRO_PI_PsdTlm_Payload_t *Payload;
+   float  *Band[SPECTRUM_AXES];
+   uint16 BinsPerBand = (Spectrum->SegmentLen/2)/SPECTRUM_PSD_BANDS;
+   float  BandSum;
+
+   SbBufPtr = CFE_SB_AllocateMessageBuffer(sizeof(ASTRO_PI_PsdTlm_t));
+   if (SbBufPtr == NULL)
+   {
+      Spectrum->Stats.PsdSbErrCnt++;
+      ClearPsd();
+      return;
+   }
+
+   PsdTlm  = (ASTRO_PI_PsdTlm_t *)SbBufPtr;
+   Payload = &PsdTlm->Payload;
+   CFE_MSG_Init(CFE_MSG_PTR(PsdTlm->TelemetryHeader), Spectrum->PsdTlmMid, sizeof(ASTRO_PI_PsdTlm_t));
+
+   Band[0] = Payload->AccelX;
+   Band[1] = Payload->AccelY;
+   Band[2] = Payload->AccelZ;
+
+   Payload->SegmentLen   = Spectrum->SegmentLen;
+   Payload->SegmentCnt   = Spectrum->PsdSegmentCnt;
+   Payload->SampleRateHz = Spectrum->SampleRateSum/Spectrum->PsdSegmentCnt;
+   Payload->BandWidthHz  = Payload->SampleRateHz*BinsPerBand/Spectrum->SegmentLen;
+
+   for (int Axis=0; Axis < SPECTRUM_AXES; Axis++)
+   {
+      for (uint16 b=0; b < SPECTRUM_PSD_BANDS; b++)
+      {
+         BandSum = 0.0f;
+         for (uint16 k=b*BinsPerBand; k < (b+1)*BinsPerBand; k++)
+         {
+            BandSum += Spectrum->Density[Axis][k];
+         }
+         Band[Axis][b] = BandSum/(BinsPerBand*Spectrum->PsdSegmentCnt);
+      }
+   }
+
+   CFE_SB_TimeStampMsg(CFE_MSG_PTR(PsdTlm->TelemetryHeader));
+   if (CFE_SB_TransmitBuffer(SbBufPtr, true) == CFE_SUCCESS)
+   {
+      Spectrum->Stats.PsdCnt++;
+   }
+   else
+   {
+      CFE_SB_ReleaseMessageBuffer(SbBufPtr);
+      Spectrum->Stats.PsdSbErrCnt++;
+   }
+
+   ClearPsd();
+
+} /* End SendPsdTlm() */
+
+
+/******************************************************************************
+** Function: SpectrumTask
+**
+*/
+static bool SpectrumTask(CHILDMGR_Class_t *ChildMgr)
+{
+
+   uint32 SampleCnt;
+
+   if (SAMPLE_QUEUE_Wait(&Spectrum->Queue, SPECTRUM_WAIT_MS))
+   {
+      RESOURCE_BeginWork(ASTRO_PI_ResourceTask_SPECTRUM);
+
+      SampleCnt = SAMPLE_QUEUE_Pop(&Spectrum->Queue, Spectrum->Batch, SPECTRUM_BATCH_LEN);
+
+      for (uint32 i=0; i < SampleCnt; i++)
+      {
+         AddSample(&Spectrum->Batch[i]);
+      }
+
+      RESOURCE_EndWork(ASTRO_PI_ResourceTask_SPECTRUM);
+   }
+
+   return true;
+
+} /* End SpectrumTask() */
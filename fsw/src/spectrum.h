@@ -0,0 +1,166 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Compute accelerometer vibration power spectral densities
+**
+** Notes:
+**   1. This is the last Sense HAT pipeline stage. The publish task pushes
+**      each published sample to this stage's queue and the spectrum child
+**      task pops them so FFT processing never delays publishing.
+**   2. PSDs are estimated with Welch's method. Each axis is split into
+**      segments of SegmentLen samples that overlap by 50%. Each segment has
+**      its mean removed, is Hann windowed and transformed, and the one-sided
+**      densities of SegmentsPerPsd segments are averaged.
+**   3. The Pi doesn't report its sample rate so each segment's rate is
+**      estimated from its receive times. Segments with a non-increasing
+**      time span are skipped.
+**   4. The PSD telemetry packet reports SPECTRUM_PSD_BANDS bands per axis.
+**      Each band is the mean density of the adjacent bins it spans, the
+**      Nyquist bin is not reported. Units are g^2/Hz.
+**   5. The compute time of each segment's three transforms is measured so
+**      the cost on the target CPU can be seen in the status telemetry.
+**   6. A segment must be one source's consecutive samples. Free running
+**      and sync response samples have separate sequence counts, so the
+**      partial segment is discarded when the source changes or a sequence
+**      count is missing. Missing samples include those dropped because
+**      this stage's queue was full.
+**
+*/
+
+#ifndef _spectrum_
+#define _spectrum_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "fft.h"
+#include "sample_queue.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define SPECTRUM_AXES     3
+#define SPECTRUM_WAIT_MS  1000   /* Spectrum task queue pend timeout */
+
+
+/*
+** Event Message IDs
+*/
+
+#define SPECTRUM_CONSTRUCTOR_EID  (SPECTRUM_BASE_EID + 0)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   /*
+   ** Framework References
+   */
+
+   CHILDMGR_Class_t  ChildMgr;
+
+   /*
+   ** Class State Data
+   */
+
+   CFE_SB_MsgId_t  PsdTlmMid;
+
+   uint16  SegmentLen;
+   uint16  SegmentsPerPsd;
+   uint16  SampleCnt;           /* Samples in the current segment */
+   uint16  PsdSegmentCnt;       /* Segments accumulated in the current PSD */
+   int16   SourceIdx;           /* Source of the samples in the current segment */
+   uint32  LastSeqCount;        /* Sequence count of the current segment's last sample */
+
+   float   SampleRateSum;       /* Sum of the accumulated segments' sample rates */
+   float   WindowPowerSum;      /* Sum of the squared window coefficients */
+
+   uint64  SegmentTimeSumUs;
+   ASTRO_PI_SpectrumStats_t  Stats;
+
+   SAMPLE_QUEUE_Class_t  Queue;
+   SAMPLE_QUEUE_Entry_t  Batch[SPECTRUM_BATCH_LEN];       /* Spectrum task working buffer */
+
+   CFE_TIME_SysTime_t  Time[FFT_MAX_LEN];
+   float   Sample[SPECTRUM_AXES][FFT_MAX_LEN];
+   float   Window[FFT_MAX_LEN];
+   float   Work[FFT_MAX_LEN];
+   float   Power[FFT_MAX_LEN/2+1];
+   float   Density[SPECTRUM_AXES][FFT_MAX_LEN/2];         /* Accumulated one-sided density, Nyquist bin excluded */
+
+   FFT_Class_t  Fft;
+
+} SPECTRUM_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: SPECTRUM_Constructor
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Returns false if the segment configuration is invalid or the queue
+**      or child task can't be created.
+**
+*/
+bool SPECTRUM_Constructor(SPECTRUM_Class_t *SpectrumPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: SPECTRUM_GetStatus
+**
+** Load the spectrum fields of the app's status telemetry payload.
+**
+*/
+void SPECTRUM_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: SPECTRUM_PushSample
+**
+** Queue a published sample for spectrum processing.
+**
+** Notes:
+**   1. Only called by the Sense HAT publish task. A full queue drops the
+**      sample and the drop is counted in the queue statistics. The spectrum
+**      task sees the drop as a sequence gap and discards its partial
+**      segment.
+**
+*/
+void SPECTRUM_PushSample(const SAMPLE_QUEUE_Entry_t *Sample);
+
+
+/******************************************************************************
+** Function: SPECTRUM_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+*/
+void SPECTRUM_ResetStatus(void);
+
+
+#endif /* _spectrum_ */
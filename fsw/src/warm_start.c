@@ -0,0 +1,279 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Preserve the app's state across warm restarts in the Critical Data Store
+**
+** Notes:
+**   1. See warm_start.h for the CDS block design.
+**
+*/
+
+/*
+** Includes
+*/
+
+#include "warm_start.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+/********************************** **/
+/** Local File Function Prototypes **/
+/************************************/
+
+static uint32 ComputeDataCrc(void);
+static uint16 RestoreState(void);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static WARM_START_Class_t *WarmStart;
+
+
+/******************************************************************************
+** Function: WARM_START_Constructor
+**
+*/
+void WARM_START_Constructor(WARM_START_Class_t *WarmStartPtr, INITBL_Class_t *IniTbl)
+{
+
+   int32      SysStatus;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+   const char *CdsName;
+
+   WarmStart = WarmStartPtr;
+
+   memset(WarmStart, 0, sizeof(WARM_START_Class_t));
+
+   WarmStart->SavePeriod = INITBL_GetIntConfig(IniTbl, CFG_WARM_START_SAVE_PERIOD);
+   CdsName = INITBL_GetStrConfig(IniTbl, CFG_WARM_START_CDS_NAME);
+
+   OS_GetLocalTime(&StartTime);
+
+   SysStatus = CFE_ES_RegisterCDS(&WarmStart->CdsHandle, sizeof(WARM_START_Block_t), CdsName);
+   if (SysStatus == CFE_ES_CDS_ALREADY_EXISTS)
+   {
+      WarmStart->CdsRegistered = true;
+      WarmStart->Stats.Result  = RestoreState();
+   }
+   else if (SysStatus == CFE_SUCCESS)
+   {
+      WarmStart->CdsRegistered = true;
+      WarmStart->Stats.Result  = ASTRO_PI_WarmStartResult_COLD;
+   }
+   else
+   {
+      WarmStart->Stats.Result = ASTRO_PI_WarmStartResult_CDS_ERR;
+      CFE_EVS_SendEvent(WARM_START_CONSTRUCTOR_EID, CFE_EVS_EventType_ERROR,
+                        "Error registering CDS block %s, state will not be saved. Status = 0x%08X",
+                        CdsName, (unsigned int)SysStatus);
+   }
+
+   OS_GetLocalTime(&EndTime);
+   WarmStart->Stats.RestoreUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+
+   if (WarmStart->Stats.Result == ASTRO_PI_WarmStartResult_RESTORED)
+   {
+      CFE_EVS_SendEvent(WARM_START_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION,
+                        "Warm start, state restored from CDS block %s in %u us",
+                        CdsName, (unsigned int)WarmStart->Stats.RestoreUs);
+   }
+   else if (WarmStart->Stats.Result != ASTRO_PI_WarmStartResult_CDS_ERR)
+   {
+      CFE_EVS_SendEvent(WARM_START_CONSTRUCTOR_EID, CFE_EVS_EventType_INFORMATION,
+                        "Cold start, %s saved state in CDS block %s",
+                        (WarmStart->Stats.Result == ASTRO_PI_WarmStartResult_COLD) ? "no" : "discarded invalid",
+                        CdsName);
+   }
+
+} /* End WARM_START_Constructor() */
+
+
+/******************************************************************************
+** Function: WARM_START_GetStatus
+**
+*/
+void WARM_START_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload)
+{
+
+   Payload->WarmStart = WarmStart->Stats;
+
+} /* End WARM_START_GetStatus() */
+
+
+/******************************************************************************
+** Function: WARM_START_ResetStatus
+**
+*/
+void WARM_START_ResetStatus(void)
+{
+
+   WarmStart->Stats.SaveCnt    = 0;
+   WarmStart->Stats.SaveErrCnt = 0;
+   WarmStart->Stats.LastSaveUs = 0;
+
+} /* End WARM_START_ResetStatus() */
+
+
+/******************************************************************************
+** Function: WARM_START_Save
+**
+*/
+void WARM_START_Save(void)
+{
+
+   WARM_START_Block_t *Block;
+   int32      SysStatus;
+   OS_time_t  StartTime;
+   OS_time_t  EndTime;
+
+   if (WarmStart == NULL || !WarmStart->CdsRegistered)
+   {
+      return;
+   }
+
+   Block = &WarmStart->Block;
+
+   OS_GetLocalTime(&StartTime);
+
+   PY_SCRIPT_SaveState(&Block->Data.PyScript);
+   SAMPLE_SYNC_SaveState(&Block->Data.SampleSync);
+   SCRIPT_SYNC_SaveState(&Block->Data.ScriptSync);
+   SEQ_TRACK_SaveState(&Block->Data.SeqTrack);
+
+   Block->Header.Version = WARM_START_VERSION;
+   Block->Header.DataLen = sizeof(WARM_START_Data_t);
+   Block->Header.DataCrc = ComputeDataCrc();
+
+   SysStatus = CFE_ES_CopyToCDS(WarmStart->CdsHandle, Block);
+
+   OS_GetLocalTime(&EndTime);
+
+   if (SysStatus == CFE_SUCCESS)
+   {
+      WarmStart->Stats.SaveCnt++;
+      WarmStart->Stats.LastSaveUs = (uint32)OS_TimeGetTotalMicroseconds(OS_TimeSubtract(EndTime, StartTime));
+      WarmStart->LastSaveFailed   = false;
+   }
+   else
+   {
+      WarmStart->Stats.SaveErrCnt++;
+      if (!WarmStart->LastSaveFailed)
+      {
+         CFE_EVS_SendEvent(WARM_START_SAVE_EID, CFE_EVS_EventType_ERROR,
+                           "Error saving state to the CDS. Status = 0x%08X", (unsigned int)SysStatus);
+      }
+      WarmStart->LastSaveFailed = true;
+   }
+
+} /* End WARM_START_Save() */
+
+
+/******************************************************************************
+** Function: WARM_START_Tick
+**
+*/
+void WARM_START_Tick(void)
+{
+
+   if (WarmStart->SavePeriod == 0)
+   {
+      return;
+   }
+
+   if (++WarmStart->TickCnt >= WarmStart->SavePeriod)
+   {
+      WarmStart->TickCnt = 0;
+      WARM_START_Save();
+   }
+
+} /* End WARM_START_Tick() */
+
+
+/******************************************************************************
+** Function: ComputeDataCrc
+**
+** CRC of the working buffer's data.
+**
+*/
+static uint32 ComputeDataCrc(void)
+{
+
+   return CFE_ES_CalculateCRC(&WarmStart->Block.Data, sizeof(WARM_START_Data_t), 0, CFE_ES_CrcType_CRC_16);
+
+} /* End ComputeDataCrc() */
+
+
+/******************************************************************************
+** Function: RestoreState
+**
+** Read the CDS block and restore each object's state if the block is valid.
+**
+** Notes:
+**   1. Returns an ASTRO_PI_WarmStartResult_Enum_t.
+**   2. Objects keep their constructed state if the block is invalid.
+**
+*/
+static uint16 RestoreState(void)
+{
+
+   WARM_START_Block_t *Block = &WarmStart->Block;
+   int32  SysStatus;
+   uint32 DataCrc;
+
+   SysStatus = CFE_ES_RestoreFromCDS(Block, WarmStart->CdsHandle);
+   if (SysStatus != CFE_SUCCESS)
+   {
+      CFE_EVS_SendEvent(WARM_START_RESTORE_EID, CFE_EVS_EventType_ERROR,
+                        "Error reading the CDS block. Status = 0x%08X", (unsigned int)SysStatus);
+      return ASTRO_PI_WarmStartResult_INVALID;
+   }
+
+   if (Block->Header.Version != WARM_START_VERSION || Block->Header.DataLen != sizeof(WARM_START_Data_t))
+   {
+      CFE_EVS_SendEvent(WARM_START_RESTORE_EID, CFE_EVS_EventType_ERROR,
+                        "Saved state version %u with %u data bytes doesn't match version %u with %u bytes",
+                        (unsigned int)Block->Header.Version, (unsigned int)Block->Header.DataLen,
+                        WARM_START_VERSION, (unsigned int)sizeof(WARM_START_Data_t));
+      return ASTRO_PI_WarmStartResult_INVALID;
+   }
+
+   DataCrc = ComputeDataCrc();
+   if (Block->Header.DataCrc != DataCrc)
+   {
+      CFE_EVS_SendEvent(WARM_START_RESTORE_EID, CFE_EVS_EventType_ERROR,
+                        "Saved state CRC 0x%04X doesn't match the computed CRC 0x%04X",
+                        (unsigned int)Block->Header.DataCrc, (unsigned int)DataCrc);
+      return ASTRO_PI_WarmStartResult_INVALID;
+   }
+
+   PY_SCRIPT_RestoreState(&Block->Data.PyScript);
+   SAMPLE_SYNC_RestoreState(&Block->Data.SampleSync);
+   SCRIPT_SYNC_RestoreState(&Block->Data.ScriptSync);
+   SEQ_TRACK_RestoreState(&Block->Data.SeqTrack);
+
+   return ASTRO_PI_WarmStartResult_RESTORED;
+
+} /* End RestoreState() */
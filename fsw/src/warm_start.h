@@ -0,0 +1,192 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   Preserve the app's state across warm restarts in the Critical Data Store
+**
+** Notes:
+**   1. The script counters, the Pi's latest script and cache status, the
+**      sequence tracking table, the sample request IDs and times, and the
+**      script sync counters are kept in one CDS block. A restarted app
+**      picks these up instead of starting from zero, resyncing every
+**      sequence source and losing outstanding sample requests.
+**   2. The CDS block is registered and restored by the constructor. cFE
+**      returns CFE_ES_CDS_ALREADY_EXISTS when the block survived an app or
+**      processor restart, otherwise a new block was created and the app
+**      starts cold.
+**   3. The block has a header with a layout version, the data length and
+**      a CRC of the data. The saved state is only restored if all three
+**      match. The cFE also checks its own CRC of the block when it's read.
+**   4. The state is saved by the main task every SavePeriod status
+**      requests and when the app exits. A save copies each object's
+**      state into a working buffer, computes its CRC and copies the buffer
+**      to the CDS. The restore and last save times are reported in the
+**      status telemetry.
+**
+*/
+
+#ifndef _warm_start_
+#define _warm_start_
+
+/*
+** Includes
+*/
+
+#include "app_cfg.h"
+#include "py_script.h"
+#include "sample_sync.h"
+#include "script_sync.h"
+#include "seq_track.h"
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+#define WARM_START_VERSION  1   /* Must be incremented when WARM_START_Data_t's layout changes */
+
+
+/*
+** Event Message IDs
+*/
+
+#define WARM_START_CONSTRUCTOR_EID  (WARM_START_BASE_EID + 0)
+#define WARM_START_RESTORE_EID      (WARM_START_BASE_EID + 1)
+#define WARM_START_SAVE_EID         (WARM_START_BASE_EID + 2)
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+
+typedef struct
+{
+
+   uint32  Version;
+   uint32  DataLen;
+   uint32  DataCrc;
+
+} WARM_START_Header_t;
+
+
+typedef struct
+{
+
+   PY_SCRIPT_SavedState_t    PyScript;
+   SAMPLE_SYNC_SavedState_t  SampleSync;
+   SCRIPT_SYNC_SavedState_t  ScriptSync;
+   SEQ_TRACK_SavedState_t    SeqTrack;
+
+} WARM_START_Data_t;
+
+
+typedef struct
+{
+
+   WARM_START_Header_t  Header;
+   WARM_START_Data_t    Data;
+
+} WARM_START_Block_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Class State Data
+   */
+
+   CFE_ES_CDSHandle_t  CdsHandle;
+   bool    CdsRegistered;
+   bool    LastSaveFailed;   /* Limits save error events to the first of a run of failures */
+
+   uint32  SavePeriod;       /* Status requests between saves, zero only saves when the app exits */
+   uint32  TickCnt;
+
+   ASTRO_PI_WarmStartStats_t  Stats;
+
+   WARM_START_Block_t  Block;   /* Save and restore working buffer */
+
+} WARM_START_Class_t;
+
+
+/************************/
+/** Exported Functions **/
+/************************/
+
+
+/******************************************************************************
+** Function: WARM_START_Constructor
+**
+** Register the CDS block and restore the saved state.
+**
+** Notes:
+**   1. This must be called prior to any other member functions.
+**   2. Must be called after the objects whose state is restored have been
+**      constructed and before the Sense HAT child tasks are started.
+**   3. The app runs without saving its state if the CDS block can't be
+**      registered.
+**
+*/
+void WARM_START_Constructor(WARM_START_Class_t *WarmStartPtr, INITBL_Class_t *IniTbl);
+
+
+/******************************************************************************
+** Function: WARM_START_GetStatus
+**
+** Load the warm start fields of the app's status telemetry payload.
+**
+*/
+void WARM_START_GetStatus(ASTRO_PI_StatusTlm_Payload_t *Payload);
+
+
+/******************************************************************************
+** Function: WARM_START_ResetStatus
+**
+** Reset counters to a known reset state.
+**
+** Notes:
+**   1. The restore result and time are kept.
+**
+*/
+void WARM_START_ResetStatus(void);
+
+
+/******************************************************************************
+** Function: WARM_START_Save
+**
+** Copy the app's current state to the CDS.
+**
+** Notes:
+**   1. Only called by the main task.
+**   2. Does nothing if the app failed to initialize before the constructor
+**      was called.
+**
+*/
+void WARM_START_Save(void);
+
+
+/******************************************************************************
+** Function: WARM_START_Tick
+**
+** Save the app's state every SavePeriod calls.
+**
+** Notes:
+**   1. Called for each status request.
+**
+*/
+void WARM_START_Tick(void);
+
+
+#endif /* _warm_start_ */
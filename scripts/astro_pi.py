@@ -15,7 +15,7 @@
     Purpose:
       Provide a command and telemetry interface between the Astro Pi
       cFS app and the Raspberry Pi python Sense HAT interface.
-    
+
     Notes:
       1. The goal of this script in combination with the Astro Pi cFS apps is
          to provide enough functionality that allows students to perform the 
@@ -25,11 +25,60 @@
          sudo apt-get install sense-hat
       3. The Astro Pi cFS app's command and telemetry interfaces are defined
          in astro_pi.xml
+      4. The receive thread blocks on the socket and only queues scripts, so
+         a long running script doesn't stop command reception. Scripts are
+         run by a pool of worker threads.
+      5. Script timeouts and cancels raise an exception in the worker thread
+         running the script. The exception is delivered the next time the
+         script executes python code so a script blocked in a system call is
+         stopped when the call returns.
+      6. Script counts are sent to the cFS app as JMSG CSV telemetry named
+         SCRIPT_STATUS_NAME. Script text starting with SCRIPT_CANCEL_PREFIX
+         is a cancel request, not a script.
+      7. Compiled scripts are kept in an LRU cache. Script text is keyed by
+         its hash and script files by path, modification time and size, so
+         an edited file is recompiled.
+      8. Script text starting with SCRIPT_LZB64_PREFIX is followed by the
+         script length, a colon and the base64 encoded LZSS compressed script.
+         It is decompressed before it's queued. The format is defined in the
+         cFS app's lzss.h.
+      9. Script text starting with SCRIPT_SYNC_PREFIX is a script directory
+         sync message. Stored scripts are in SYNC_DIR and are run with the
+         StartRemoteScript command. The sync protocol is defined in the cFS
+         app's script_sync.c. Sync replies are JMSG CSV telemetry named
+         SCRIPT_SYNC_NAME.
+     10. Script text starting with LED_FULL_PREFIX or LED_DELTA_PREFIX is an
+         LED matrix frame that is written with set_pixels(), it's not run as
+         a script. The frame encoding is defined in the cFS app's
+         led_matrix.h. Frame counts and the frame rate are sent as JMSG CSV
+         telemetry named LED_STATUS_NAME.
+     11. Script text starting with SAMPLE_REQUEST_PREFIX is a sample request
+         sent on a cFS scheduler tick. A sample is taken for the latest
+         request and sent with the request ID as its sequence count. Free
+         running sampling every TX_LOOP_DELAY seconds resumes when no
+         request has been received for SAMPLE_REQUEST_TIMEOUT seconds.
+         Request answers are named SAMPLE_RSP_NAME and free running samples
+         SAMPLE_NAME, each with its own sequence count.
+     12. Each script's stdout and stderr are captured and sent to the cFS
+         app as JMSG CSV telemetry named SCRIPT_OUTPUT_NAME. Output is sent
+         in batches of whole lines with a per script batch sequence number
+         and base64 encoded text. Batches are sent at OUTPUT RATE per second
+         and a script that gets MAX_PENDING batches ahead of the sender
+         blocks until the sender catches up. Output from threads started by
+         a script isn't captured. The batch format is defined in the cFS
+         app's script_output.c.
 
 """
 
+import base64
+import collections
 import configparser
+import ctypes
+import hashlib
+import os
+import queue
 import socket
+import sys
 import threading
 import time
 import json
@@ -40,6 +89,25 @@ sense = SenseHat()
 RUN_SCRIPT_TEXT_CMD = 1
 RUN_SCRIPT_FILE_CMD = 2
 
+SCRIPT_STATUS_NAME   = 'script-status'
+SCRIPT_CANCEL_PREFIX = '#cancel '
+SCRIPT_CANCEL_ALL    = 0
+SCRIPT_LZB64_PREFIX  = '#lzb64:'
+SCRIPT_SYNC_NAME     = 'script-sync'
+SCRIPT_SYNC_PREFIX   = '#sync-'
+LED_STATUS_NAME      = 'led-status'
+LED_FULL_PREFIX      = '#led-full '
+LED_DELTA_PREFIX     = '#led-delta '
+LED_PIXELS           = 64
+SAMPLE_REQUEST_PREFIX = '#sample '
+SAMPLE_NAME          = 'RPI-0'
+SAMPLE_RSP_NAME      = 'RPI-0-sync'
+SCRIPT_OUTPUT_NAME   = 'script-output'
+SCRIPT_OUTPUT_STDOUT = 0
+SCRIPT_OUTPUT_STDERR = 1
+
+LZSS_MIN_MATCH = 3
+
 JMSG_PREFIX = 'basecamp/script:'
 TEST1_JSON  = "{\"command\": 1, \"script-file\": \"Undefined\", \"script-text\": \"print('Hello world')\"}"
 TEST2_JSON  = "{\"command\": 1, \"script-file\": \"Undefined\", \"script-text\": \"from sense_hat import SenseHat\\nsense = SenseHat()\\nsense.show_message('Hello world')\"}"
@@ -48,79 +116,734 @@ TEST2_JMSG  = JMSG_PREFIX + TEST2_JSON
 
 config = configparser.ConfigParser()
 config.read('astro_pi.ini')
-RX_LOOP_DELAY = config.getint('APP','RX_LOOP_DELAY')
 TX_LOOP_DELAY = config.getint('APP','TX_LOOP_DELAY')
+SAMPLE_REQUEST_TIMEOUT = config.getfloat('APP','SAMPLE_REQUEST_TIMEOUT')
+VERBOSE = config.getboolean('APP','VERBOSE')
 
 JMSG_MAX_LEN = config.getint('JMSG','JMSG_MAX_LEN')
 JMSG_TOPIC_SCRIPT_CMD_NAME = config.get('JMSG','JMSG_TOPIC_SCRIPT_CMD_NAME')
 JMSG_TOPIC_CSV_TLM_NAME    = config.get('JMSG','JMSG_TOPIC_CSV_TLM_NAME')
 
+SCRIPT_WORKERS       = config.getint('SCRIPT','WORKERS')
+SCRIPT_QUEUE_LEN     = config.getint('SCRIPT','QUEUE_LEN')
+SCRIPT_TIMEOUT       = config.getfloat('SCRIPT','TIMEOUT')
+SCRIPT_STATUS_PERIOD = config.getfloat('SCRIPT','STATUS_PERIOD')
+SCRIPT_CACHE_SIZE    = config.getint('SCRIPT','CACHE_SIZE')
+SCRIPT_SYNC_DIR      = config.get('SCRIPT','SYNC_DIR')
+
+LED_STATUS_PERIOD = config.getfloat('LED','STATUS_PERIOD')
+
+OUTPUT_BATCH_BYTES  = config.getint('OUTPUT','BATCH_BYTES')
+OUTPUT_FLUSH_PERIOD = config.getfloat('OUTPUT','FLUSH_PERIOD')
+OUTPUT_RATE         = config.getfloat('OUTPUT','RATE')
+OUTPUT_MAX_PENDING  = config.getint('OUTPUT','MAX_PENDING')
+OUTPUT_ECHO         = config.getboolean('OUTPUT','ECHO')
+
 sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+sock_lock = threading.Lock()
 CFS_IP_ADDR  = config.get('NETWORK','CFS_IP_ADDR')
 CFS_APP_PORT = config.getint('NETWORK','CFS_APP_PORT')
 PY_APP_PORT  = config.getint('NETWORK','PY_APP_PORT')
 
 
+class ScriptTimeout(Exception):
+    pass
+
+class ScriptCancelled(Exception):
+    pass
+
+
+class CodeCache():
+    """
+    LRU cache of compiled script code objects shared by the script workers.
+    Scripts are compiled outside the lock so two workers may compile the
+    same new script, the last one stored wins.
+    """
+
+    def __init__(self, size):
+
+        self.size  = size
+        self.lock  = threading.Lock()
+        self.cache = collections.OrderedDict()
+        self.hits  = 0
+        self.misses = 0
+        self.compile_time_us = 0
+
+    def get_code(self, command, script, script_id):
+
+        if command == RUN_SCRIPT_FILE_CMD:
+            file_stat = os.stat(script)
+            key = ('file', script, file_stat.st_mtime_ns, file_stat.st_size)
+        else:
+            key = ('text', hashlib.sha1(script.encode('utf-8')).digest())
+
+        with self.lock:
+            code = self.cache.get(key)
+            if code:
+                self.cache.move_to_end(key)
+                self.hits += 1
+                return code
+
+        start = time.perf_counter()
+        if command == RUN_SCRIPT_FILE_CMD:
+            with open(script) as f:
+                code = compile(f.read(), script, 'exec')
+        else:
+            code = compile(script, f'<script-{script_id}>', 'exec')
+        compile_time_us = int((time.perf_counter() - start) * 1000000)
+
+        with self.lock:
+            self.misses += 1
+            self.compile_time_us += compile_time_us
+            if self.size > 0:
+                self.cache[key] = code
+                self.cache.move_to_end(key)
+                if len(self.cache) > self.size:
+                    self.cache.popitem(last=False)
+        return code
+
+    def status_params(self):
+        with self.lock:
+            return f"cache-hits,{self.hits},cache-misses,{self.misses},cache-entries,{len(self.cache)},compile-time-us,{self.compile_time_us}"
+
+
+def lzss_decompress(data, length):
+    """
+    Decompress an LZSS stream produced by the cFS app into length bytes
+    """
+    out = bytearray()
+    pos = 0
+    while len(out) < length:
+        flags = data[pos]
+        pos += 1
+        for bit in range(8):
+            if len(out) >= length:
+                break
+            if flags & (1 << bit):
+                out.append(data[pos])
+                pos += 1
+            else:
+                dist = data[pos] | ((data[pos+1] >> 4) << 8)
+                match_len = (data[pos+1] & 0x0F) + LZSS_MIN_MATCH
+                pos += 2
+                if dist == 0 or dist > len(out):
+                    raise ValueError(f'LZSS match distance {dist} outside of {len(out)} decoded bytes')
+                for i in range(match_len):
+                    out.append(out[-dist])
+    return bytes(out[:length])
+
+
+def decode_script_text(script_text):
+    """
+    Return the script text, decompressing it if it has the compressed prefix
+    """
+    if not script_text.startswith(SCRIPT_LZB64_PREFIX):
+        return script_text
+    length, b64_data = script_text[len(SCRIPT_LZB64_PREFIX):].split(':', 1)
+    script = lzss_decompress(base64.b64decode(b64_data), int(length)).decode('utf-8')
+    print(f'Decompressed script from {len(script_text)} to {len(script)} characters')
+    return script
+
+
+def make_crc16_table():
+    table = []
+    for byte in range(256):
+        crc = byte
+        for bit in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+CRC16_TABLE = make_crc16_table()
+
+def crc16(data, crc=0):
+    """
+    CRC-16/ARC, the cFE's CFE_ES_CrcType_CRC_16. Pass the previous result
+    as crc to continue a CRC across buffers.
+    """
+    for byte in data:
+        crc = (crc >> 8) ^ CRC16_TABLE[(crc ^ byte) & 0xFF]
+    return crc
+
+
+class ScriptSync():
+    """
+    Keep SYNC_DIR in step with the cFS app's local script directory. Blocks
+    are applied to an in-memory copy of each file and the file is only
+    written after its length and CRC are verified.
+    """
+    def __init__(self, sync_dir):
+        self.sync_dir  = sync_dir
+        self.seq_count = 1
+        self.pending   = {}
+        self.verified  = 0
+        self.errors    = 0
+        os.makedirs(sync_dir, exist_ok=True)
+
+    def process(self, sync_text):
+        request, _, params = sync_text[len(SCRIPT_SYNC_PREFIX):].partition(' ')
+        if request == 'manifest':
+            block_len, max_blocks = (int(p) for p in params.split(':'))
+            self.send_manifest(block_len, max_blocks)
+        elif request == 'block':
+            name, offset, b64_data = params.split(':', 2)
+            self.write_block(self.valid_name(name), int(offset), base64.b64decode(b64_data))
+        elif request == 'end':
+            name, length, crc = params.split(':')
+            self.end_file(self.valid_name(name), int(length), int(crc))
+        elif request == 'delete':
+            os.remove(self.path(self.valid_name(params)))
+            print(f'Script sync deleted {params}')
+        elif request == 'commit':
+            self.send(f'verified,{self.verified},errors,{self.errors}')
+            self.pending.clear()
+            self.verified = 0
+            self.errors   = 0
+        else:
+            print(f'Received invalid script sync request {request}')
+
+    def valid_name(self, name):
+        if not name or name.startswith('.') or '/' in name or '\\' in name:
+            raise ValueError(f'Invalid script sync file name {name}')
+        return name
+
+    def path(self, name):
+        return os.path.join(self.sync_dir, name)
+
+    def send(self, parameters):
+        send_csv_tlm(SCRIPT_SYNC_NAME, self.seq_count, parameters)
+        self.seq_count += 1
+
+    def send_manifest(self, block_len, max_blocks):
+        """
+        A file longer than max_blocks only reports its first max_blocks CRCs
+        so the app resends the rest of the file
+        """
+        names = sorted(n for n in os.listdir(self.sync_dir)
+                       if not n.startswith('.') and os.path.isfile(self.path(n)))
+        for name in names:
+            with open(self.path(name), 'rb') as f:
+                data = f.read()
+            crcs = ''.join(f'{crc16(data[i:i+block_len]):04X}'
+                           for i in range(0, min(len(data), block_len*max_blocks), block_len))
+            self.send(f'file,{name},size,{len(data)},crc,{crcs}')
+        self.send(f'files,{len(names)}')
+
+    def write_block(self, name, offset, data):
+        if name not in self.pending:
+            try:
+                with open(self.path(name), 'rb') as f:
+                    self.pending[name] = bytearray(f.read())
+            except FileNotFoundError:
+                self.pending[name] = bytearray()
+        content = self.pending[name]
+        if offset > len(content):
+            content.extend(bytes(offset - len(content)))
+        content[offset:offset+len(data)] = data
+
+    def end_file(self, name, length, crc):
+        content = self.pending.pop(name, None)
+        if content is None:
+            with open(self.path(name), 'rb') as f:
+                content = bytearray(f.read())
+        del content[length:]
+        if len(content) == length and crc16(content) == crc:
+            tmp_path = self.path('.' + name + '.tmp')
+            with open(tmp_path, 'wb') as f:
+                f.write(content)
+            os.replace(tmp_path, self.path(name))
+            self.verified += 1
+            print(f'Script sync updated {name}, {length} bytes')
+        else:
+            self.errors += 1
+            print(f'Script sync verify failed for {name}, expected {length} bytes with CRC {crc:04X}')
+
+
+def rgb565_to_rgb(pixel):
+    r = (pixel >> 11) & 0x1F
+    g = (pixel >> 5) & 0x3F
+    b = pixel & 0x1F
+    return [(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)]
+
+
+class LedMatrix():
+    """
+    Write LED matrix frames sent by the cFS app. Delta frames are applied to
+    the current frame and ignored after a sequence gap until a full frame
+    arrives. A report thread sends the frame rate while frames are arriving.
+    """
+    def __init__(self, status_period):
+        self.status_period = status_period
+        self.lock      = threading.Lock()
+        self.frame     = [[0, 0, 0] for i in range(LED_PIXELS)]
+        self.next_seq  = None
+        self.frames    = 0
+        self.seq_errors    = 0
+        self.decode_errors = 0
+        self.seq_count = 1
+
+    def process(self, frame_text):
+        full = frame_text.startswith(LED_FULL_PREFIX)
+        prefix_len = len(LED_FULL_PREFIX) if full else len(LED_DELTA_PREFIX)
+        try:
+            seq, b64_data = frame_text[prefix_len:].split(':', 1)
+            seq  = int(seq)
+            data = base64.b64decode(b64_data)
+            if full:
+                if len(data) != 2*LED_PIXELS:
+                    raise ValueError(f'full frame has {len(data)} bytes')
+                self.frame = [rgb565_to_rgb((data[2*i] << 8) | data[2*i+1]) for i in range(LED_PIXELS)]
+            else:
+                if seq != self.next_seq:
+                    with self.lock:
+                        self.seq_errors += 1
+                    self.next_seq = None
+                    return
+                if len(data) % 3 != 0:
+                    raise ValueError(f'delta frame has {len(data)} bytes')
+                for i in range(0, len(data), 3):
+                    self.frame[data[i]] = rgb565_to_rgb((data[i+1] << 8) | data[i+2])
+        except (ValueError, IndexError) as e:
+            print(f'Invalid LED frame: {e}')
+            with self.lock:
+                self.decode_errors += 1
+            self.next_seq = None
+            return
+        sense.set_pixels(self.frame)
+        self.next_seq = (seq + 1) & 0xFFFF
+        with self.lock:
+            self.frames += 1
+
+    def report_thread(self):
+        """
+        Parameter order must match LED_MATRIX's frame report definition
+        """
+        last_frames = 0
+        last_time = time.monotonic()
+        while True:
+            time.sleep(self.status_period)
+            now = time.monotonic()
+            with self.lock:
+                frames, seq_errors, decode_errors = self.frames, self.seq_errors, self.decode_errors
+            if frames != last_frames:
+                fps = (frames - last_frames) / (now - last_time)
+                send_csv_tlm(LED_STATUS_NAME, self.seq_count,
+                             f'frames,{frames},fps,{fps:.1f},seq-errors,{seq_errors},decode-errors,{decode_errors}')
+                self.seq_count += 1
+            last_frames = frames
+            last_time = now
+
+
+class OutputCapture():
+    """
+    Collect a script's stdout and stderr into batches of whole lines of at
+    most batch_bytes UTF-8 bytes, longer lines are split. A stream change
+    starts a new batch. Batch sequence numbers are assigned when a batch is
+    sent so they only skip when the cFS app loses a message.
+    """
+    def __init__(self, script_id, batch_bytes, max_pending):
+        self.script_id   = script_id
+        self.batch_bytes = batch_bytes
+        self.max_pending = max_pending
+        self.cond    = threading.Condition()
+        self.batches = collections.deque()   # [stream, data, final]
+        self.stream  = SCRIPT_OUTPUT_STDOUT
+        self.text    = bytearray()            # Output not in a batch yet
+        self.first_write = 0.0
+        self.seq    = 0
+        self.closed = False
+
+    def write(self, stream, text):
+        with self.cond:
+            if self.text and stream != self.stream:
+                self.push(len(self.text))
+            if not self.text:
+                self.first_write = time.monotonic()
+            self.stream = stream
+            self.text  += text.encode('utf-8', 'replace')
+            while len(self.text) >= self.batch_bytes:
+                end = self.text.rfind(b'\n', 0, self.batch_bytes)
+                self.push(end + 1 if end >= 0 else self.batch_bytes)
+
+    def push(self, length):
+        """
+        Must be called with the condition held. Blocks the script while
+        max_pending batches are waiting. The wait times out so a script
+        timeout or cancel is delivered while the script is blocked.
+        """
+        while len(self.batches) >= self.max_pending:
+            self.cond.wait(0.1)
+        self.batches.append([self.stream, bytes(self.text[:length]), False])
+        del self.text[:length]
+        if self.text:
+            self.first_write = time.monotonic()
 
-def tx_thread():
-    
+    def close(self):
+        """
+        Send the remaining output and mark the last batch final. An empty
+        final batch is sent if all the output has been sent.
+        """
+        with self.cond:
+            if self.text:
+                self.push(len(self.text))
+            if self.batches:
+                self.batches[-1][2] = True
+            else:
+                self.batches.append([self.stream, b'', True])
+            self.closed = True
+
+    def next_batch(self, flush_period):
+        """
+        Return (seq, stream, data, final) for the oldest batch or None. Text
+        that has waited flush_period seconds without completing a batch is
+        sent as a partial batch.
+        """
+        with self.cond:
+            if not self.batches and self.text and time.monotonic() - self.first_write >= flush_period:
+                self.push(len(self.text))
+            if not self.batches:
+                return None
+            stream, data, final = self.batches.popleft()
+            self.cond.notify_all()
+            seq = self.seq
+            self.seq += 1
+            return seq, stream, data, final
+
+    def drained(self):
+        with self.cond:
+            return self.closed and not self.batches
+
+
+class OutputSender():
+    """
+    Send captured script output at no more than rate batches per second.
+    Scripts with output take turns sending a batch.
+    """
+    def __init__(self, batch_bytes, flush_period, rate, max_pending):
+        self.batch_bytes  = batch_bytes
+        self.flush_period = flush_period
+        self.send_period  = 1.0 / rate
+        self.max_pending  = max_pending
+        self.lock      = threading.Lock()
+        self.captures  = []
+        self.seq_count = 1
+        threading.Thread(target=self.sender_thread, name='output-sender', daemon=True).start()
+
+    def open(self, script_id):
+        capture = OutputCapture(script_id, self.batch_bytes, self.max_pending)
+        with self.lock:
+            self.captures.append(capture)
+        return capture
+
+    def sender_thread(self):
+        while True:
+            with self.lock:
+                captures = list(self.captures)
+            sent = False
+            for capture in captures:
+                batch = capture.next_batch(self.flush_period)
+                if batch:
+                    seq, stream, data, final = batch
+                    text = base64.b64encode(data).decode('ascii')
+                    send_csv_tlm(SCRIPT_OUTPUT_NAME, self.seq_count,
+                                 f'id,{capture.script_id},seq,{seq},stream,{stream},final,{int(final)},text,{text}')
+                    self.seq_count += 1
+                    sent = True
+                    time.sleep(self.send_period)
+                if capture.drained():
+                    with self.lock:
+                        self.captures.remove(capture)
+            if not sent:
+                time.sleep(min(self.send_period, self.flush_period))
+
+
+class OutputRouter():
+    """
+    Replaces sys.stdout or sys.stderr. Output written by a thread running a
+    script goes to the script's capture and, if echo is set, the console.
+    Output from other threads goes to the console.
+    """
+    local = threading.local()   # 'capture' is the running script's OutputCapture
+
+    def __init__(self, console, stream, echo):
+        self.console = console
+        self.stream  = stream
+        self.echo    = echo
+
+    def write(self, text):
+        capture = getattr(OutputRouter.local, 'capture', None)
+        if capture:
+            capture.write(self.stream, text)
+            if not self.echo:
+                return len(text)
+        return self.console.write(text)
+
+    def __getattr__(self, name):
+        return getattr(self.console, name)
+
+
+class ScriptJob():
+
+    def __init__(self, script_id, command, script):
+        self.id        = script_id
+        self.command   = command
+        self.script    = script   # Script text or remote filename
+        self.cancelled = False
+        self.done      = False
+        self.stopping  = False    # A timeout or cancel exception was raised
+        self.thread_id = None
+        self.deadline  = None
+        self.capture   = None
+
+
+class ScriptRunner():
+    """
+    Run scripts on a bounded pool of worker threads. A supervisor thread
+    enforces script timeouts and sends status reports to the cFS app.
+    """
+
+    def __init__(self, workers, queue_len, timeout, status_period, cache_size, output_sender):
+
+        self.code_cache    = CodeCache(cache_size)
+        self.output_sender = output_sender
+        self.timeout       = timeout
+        self.status_period = status_period
+        self.jobs    = queue.Queue(maxsize=queue_len)
+        self.lock    = threading.Lock()
+        self.changed = threading.Event()
+        self.queued  = {}
+        self.running = {}
+        self.next_id = 1
+        self.last_id = 0
+        self.status_seq_count = 1
+        self.counts = {'completed': 0, 'failed': 0, 'timeout': 0, 'cancelled': 0, 'rejected': 0}
+
+        for i in range(workers):
+            threading.Thread(target=self.worker_thread, name=f'script-worker-{i}', daemon=True).start()
+        threading.Thread(target=self.supervisor_thread, name='script-supervisor', daemon=True).start()
+
+    def submit(self, command, script):
+        """
+        Queue a script without blocking. Returns the script ID or None if
+        the queue is full.
+        """
+        with self.lock:
+            job = ScriptJob(self.next_id, command, script)
+            try:
+                self.jobs.put_nowait(job)
+            except queue.Full:
+                self.counts['rejected'] += 1
+                print(f'Script queue full, rejected script {job.id}')
+                job = None
+            else:
+                self.queued[job.id] = job
+                self.last_id = job.id
+            self.next_id += 1
+        self.changed.set()
+        return job.id if job else None
+
+    def cancel(self, script_id):
+        """
+        Cancel a queued or running script. SCRIPT_CANCEL_ALL cancels every
+        script. Queued scripts are discarded when a worker dequeues them.
+        """
+        with self.lock:
+            for job in list(self.queued.values()) + list(self.running.values()):
+                if script_id in (SCRIPT_CANCEL_ALL, job.id):
+                    job.cancelled = True
+                    if job.thread_id is not None:
+                        self.raise_in_job(job, ScriptCancelled)
+        self.changed.set()
+
+    def raise_in_job(self, job, exc_type):
+        """
+        Must be called with the lock held. At most one exception is raised
+        per job and none after finish_job() marks it done, so once a worker
+        catches the exception or finishes the job no other can arrive.
+        """
+        if not job.done and not job.stopping:
+            job.stopping = True
+            ret = ctypes.pythonapi.PyThreadState_SetAsyncExc(ctypes.c_ulong(job.thread_id), ctypes.py_object(exc_type))
+            if ret > 1:
+                ctypes.pythonapi.PyThreadState_SetAsyncExc(ctypes.c_ulong(job.thread_id), None)
+
+    def run_job(self, job):
+        """
+        A timeout or cancel can be raised in the worker from the moment the
+        job is in running until finish_job() marks it done, including in
+        the bookkeeping around the script.
+        """
+        with self.lock:
+            del self.queued[job.id]
+            if job.cancelled:
+                self.counts['cancelled'] += 1
+                return
+            job.thread_id = threading.get_ident()
+            job.deadline  = time.monotonic() + self.timeout
+            self.running[job.id] = job
+
+        outcome = 'completed'
+        try:
+            self.changed.set()
+            job.capture = self.output_sender.open(job.id)
+            OutputRouter.local.capture = job.capture
+            code = self.code_cache.get_code(job.command, job.script, job.id)
+            exec(code, {'__name__': '__main__'})
+        except ScriptTimeout:
+            outcome = 'timeout'
+        except ScriptCancelled:
+            outcome = 'cancelled'
+        except Exception as e:
+            outcome = 'failed'
+            print(f'Script {job.id} exception: {e}\n', file=sys.stderr)
+        self.finish_job(job, outcome)
+
+    def finish_job(self, job, outcome):
+        """
+        Idempotent so the worker can call it again if the job's exception
+        arrives while it runs. A pending exception that hasn't been
+        delivered is cleared, after which none can be raised for the job.
+        """
+        with self.lock:
+            job.done = True
+            ctypes.pythonapi.PyThreadState_SetAsyncExc(ctypes.c_ulong(job.thread_id), None)
+
+        capture, job.capture = job.capture, None
+        if capture:
+            OutputRouter.local.capture = None
+            capture.close()
+
+        with self.lock:
+            counted = self.running.pop(job.id, None) is not None
+            if counted:
+                self.counts[outcome] += 1
+        if counted:
+            print(f'Script {job.id} {outcome}')
+
+    def worker_thread(self):
+        while True:
+            job = None
+            try:
+                job = self.jobs.get()
+                self.run_job(job)
+            except ScriptTimeout:
+                # Raised outside the script, the job may not be finished
+                self.finish_job(job, 'timeout')
+            except ScriptCancelled:
+                self.finish_job(job, 'cancelled')
+            self.changed.set()
+
+    def supervisor_thread(self):
+
+        next_report = 0.0
+        while True:
+            changed = self.changed.wait(min(1.0, self.status_period))
+            self.changed.clear()
+            now = time.monotonic()
+            with self.lock:
+                for job in self.running.values():
+                    if now > job.deadline:
+                        self.raise_in_job(job, ScriptTimeout)
+                        job.deadline = float('inf')
+                if changed or now >= next_report:
+                    report = self.status_params()
+                else:
+                    report = None
+            if report:
+                send_csv_tlm(SCRIPT_STATUS_NAME, self.status_seq_count, report)
+                self.status_seq_count += 1
+                next_report = now + self.status_period
+
+    def status_params(self):
+        """
+        Parameter order must match PY_SCRIPT's status report definition
+        """
+        c = self.counts
+        return (f"running,{len(self.running)},queued,{len(self.queued)},completed,{c['completed']},"
+                f"failed,{c['failed']},timeout,{c['timeout']},cancelled,{c['cancelled']},"
+                f"rejected,{c['rejected']},last-id,{self.last_id},{self.code_cache.status_params()}")
+
+
+def send_csv_tlm(name, seq_count, parameters):
+
+    jmsg = JMSG_TOPIC_CSV_TLM_NAME + '{"name": "%s", "seq-count": %d, "date-time": "00/00/0000 00:00:00",  "parameters": "%s"}' % (name,seq_count,parameters)
+    if VERBOSE:
+        print(f'>>> Sending message {jmsg}')
+    with sock_lock:
+        sock.sendto(jmsg.encode('ASCII'), (CFS_IP_ADDR, CFS_APP_PORT))
+
+
+def tx_thread(sample_requests):
+    """
+    Requests that queued while a sample was being taken are discarded so
+    the sample answers the most recent request. Request answers are sent
+    as SAMPLE_RSP_NAME with the request ID as the sequence count, free
+    running samples keep their own sequence count so switching modes
+    doesn't look like lost or repeated samples.
+    """
     i = 1
+    last_request = -SAMPLE_REQUEST_TIMEOUT
     while True:
+        try:
+            seq_count = sample_requests.get(timeout=TX_LOOP_DELAY)
+            while not sample_requests.empty():
+                seq_count = sample_requests.get_nowait()
+            last_request = time.monotonic()
+            name = SAMPLE_RSP_NAME
+        except queue.Empty:
+            if time.monotonic() - last_request < SAMPLE_REQUEST_TIMEOUT:
+                continue
+            seq_count = i
+            i += 1
+            name = SAMPLE_NAME
         payload = read_tlm_parameters()
-        jmsg = JMSG_TOPIC_CSV_TLM_NAME + '{"name": "RPI-0", "seq-count": %d, "date-time": "00/00/0000 00:00:00",  "parameters": "%s"}' % (i,payload)
-        print(f'>>> Sending message {jmsg}')
-        sock.sendto(jmsg.encode('ASCII'), (CFS_IP_ADDR, CFS_APP_PORT))
-        time.sleep(TX_LOOP_DELAY)
-        i += 1
+        send_csv_tlm(name, seq_count, payload)
+
 
-        
-def rx_thread():
+def rx_thread(script_runner, script_sync, led_matrix, sample_requests):
 
     rx_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
     rx_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
     rx_socket.bind((CFS_IP_ADDR, PY_APP_PORT))
-    rx_socket.setblocking(False)
-    rx_socket.settimeout(1000)
 
     while True:
-        jmsg = None
-        print("Pending for recvfrom")
-        try:
-            while True:
-                datagram, host = rx_socket.recvfrom(JMSG_MAX_LEN)
-                if datagram:
-                    jmsg = datagram
-                if jmsg:
-                    jmsg_str = jmsg.decode('utf-8')
-                    print(f'*****\nReceived from {host} JMSG {len(jmsg_str)}: {jmsg_str}\n')
-                    process_jmsg_cmd(jmsg_str.replace("\x00", "").replace("\x01", ""))
-        except socket.timeout:
-            pass
-        print('*****\n\n')
-        time.sleep(RX_LOOP_DELAY)
-
-
-def process_jmsg_cmd(jmsg_str):
+        datagram, host = rx_socket.recvfrom(JMSG_MAX_LEN)
+        if datagram:
+            jmsg_str = datagram.decode('utf-8')
+            if VERBOSE:
+                print(f'*****\nReceived from {host} JMSG {len(jmsg_str)}: {jmsg_str}\n')
+            process_jmsg_cmd(script_runner, script_sync, led_matrix, sample_requests, jmsg_str.replace("\x00", "").replace("\x01", ""))
+
+
+def process_jmsg_cmd(script_runner, script_sync, led_matrix, sample_requests, jmsg_str):
 
     try:
         # Text following prefix is assumed to be JSON message 
         if jmsg_str.startswith(JMSG_TOPIC_SCRIPT_CMD_NAME):
             json_str = jmsg_str.replace(JMSG_TOPIC_SCRIPT_CMD_NAME, "")
-            print(f'>>json {len(json_str)}: {json_str}\n')
+            if VERBOSE:
+                print(f'>>json {len(json_str)}: {json_str}\n')
             json_str2 = json_str.replace('\n','\\n')
-            print(f'>>json2: {json_str2}\n')
             json_dict = json.loads(json_str2)
             command = json_dict["command"]
             if command == RUN_SCRIPT_TEXT_CMD:
-                print(f'>>json_dict: {json_dict}\n')
-                exec(json_dict["script-text"])
-                print("")                
+                script_text = json_dict["script-text"]
+                if script_text.startswith(SCRIPT_CANCEL_PREFIX):
+                    script_runner.cancel(int(script_text[len(SCRIPT_CANCEL_PREFIX):]))
+                elif script_text.startswith(SCRIPT_SYNC_PREFIX):
+                    script_sync.process(script_text)
+                elif script_text.startswith((LED_FULL_PREFIX, LED_DELTA_PREFIX)):
+                    led_matrix.process(script_text)
+                elif script_text.startswith(SAMPLE_REQUEST_PREFIX):
+                    sample_requests.put(int(script_text[len(SAMPLE_REQUEST_PREFIX):]))
+                else:
+                    script_runner.submit(command, decode_script_text(script_text))
             elif command == RUN_SCRIPT_FILE_CMD:
-                exec(open(json_dict["script-file"]).read())
+                script_runner.submit(command, json_dict["script-file"])
             else:
                 print(f'Received JMSG with invalid command {command}')
         else:
-            print(f'Received JMSG not addresssed to Astro Pi. Expected {JMSG_TOPIC_NAME_PREFIX}')
+            print(f'Received JMSG not addresssed to Astro Pi. Expected {JMSG_TOPIC_SCRIPT_CMD_NAME}')
     except Exception as e:
         print(f'Astro Pi JMSG processing exception: {e}\n')
 
@@ -131,8 +854,6 @@ def read_tlm_parameters():
     Integration cycles are the time that the the sensor takes between measuring the light. 
     Each integration cycle is 2.4 milliseconds long, and the number of integration cycles can be any number between 1 and 256.
     """
-    
-    sense.clear()
 
     orientation = sense.get_orientation()
     roll  = orientation["roll"]
@@ -147,25 +868,39 @@ def read_tlm_parameters():
     x=round(accel_x, 0)
     y=round(accel_y, 0)
     z=round(accel_z, 0)
-    
+
     pressure    = sense.get_pressure()
     temperature = sense.get_temperature()
     humidity    = sense.get_humidity()
-    
+
     red, green, blue, clear = sense.colour.colour
 
     parameters = f"rate-x,{roll},rate-y,{pitch},rate-z,{yaw},accel-x,{accel_x},accel-y,{accel_y},accel-z,{accel_z},pressure,{pressure},temperature,{temperature},humidity,{humidity},red,{red},green,{green},blue,{blue},clear,{clear}"
 
-    return payload
+    return parameters
+
 
-          
 if __name__ == "__main__":
 
-    rx = threading.Thread(target=rx_thread)
+    output_sender = OutputSender(OUTPUT_BATCH_BYTES, OUTPUT_FLUSH_PERIOD, OUTPUT_RATE, OUTPUT_MAX_PENDING)
+    sys.stdout = OutputRouter(sys.stdout, SCRIPT_OUTPUT_STDOUT, OUTPUT_ECHO)
+    sys.stderr = OutputRouter(sys.stderr, SCRIPT_OUTPUT_STDERR, OUTPUT_ECHO)
+
+    script_runner = ScriptRunner(SCRIPT_WORKERS, SCRIPT_QUEUE_LEN, SCRIPT_TIMEOUT, SCRIPT_STATUS_PERIOD,
+                                 SCRIPT_CACHE_SIZE, output_sender)
+
+    script_sync = ScriptSync(SCRIPT_SYNC_DIR)
+    led_matrix  = LedMatrix(LED_STATUS_PERIOD)
+    sample_requests = queue.Queue()
+
+    rx = threading.Thread(target=rx_thread, args=(script_runner, script_sync, led_matrix, sample_requests))
     rx.start()
-   
-    tx = threading.Thread(target=tx_thread)
+
+    tx = threading.Thread(target=tx_thread, args=(sample_requests,))
     tx.start()
- 
+
+    led = threading.Thread(target=led_matrix.report_thread, daemon=True)
+    led.start()
+
     #process_jmsg(TEST1_JMSG)
-    #process_jmsg(TEST2_JMSG)
\ No newline at end of file
+    #process_jmsg(TEST2_JMSG)
@@ -0,0 +1,751 @@
+/*
+** Copyright 2022 bitValence, Inc.
+** All Rights Reserved.
+**
+** This program is free software; you can modify and/or redistribute it
+** under the terms of the GNU Affero General Public License
+** as published by the Free Software Foundation; version 3 with
+** attribution addendums as found in the LICENSE.txt
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Affero General Public License for more details.
+**
+** Purpose:
+**   High rate Astro Pi load generator and Pi stand-in for loopback testing
+**
+** Notes:
+**   1. Sends JMSG CSV Sense HAT telemetry to the cFS JMSG UDP port at a
+**      configurable rate, burst size and number of sources, and receives
+**      and validates the JMSG script commands sent to the Pi's port. It
+**      replaces astro_pi.py so the Astro Pi app's throughput can be
+**      characterized on one Linux host over loopback.
+**   2. Each source has its own name and sequence count, matching the JMSG
+**      'name' and 'seq-count' fields tracked by the app's SEQ_TRACK object.
+**      The -x option skips sequence counts to verify the app's loss
+**      reporting. End-to-end loss is the app's SEQ_TRACK loss compared with
+**      the sent counts reported here.
+**   3. Like the Pi endpoint it sends periodic "script-status" reports. Each
+**      valid script is numbered like the Pi does and counted as completed
+**      when it's received. Cancel requests and the sync, LED frame and
+**      sample request texts that share the script topic aren't scripts.
+**   4. This is a host tool and isn't part of the cFS app build. Build with:
+**        cc -O2 -Wall -o astro_pi_loadgen astro_pi_loadgen.c -lpthread
+**
+*/
+
+/*
+** Includes
+*/
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/***********************/
+/** Macro Definitions **/
+/***********************/
+
+/* Defaults match scripts/astro_pi.ini */
+#define LOADGEN_CFS_IP_ADDR     "127.0.0.1"
+#define LOADGEN_CFS_APP_PORT    8888
+#define LOADGEN_PY_APP_PORT     9999
+#define LOADGEN_CSV_TLM_NAME    "basecamp/csv/tlm:"
+#define LOADGEN_SCRIPT_CMD_NAME "basecamp/script/cmd:"
+
+#define LOADGEN_JMSG_MAX_LEN    1024
+#define LOADGEN_MAX_SOURCES     16
+#define LOADGEN_NAME_LEN        20
+
+#define LOADGEN_SCRIPT_STATUS_NAME   "script-status"
+#define LOADGEN_SCRIPT_CANCEL_PREFIX "#cancel "
+
+#define RUN_SCRIPT_TEXT_CMD  1
+#define RUN_SCRIPT_FILE_CMD  2
+
+#define NSEC_PER_SEC  1000000000LL
+
+
+/**********************/
+/** Type Definitions **/
+/**********************/
+
+typedef struct
+{
+
+   char      Name[LOADGEN_NAME_LEN];
+   uint32_t  SeqCount;
+   uint64_t  SentCnt;
+
+} Source_t;
+
+
+typedef struct
+{
+
+   /*
+   ** Configuration
+   */
+
+   struct sockaddr_in  CfsAddr;
+   uint16_t  ListenPort;
+   double    Rate;            /* Telemetry messages per second, all sources */
+   uint32_t  BurstLen;        /* Messages sent back to back per burst */
+   uint32_t  SourceCnt;
+   uint32_t  SkipEvery;       /* Skip every Nth sequence count, 0 disables */
+   double    Duration;        /* Seconds, 0 runs until interrupted */
+   double    ReportPeriod;
+   double    StatusPeriod;    /* Script status report period, 0 disables */
+   bool      Verbose;
+
+   int  TxSock;
+
+   /*
+   ** Telemetry generation
+   */
+
+   Source_t  Source[LOADGEN_MAX_SOURCES];
+   atomic_uint_fast64_t  TlmSentCnt;
+   atomic_uint_fast64_t  TlmSkipCnt;
+   atomic_uint_fast64_t  TlmSendErrCnt;
+   atomic_uint_fast64_t  TlmBytes;
+   atomic_uint_fast64_t  LateBurstCnt;      /* Bursts that started after their scheduled time */
+
+   /*
+   ** Script command reception
+   */
+
+   atomic_uint_fast64_t  CmdRcvCnt;
+   atomic_uint_fast64_t  CmdValidCnt;
+   atomic_uint_fast64_t  CmdInvalidCnt;
+   atomic_uint_fast64_t  CmdCancelCnt;
+   atomic_uint_fast64_t  LastScriptId;   /* Scripts are numbered from 1 */
+   atomic_uint_fast64_t  CmdBytes;
+   uint32_t  StatusSeqCount;
+
+} LoadGen_t;
+
+
+/************************************/
+/** Local File Function Prototypes **/
+/************************************/
+
+static double ElapsedSec(const struct timespec *Start, const struct timespec *Now);
+static bool   JsonGetInt(const char *Json, const char *Key, long *Value);
+static bool   JsonGetStr(const char *Json, const char *Key, char *Value, size_t ValueLen);
+static void   ParseArgs(int argc, char *argv[]);
+static void   PrintReport(const struct timespec *Start, double Interval);
+static void  *RxThread(void *Arg);
+static void   SendCsvTlm(const char *Name, uint32_t SeqCount, const char *Params);
+static void   SendScriptStatus(void);
+static void   SignalHandler(int Signal);
+static void   TimespecAddNs(struct timespec *Time, int64_t Ns);
+static void  *TxThread(void *Arg);
+static bool   ValidateScriptCmd(const char *JMsg);
+
+
+/**********************/
+/** File Global Data **/
+/**********************/
+
+static LoadGen_t LoadGen;
+static volatile sig_atomic_t Running = 1;
+
+/* Fixed Sense HAT parameters, only the sequence count changes */
+static const char SenseHatParams[] =
+   "rate-x,1.5,rate-y,-2.25,rate-z,3.0,accel-x,0.01,accel-y,-0.02,accel-z,0.98,"
+   "pressure,1013.25,temperature,22.5,humidity,41.0,red,120,green,80,blue,40,clear,255";
+
+/* Script text prefixes the Pi handles without running a script */
+static const char *const ControlTextPrefix[] =
+{
+   LOADGEN_SCRIPT_CANCEL_PREFIX, "#sync-", "#led-full ", "#led-delta ", "#sample "
+};
+
+
+/******************************************************************************
+** Function: main
+**
+*/
+int main(int argc, char *argv[])
+{
+
+   pthread_t  TxTid;
+   pthread_t  RxTid;
+   struct timespec Start, Now, NextReport, NextStatus;
+
+   ParseArgs(argc, argv);
+
+   LoadGen.TxSock = socket(AF_INET, SOCK_DGRAM, 0);
+   if (LoadGen.TxSock < 0)
+   {
+      perror("socket");
+      return 1;
+   }
+
+   signal(SIGINT,  SignalHandler);
+   signal(SIGTERM, SignalHandler);
+
+   clock_gettime(CLOCK_MONOTONIC, &Start);
+
+   if (pthread_create(&RxTid, NULL, RxThread, NULL) != 0 ||
+       pthread_create(&TxTid, NULL, TxThread, &Start) != 0)
+   {
+      fprintf(stderr, "Error creating load generator threads\n");
+      return 1;
+   }
+
+   NextReport = Start;
+   NextStatus = Start;
+   TimespecAddNs(&NextReport, (int64_t)(LoadGen.ReportPeriod * NSEC_PER_SEC));
+
+   while (Running)
+   {
+      usleep(10000);
+      clock_gettime(CLOCK_MONOTONIC, &Now);
+
+      if (LoadGen.Duration > 0 && ElapsedSec(&Start, &Now) >= LoadGen.Duration)
+      {
+         Running = 0;
+      }
+      if (LoadGen.StatusPeriod > 0 && ElapsedSec(&NextStatus, &Now) >= 0)
+      {
+         SendScriptStatus();
+         TimespecAddNs(&NextStatus, (int64_t)(LoadGen.StatusPeriod * NSEC_PER_SEC));
+      }
+      if (ElapsedSec(&NextReport, &Now) >= 0)
+      {
+         PrintReport(&Start, LoadGen.ReportPeriod);
+         TimespecAddNs(&NextReport, (int64_t)(LoadGen.ReportPeriod * NSEC_PER_SEC));
+      }
+   }
+
+   pthread_join(TxTid, NULL);
+
+   printf("\nFinal:\n");
+   PrintReport(&Start, 0.0);
+   for (uint32_t i=0; i < LoadGen.SourceCnt; i++)
+   {
+      printf("  %-*s sent %llu, last seq-count %u\n", LOADGEN_NAME_LEN, LoadGen.Source[i].Name,
+             (unsigned long long)LoadGen.Source[i].SentCnt, LoadGen.Source[i].SeqCount-1);
+   }
+
+   pthread_join(RxTid, NULL);
+   close(LoadGen.TxSock);
+
+   return 0;
+
+} /* End main() */
+
+
+/******************************************************************************
+** Function: ElapsedSec
+**
+*/
+static double ElapsedSec(const struct timespec *Start, const struct timespec *Now)
+{
+
+   return (double)(Now->tv_sec - Start->tv_sec) + (double)(Now->tv_nsec - Start->tv_nsec) / NSEC_PER_SEC;
+
+} /* End ElapsedSec() */
+
+
+/******************************************************************************
+** Function: JsonGetInt
+**
+** Notes:
+**   1. Minimal lookup for the flat JMSG JSON objects, not a JSON parser.
+**
+*/
+static bool JsonGetInt(const char *Json, const char *Key, long *Value)
+{
+
+   char  Pattern[64];
+   char  *End;
+   const char *Pos;
+
+   snprintf(Pattern, sizeof(Pattern), "\"%s\":", Key);
+   Pos = strstr(Json, Pattern);
+   if (Pos == NULL)
+   {
+      return false;
+   }
+
+   *Value = strtol(Pos + strlen(Pattern), &End, 10);
+
+   return (End != Pos + strlen(Pattern));
+
+} /* End JsonGetInt() */
+
+
+/******************************************************************************
+** Function: JsonGetStr
+**
+** Notes:
+**   1. Escape sequences are copied without being decoded.
+**
+*/
+static bool JsonGetStr(const char *Json, const char *Key, char *Value, size_t ValueLen)
+{
+
+   char    Pattern[64];
+   size_t  i = 0;
+   const char *Pos;
+
+   snprintf(Pattern, sizeof(Pattern), "\"%s\":", Key);
+   Pos = strstr(Json, Pattern);
+   if (Pos == NULL)
+   {
+      return false;
+   }
+
+   Pos += strlen(Pattern);
+   while (*Pos == ' ')
+   {
+      Pos++;
+   }
+   if (*Pos++ != '"')
+   {
+      return false;
+   }
+
+   while (*Pos != '\0' && *Pos != '"')
+   {
+      if (*Pos == '\\' && Pos[1] != '\0')
+      {
+         if (i < ValueLen-1)
+         {
+            Value[i++] = *Pos;
+         }
+         Pos++;
+      }
+      if (i < ValueLen-1)
+      {
+         Value[i++] = *Pos;
+      }
+      Pos++;
+   }
+   Value[i] = '\0';
+
+   return (*Pos == '"');
+
+} /* End JsonGetStr() */
+
+
+/******************************************************************************
+** Function: ParseArgs
+**
+*/
+static void ParseArgs(int argc, char *argv[])
+{
+
+   int   Opt;
+   const char *CfsIpAddr = LOADGEN_CFS_IP_ADDR;
+   const char *NamePrefix = "RPI";
+   uint16_t   CfsPort = LOADGEN_CFS_APP_PORT;
+
+   LoadGen.ListenPort   = LOADGEN_PY_APP_PORT;
+   LoadGen.Rate         = 100.0;
+   LoadGen.BurstLen     = 1;
+   LoadGen.SourceCnt    = 1;
+   LoadGen.ReportPeriod = 1.0;
+   LoadGen.StatusPeriod = 5.0;
+
+   while ((Opt = getopt(argc, argv, "a:p:l:r:b:s:n:x:d:i:t:vh")) != -1)
+   {
+      switch (Opt)
+      {
+         case 'a': CfsIpAddr = optarg; break;
+         case 'p': CfsPort = (uint16_t)atoi(optarg); break;
+         case 'l': LoadGen.ListenPort = (uint16_t)atoi(optarg); break;
+         case 'r': LoadGen.Rate = atof(optarg); break;
+         case 'b': LoadGen.BurstLen = (uint32_t)atoi(optarg); break;
+         case 's': LoadGen.SourceCnt = (uint32_t)atoi(optarg); break;
+         case 'n': NamePrefix = optarg; break;
+         case 'x': LoadGen.SkipEvery = (uint32_t)atoi(optarg); break;
+         case 'd': LoadGen.Duration = atof(optarg); break;
+         case 'i': LoadGen.ReportPeriod = atof(optarg); break;
+         case 't': LoadGen.StatusPeriod = atof(optarg); break;
+         case 'v': LoadGen.Verbose = true; break;
+         default:
+            printf("usage: %s [options]\n"
+                   "  -a addr    cFS JMSG UDP address (%s)\n"
+                   "  -p port    cFS JMSG UDP port (%d)\n"
+                   "  -l port    Script command listen port (%d)\n"
+                   "  -r rate    Telemetry messages per second for all sources (100)\n"
+                   "  -b len     Messages sent back to back per burst (1)\n"
+                   "  -s count   Number of telemetry sources, max %d (1)\n"
+                   "  -n prefix  Source name prefix (RPI)\n"
+                   "  -x n       Skip every nth sequence count to inject loss (0, disabled)\n"
+                   "  -d sec     Run duration, 0 runs until interrupted (0)\n"
+                   "  -i sec     Statistics report period (1)\n"
+                   "  -t sec     Script status report period, 0 disables (5)\n"
+                   "  -v         Print each received script command\n",
+                   argv[0], LOADGEN_CFS_IP_ADDR, LOADGEN_CFS_APP_PORT, LOADGEN_PY_APP_PORT, LOADGEN_MAX_SOURCES);
+            exit(Opt == 'h' ? 0 : 1);
+      }
+   }
+
+   if (LoadGen.Rate <= 0.0 || LoadGen.BurstLen == 0 || LoadGen.ReportPeriod <= 0.0 ||
+       LoadGen.SourceCnt == 0 || LoadGen.SourceCnt > LOADGEN_MAX_SOURCES)
+   {
+      fprintf(stderr, "Invalid rate, burst length, report period or source count\n");
+      exit(1);
+   }
+
+   memset(&LoadGen.CfsAddr, 0, sizeof(LoadGen.CfsAddr));
+   LoadGen.CfsAddr.sin_family = AF_INET;
+   LoadGen.CfsAddr.sin_port   = htons(CfsPort);
+   if (inet_pton(AF_INET, CfsIpAddr, &LoadGen.CfsAddr.sin_addr) != 1)
+   {
+      fprintf(stderr, "Invalid cFS IP address %s\n", CfsIpAddr);
+      exit(1);
+   }
+
+   for (uint32_t i=0; i < LoadGen.SourceCnt; i++)
+   {
+      snprintf(LoadGen.Source[i].Name, LOADGEN_NAME_LEN, "%s-%u", NamePrefix, i);
+      LoadGen.Source[i].SeqCount = 1;
+   }
+
+} /* End ParseArgs() */
+
+
+/******************************************************************************
+** Function: PrintReport
+**
+** Notes:
+**   1. An Interval of zero prints averages since the start.
+**
+*/
+static void PrintReport(const struct timespec *Start, double Interval)
+{
+
+   static uint64_t PrevTlmSentCnt = 0;
+   static uint64_t PrevCmdRcvCnt  = 0;
+
+   struct timespec Now;
+   double   Elapsed;
+   uint64_t TlmSentCnt = atomic_load(&LoadGen.TlmSentCnt);
+   uint64_t CmdRcvCnt  = atomic_load(&LoadGen.CmdRcvCnt);
+
+   clock_gettime(CLOCK_MONOTONIC, &Now);
+   Elapsed = ElapsedSec(Start, &Now);
+   if (Interval <= 0.0)
+   {
+      Interval       = Elapsed;
+      PrevTlmSentCnt = 0;
+      PrevCmdRcvCnt  = 0;
+   }
+
+   printf("%8.1fs tlm: %9.1f msg/s %7.2f MB/s sent %llu skipped %llu send-err %llu late-bursts %llu | "
+          "cmd: %6.1f msg/s rcv %llu valid %llu invalid %llu cancel %llu\n",
+          Elapsed, (TlmSentCnt - PrevTlmSentCnt) / Interval,
+          (double)atomic_load(&LoadGen.TlmBytes) / Elapsed / 1.0e6,
+          (unsigned long long)TlmSentCnt,
+          (unsigned long long)atomic_load(&LoadGen.TlmSkipCnt),
+          (unsigned long long)atomic_load(&LoadGen.TlmSendErrCnt),
+          (unsigned long long)atomic_load(&LoadGen.LateBurstCnt),
+          (CmdRcvCnt - PrevCmdRcvCnt) / Interval,
+          (unsigned long long)CmdRcvCnt,
+          (unsigned long long)atomic_load(&LoadGen.CmdValidCnt),
+          (unsigned long long)atomic_load(&LoadGen.CmdInvalidCnt),
+          (unsigned long long)atomic_load(&LoadGen.CmdCancelCnt));
+   fflush(stdout);
+
+   PrevTlmSentCnt = TlmSentCnt;
+   PrevCmdRcvCnt  = CmdRcvCnt;
+
+} /* End PrintReport() */
+
+
+/******************************************************************************
+** Function: RxThread
+**
+** Receive and validate script commands addressed to the Pi.
+**
+*/
+static void *RxThread(void *Arg)
+{
+
+   int   RxSock;
+   int   Opt = 1;
+   char  JMsg[LOADGEN_JMSG_MAX_LEN+1];
+   ssize_t  Len;
+   struct sockaddr_in ListenAddr;
+   struct pollfd      Poll;
+
+   (void)Arg;
+
+   RxSock = socket(AF_INET, SOCK_DGRAM, 0);
+   setsockopt(RxSock, SOL_SOCKET, SO_REUSEADDR, &Opt, sizeof(Opt));
+
+   memset(&ListenAddr, 0, sizeof(ListenAddr));
+   ListenAddr.sin_family      = AF_INET;
+   ListenAddr.sin_port        = htons(LoadGen.ListenPort);
+   ListenAddr.sin_addr.s_addr = LoadGen.CfsAddr.sin_addr.s_addr;
+
+   if (bind(RxSock, (struct sockaddr *)&ListenAddr, sizeof(ListenAddr)) < 0)
+   {
+      perror("Script command socket bind");
+      close(RxSock);
+      return NULL;
+   }
+
+   Poll.fd     = RxSock;
+   Poll.events = POLLIN;
+
+   while (Running)
+   {
+      if (poll(&Poll, 1, 100) <= 0)
+      {
+         continue;
+      }
+
+      Len = recv(RxSock, JMsg, LOADGEN_JMSG_MAX_LEN, 0);
+      if (Len <= 0)
+      {
+         continue;
+      }
+
+      /* JMSG strings may be padded with nulls */
+      JMsg[Len] = '\0';
+      atomic_fetch_add(&LoadGen.CmdRcvCnt, 1);
+      atomic_fetch_add(&LoadGen.CmdBytes, (uint64_t)Len);
+
+      if (ValidateScriptCmd(JMsg))
+      {
+         atomic_fetch_add(&LoadGen.CmdValidCnt, 1);
+      }
+      else
+      {
+         atomic_fetch_add(&LoadGen.CmdInvalidCnt, 1);
+         printf("Invalid script command %zd bytes: %.*s\n", Len, 200, JMsg);
+      }
+   }
+
+   close(RxSock);
+
+   return NULL;
+
+} /* End RxThread() */
+
+
+/******************************************************************************
+** Function: SendCsvTlm
+**
+*/
+static void SendCsvTlm(const char *Name, uint32_t SeqCount, const char *Params)
+{
+
+   char  JMsg[LOADGEN_JMSG_MAX_LEN];
+   int   Len;
+
+   Len = snprintf(JMsg, sizeof(JMsg), LOADGEN_CSV_TLM_NAME
+                  "{\"name\": \"%s\", \"seq-count\": %u, \"date-time\": \"00/00/0000 00:00:00\",  \"parameters\": \"%s\"}",
+                  Name, SeqCount, Params);
+
+   if (sendto(LoadGen.TxSock, JMsg, Len, 0, (struct sockaddr *)&LoadGen.CfsAddr, sizeof(LoadGen.CfsAddr)) == Len)
+   {
+      atomic_fetch_add(&LoadGen.TlmBytes, (uint64_t)Len);
+   }
+   else
+   {
+      atomic_fetch_add(&LoadGen.TlmSendErrCnt, 1);
+   }
+
+} /* End SendCsvTlm() */
+
+
+/******************************************************************************
+** Function: SendScriptStatus
+**
+** Notes:
+**   1. Parameter order must match PY_SCRIPT's status report definition.
+**      Commands are counted as completed when they're received.
+**
+*/
+static void SendScriptStatus(void)
+{
+
+   char  Params[256];
+   uint64_t LastScriptId = atomic_load(&LoadGen.LastScriptId);
+
+   snprintf(Params, sizeof(Params),
+            "running,0,queued,0,completed,%llu,failed,0,timeout,0,cancelled,0,rejected,0,last-id,%llu,"
+            "cache-hits,0,cache-misses,0,cache-entries,0,compile-time-us,0",
+            (unsigned long long)LastScriptId, (unsigned long long)LastScriptId);
+
+   SendCsvTlm(LOADGEN_SCRIPT_STATUS_NAME, ++LoadGen.StatusSeqCount, Params);
+
+} /* End SendScriptStatus() */
+
+
+/******************************************************************************
+** Function: SignalHandler
+**
+*/
+static void SignalHandler(int Signal)
+{
+
+   (void)Signal;
+
+   Running = 0;
+
+} /* End SignalHandler() */
+
+
+/******************************************************************************
+** Function: TimespecAddNs
+**
+*/
+static void TimespecAddNs(struct timespec *Time, int64_t Ns)
+{
+
+   Time->tv_sec  += Ns / NSEC_PER_SEC;
+   Time->tv_nsec += Ns % NSEC_PER_SEC;
+   if (Time->tv_nsec >= NSEC_PER_SEC)
+   {
+      Time->tv_sec++;
+      Time->tv_nsec -= NSEC_PER_SEC;
+   }
+
+} /* End TimespecAddNs() */
+
+
+/******************************************************************************
+** Function: TxThread
+**
+** Notes:
+**   1. Bursts are scheduled on absolute times so send overhead doesn't lower
+**      the rate. If the thread falls behind the schedule is reset instead of
+**      sending a catch-up burst.
+**   2. Sources are sent round robin.
+**
+*/
+static void *TxThread(void *Arg)
+{
+
+   int64_t   BurstPeriodNs = (int64_t)((double)LoadGen.BurstLen / LoadGen.Rate * NSEC_PER_SEC);
+   uint32_t  SourceIdx = 0;
+   Source_t  *Source;
+   struct timespec NextBurst = *(const struct timespec *)Arg;
+   struct timespec Now;
+
+   while (Running)
+   {
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &NextBurst, NULL);
+
+      for (uint32_t i=0; i < LoadGen.BurstLen; i++)
+      {
+         Source = &LoadGen.Source[SourceIdx];
+         if (LoadGen.SkipEvery > 0 && (Source->SeqCount % LoadGen.SkipEvery) == 0)
+         {
+            Source->SeqCount++;
+            atomic_fetch_add(&LoadGen.TlmSkipCnt, 1);
+         }
+         SendCsvTlm(Source->Name, Source->SeqCount++, SenseHatParams);
+         Source->SentCnt++;
+         atomic_fetch_add(&LoadGen.TlmSentCnt, 1);
+         SourceIdx = (SourceIdx + 1) % LoadGen.SourceCnt;
+      }
+
+      TimespecAddNs(&NextBurst, BurstPeriodNs);
+      clock_gettime(CLOCK_MONOTONIC, &Now);
+      if (ElapsedSec(&NextBurst, &Now) > 0)
+      {
+         atomic_fetch_add(&LoadGen.LateBurstCnt, 1);
+         NextBurst = Now;
+      }
+   }
+
+   return NULL;
+
+} /* End TxThread() */
+
+
+/******************************************************************************
+** Function: ValidateScriptCmd
+**
+** Notes:
+**   1. Checks the topic prefix, command code and that the field used by the
+**      command is present and defined.
+**   2. Valid scripts are given the next script ID, see the file notes.
+**
+*/
+static bool ValidateScriptCmd(const char *JMsg)
+{
+
+   static char ScriptFile[LOADGEN_JMSG_MAX_LEN];
+   static char ScriptText[LOADGEN_JMSG_MAX_LEN];
+   const char  *Json;
+   long  Command;
+   bool  ValidFile;
+   bool  ValidText;
+
+   if (strncmp(JMsg, LOADGEN_SCRIPT_CMD_NAME, strlen(LOADGEN_SCRIPT_CMD_NAME)) != 0)
+   {
+      return false;
+   }
+   Json = JMsg + strlen(LOADGEN_SCRIPT_CMD_NAME);
+
+   if (!JsonGetInt(Json, "command", &Command))
+   {
+      return false;
+   }
+   ValidFile = JsonGetStr(Json, "script-file", ScriptFile, sizeof(ScriptFile));
+   ValidText = JsonGetStr(Json, "script-text", ScriptText, sizeof(ScriptText));
+
+   if (LoadGen.Verbose)
+   {
+      printf("Script command %ld, file '%s', text '%s'\n", Command, ScriptFile, ScriptText);
+   }
+
+   if (Command == RUN_SCRIPT_TEXT_CMD)
+   {
+      if (!ValidText || ScriptText[0] == '\0')
+      {
+         return false;
+      }
+      if (strncmp(ScriptText, LOADGEN_SCRIPT_CANCEL_PREFIX, strlen(LOADGEN_SCRIPT_CANCEL_PREFIX)) == 0)
+      {
+         atomic_fetch_add(&LoadGen.CmdCancelCnt, 1);
+      }
+      for (size_t i=0; i < sizeof(ControlTextPrefix)/sizeof(ControlTextPrefix[0]); i++)
+      {
+         if (strncmp(ScriptText, ControlTextPrefix[i], strlen(ControlTextPrefix[i])) == 0)
+         {
+            return true;
+         }
+      }
+      atomic_fetch_add(&LoadGen.LastScriptId, 1);
+      return true;
+   }
+   else if (Command == RUN_SCRIPT_FILE_CMD)
+   {
+      if (ValidFile && ScriptFile[0] != '\0' && strcmp(ScriptFile, "Undefined") != 0)
+      {
+         atomic_fetch_add(&LoadGen.LastScriptId, 1);
+         return true;
+      }
+      return false;
+   }
+
+   return false;
+
+} /* End ValidateScriptCmd() */
@@ -0,0 +1,748 @@
+"""
+    Copyright 2022 bitValence, Inc.
+    All Rights Reserved.
+
+    This program is free software; you can modify and/or redistribute it
+    under the terms of the GNU Affero General Public License
+    as published by the Free Software Foundation; version 3 with
+    attribution addendums as found in the LICENSE.txt.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    Purpose:
+      Decode the Astro Pi cFS app's telemetry on the ground and archive it
+      for time range queries
+
+    Notes:
+      1. Usage:
+           astro_pi_tlm.py decode <capture file>      Archive a capture file
+           astro_pi_tlm.py listen [capture file]      Archive telemetry from TLM_PORT
+           astro_pi_tlm.py query <packet> <start> <end> [column ...]
+           astro_pi_tlm.py info                       Summarize the archive
+           astro_pi_tlm.py bench [packets]            Measure packets per second
+         Times are cFE seconds. Settings are in astro_pi.ini's TLM_ARCHIVE
+         and TLM_MSG_IDS sections.
+      2. Packet layouts are built from astro_pi.xml so the decoder follows
+         interface changes. Packets are in the EDS packed encoding: the CCSDS
+         primary header, a telemetry secondary header with 32 bit seconds and
+         16 bit subseconds and the payload with no padding in BYTE_ORDER.
+      3. A UDP datagram can hold one packet or several back to back, either
+         may be zlib compressed. A compressed datagram is recognized by its
+         zlib header, 0x78 can't start a telemetry packet. Capture files are
+         packets back to back and may be gzip compressed. listen writes the
+         decompressed packets it receives to its capture file.
+      4. Packets are identified by the message IDs in TLM_MSG_IDS. The IDs
+         are mission assignments so they default to 0, not configured, and
+         MATCH_LENGTH defaults to on: an unknown message ID is identified by
+         its packet length when exactly one fixed length packet matches. A
+         warning is printed when no IDs are configured. Packets that end in
+         a byte array, like ScriptOutputTlm, may be shortened to their used
+         length and are zero filled, they're only decoded by message ID.
+      5. Each packet type's raw packets are queued and decoded BLOCK_ROWS at
+         a time with one struct iter_unpack and a transpose into columns, so
+         the per packet python work is the primary header check.
+      6. A block's columns are written as a chunk file in the packet's time
+         partition, ARCHIVE_DIR/<packet>/<partition start>/<n>.apc. A chunk
+         has a JSON header followed by each column's array bytes. A line is
+         appended to ARCHIVE_DIR/index.jsonl with each chunk's time range
+         after the chunk is written. A query only opens the chunks that
+         overlap its range and when a chunk's rows are in time order it
+         bisects the Time column and only reads the matching rows.
+      7. Every packet has Time and Seq columns. Nested container entries
+         are named with dots and container array elements are indexed, e.g.
+         Task[2].BusyPct. Number arrays and strings are one column with
+         several values per row.
+
+"""
+
+import argparse
+import array
+import bisect
+import collections
+import configparser
+import csv
+import gzip
+import itertools
+import json
+import operator
+import os
+import random
+import shutil
+import socket
+import struct
+import sys
+import tempfile
+import time
+import zlib
+import xml.etree.ElementTree as ET
+
+TLM_HDR_BASE_TYPE = 'CFE_HDR/TelemetryHeader'
+PAYLOAD_PREFIX    = 'Payload.'
+CCSDS_PRI_HDR     = struct.Struct('>HHH')
+CCSDS_PRI_HDR_LEN = 6
+CCSDS_SEQ_MASK    = 0x3FFF
+SUBSEC_PER_SEC    = 65536.0
+ZLIB_HDR          = 0x78
+GZIP_MAGIC        = b'\x1f\x8b'
+
+CHUNK_MAGIC = b'APC1'
+CHUNK_EXT   = '.apc'
+INDEX_FILE  = 'index.jsonl'
+READ_BLOCK  = 1 << 20
+
+INT32_CODE  = 'i' if array.array('i').itemsize == 4 else 'l'
+UINT32_CODE = 'I' if array.array('I').itemsize == 4 else 'L'
+
+# EDS base type to (struct format, array typecode)
+BASE_TYPES = {
+    'int8':   ('b', 'b'),
+    'uint8':  ('B', 'B'),
+    'int16':  ('h', 'h'),
+    'uint16': ('H', 'H'),
+    'int32':  ('i', INT32_CODE),
+    'uint32': ('I', UINT32_CODE),
+    'int64':  ('q', 'q'),
+    'uint64': ('Q', 'Q'),
+    'float':  ('f', 'f'),
+    'double': ('d', 'd'),
+}
+
+# EDS base string lengths, must match the mission's OS_MAX_PATH_LEN and OS_MAX_API_NAME
+BASE_STRINGS = {
+    'PathName': 64,
+    'ApiName':  20,
+}
+
+config = configparser.ConfigParser()
+config.read('astro_pi.ini')
+EDS_FILE      = config.get('TLM_ARCHIVE','EDS_FILE')
+ARCHIVE_DIR   = config.get('TLM_ARCHIVE','ARCHIVE_DIR')
+PARTITION_SEC = config.getint('TLM_ARCHIVE','PARTITION_SEC')
+BLOCK_ROWS    = config.getint('TLM_ARCHIVE','BLOCK_ROWS')
+FLUSH_PERIOD  = config.getfloat('TLM_ARCHIVE','FLUSH_PERIOD')
+TLM_PORT      = config.getint('TLM_ARCHIVE','TLM_PORT')
+BYTE_ORDER    = config.get('TLM_ARCHIVE','BYTE_ORDER')
+MATCH_LENGTH  = config.getboolean('TLM_ARCHIVE','MATCH_LENGTH')
+TLM_MSG_IDS   = {name.lower(): int(value, 0) for name, value in config.items('TLM_MSG_IDS')}
+
+
+def local_name(tag):
+    return tag.rsplit('}', 1)[-1]
+
+
+class Column():
+    """
+    A payload column. Width is the values per row, byte strings are one
+    struct 's' value and are stored as uint8 arrays.
+    """
+    def __init__(self, name, fmt, typecode, width, is_bytes):
+        self.name     = name
+        self.fmt      = fmt
+        self.typecode = typecode
+        self.width    = width
+        self.is_bytes = is_bytes
+        self.fields   = 1 if (is_bytes or width == 1) else width
+
+
+class EdsLayout():
+    """
+    Flatten astro_pi.xml's telemetry containers into columns
+    """
+    def __init__(self, eds_file):
+        self.types = {}
+        root = ET.parse(eds_file).getroot()
+        for elem in root.iter():
+            if local_name(elem.tag) in ('ContainerDataType', 'ArrayDataType', 'EnumeratedDataType', 'StringDataType'):
+                self.types[elem.get('name')] = elem
+
+    def packet_names(self):
+        return [name for name, elem in self.types.items()
+                if local_name(elem.tag) == 'ContainerDataType' and elem.get('baseType') == TLM_HDR_BASE_TYPE]
+
+    def columns(self, type_ref, prefix):
+        ns, _, name = type_ref.rpartition('/')
+        if ns in ('', 'BASE_TYPES') and name in BASE_TYPES and name not in self.types:
+            fmt, typecode = BASE_TYPES[name]
+            return [Column(prefix, fmt, typecode, 1, False)]
+        if ns == 'BASE_TYPES' and name in BASE_STRINGS:
+            return [Column(prefix, f'{BASE_STRINGS[name]}s', 'B', BASE_STRINGS[name], True)]
+        if ns not in ('', 'ASTRO_PI') or name not in self.types:
+            sys.exit(f'{EDS_FILE}: {prefix} has unsupported type {type_ref}')
+        elem = self.types[name]
+        kind = local_name(elem.tag)
+        if kind == 'EnumeratedDataType':
+            return self.enum_column(elem, prefix)
+        if kind == 'StringDataType':
+            length = int(elem.get('length'))
+            return [Column(prefix, f'{length}s', 'B', length, True)]
+        if kind == 'ArrayDataType':
+            return self.array_columns(elem, prefix)
+        columns = []
+        for entry_list in elem:
+            if local_name(entry_list.tag) == 'EntryList':
+                for entry in entry_list:
+                    if local_name(entry.tag) == 'Entry':
+                        entry_name = f'{prefix}.{entry.get("name")}' if prefix else entry.get('name')
+                        columns += self.columns(entry.get('type'), entry_name)
+        return columns
+
+    def enum_column(self, elem, prefix):
+        for child in elem:
+            if local_name(child.tag) == 'IntegerDataEncoding':
+                base = f'{"int" if child.get("encoding") == "signed" else "uint"}{child.get("sizeInBits")}'
+                fmt, typecode = BASE_TYPES[base]
+                return [Column(prefix, fmt, typecode, 1, False)]
+        sys.exit(f'{EDS_FILE}: {elem.get("name")} has no IntegerDataEncoding')
+
+    def array_columns(self, elem, prefix):
+        size = 1
+        for dim in elem.iter():
+            if local_name(dim.tag) == 'Dimension':
+                size *= int(dim.get('size'))
+        element = self.columns(elem.get('dataTypeRef'), prefix)
+        if len(element) == 1 and element[0].width == 1:
+            col = element[0]
+            if col.fmt in ('B', 'b'):
+                return [Column(prefix, f'{size}s', col.typecode, size, True)]
+            return [Column(prefix, f'{size}{col.fmt}', col.typecode, size, False)]
+        columns = []
+        for i in range(size):
+            columns += self.columns(elem.get('dataTypeRef'), f'{prefix}[{i}]')
+        return columns
+
+
+class PacketType():
+    """
+    A telemetry packet's layout. Raw packets are decoded from the start of
+    the primary header: the stream ID and length are skipped and the
+    sequence count and secondary header time become the Seq and Time columns.
+    """
+    def __init__(self, name, columns, byte_order):
+        self.name    = name
+        self.columns = columns
+        order = '>' if byte_order == 'big' else '<'
+        self.struct  = struct.Struct(order + '2xH2xIH' + ''.join(col.fmt for col in columns))
+        self.size    = self.struct.size
+        last = columns[-1] if columns else None
+        self.min_size = self.size - last.width if (last and last.is_bytes) else self.size
+
+    def decode_block(self, raw):
+        """
+        Return a dict of column name to array for a buffer of whole packets
+        """
+        fields = list(zip(*self.struct.iter_unpack(raw)))
+        subsec_sec = map(operator.mul, fields[2], itertools.repeat(1.0/SUBSEC_PER_SEC))
+        out = {
+            'Time': array.array('d', map(operator.add, fields[1], subsec_sec)),
+            'Seq':  array.array('H', map(operator.and_, fields[0], itertools.repeat(CCSDS_SEQ_MASK))),
+        }
+        i = 3
+        for col in self.columns:
+            if col.is_bytes:
+                values = array.array(col.typecode, b''.join(fields[i]))
+            elif col.width == 1:
+                values = array.array(col.typecode, fields[i])
+            else:
+                values = array.array(col.typecode, itertools.chain.from_iterable(zip(*fields[i:i+col.fields])))
+            out[col.name] = values
+            i += col.fields
+        return out
+
+    def widths(self):
+        widths = {'Time': 1, 'Seq': 1}
+        widths.update({col.name: col.width for col in self.columns})
+        return widths
+
+
+def load_packet_types(eds_file, byte_order):
+    layout = EdsLayout(eds_file)
+    packet_types = {}
+    for name in layout.packet_names():
+        columns = layout.columns(name, '')
+        for col in columns:
+            col.name = col.name[len(PAYLOAD_PREFIX):] if col.name.startswith(PAYLOAD_PREFIX) else col.name
+        packet_types[name] = PacketType(name, columns, byte_order)
+    return packet_types
+
+
+class Archive():
+    """
+    Time partitioned column chunks with an append only chunk index
+    """
+    def __init__(self, path, partition_sec=PARTITION_SEC):
+        self.path = path
+        self.partition_sec = partition_sec
+        self.next_chunk = {}
+        self.index = None
+        self.chunk_cnt = 0
+        os.makedirs(path, exist_ok=True)
+
+    def append(self, ptype, columns):
+        """
+        Write a decoded block split at partition boundaries
+        """
+        t = columns['Time']
+        rows = len(t)
+        if rows == 0:
+            return
+        in_order = not any(map(operator.gt, t, itertools.islice(t, 1, None)))
+        widths = ptype.widths()
+        if in_order:
+            first = int(t[0] // self.partition_sec)
+            last  = int(t[-1] // self.partition_sec)
+            start = 0
+            for partition in range(first, last+1):
+                end = bisect.bisect_left(t, (partition+1)*self.partition_sec, start)
+                if end > start:
+                    self.write_chunk(ptype.name, partition, widths,
+                                     {name: col[start*widths[name]:end*widths[name]] for name, col in columns.items()},
+                                     True)
+                start = end
+        else:
+            groups = collections.defaultdict(list)
+            for row, row_time in enumerate(t):
+                groups[int(row_time // self.partition_sec)].append(row)
+            for partition, row_list in sorted(groups.items()):
+                chunk = {}
+                for name, col in columns.items():
+                    w = widths[name]
+                    chunk[name] = array.array(col.typecode, itertools.chain.from_iterable(col[r*w:(r+1)*w] for r in row_list))
+                self.write_chunk(ptype.name, partition, widths, chunk, False)
+
+    def write_chunk(self, packet, partition, widths, columns, in_order):
+        part_dir = os.path.join(self.path, packet, f'{partition*self.partition_sec:010d}')
+        key = (packet, partition)
+        if key not in self.next_chunk:
+            os.makedirs(part_dir, exist_ok=True)
+            self.next_chunk[key] = len([f for f in os.listdir(part_dir) if f.endswith(CHUNK_EXT)])
+        chunk_file = os.path.join(part_dir, f'{self.next_chunk[key]:06d}{CHUNK_EXT}')
+        self.next_chunk[key] += 1
+
+        t = columns['Time']
+        header = {'packet': packet, 'rows': len(t), 'byteorder': sys.byteorder, 'sorted': in_order,
+                  't_min': min(t), 't_max': max(t), 'columns': []}
+        offset = 0
+        for name, col in columns.items():
+            header['columns'].append([name, col.typecode, widths[name], offset])
+            offset += len(col) * col.itemsize
+        header_bytes = json.dumps(header).encode('utf-8')
+        with open(chunk_file, 'wb') as f:
+            f.write(CHUNK_MAGIC + struct.pack('<I', len(header_bytes)) + header_bytes)
+            for col in columns.values():
+                col.tofile(f)
+
+        entry = {'packet': packet, 'file': os.path.relpath(chunk_file, self.path), 'rows': len(t),
+                 't_min': header['t_min'], 't_max': header['t_max']}
+        with open(os.path.join(self.path, INDEX_FILE), 'a') as f:
+            f.write(json.dumps(entry) + '\n')
+        if self.index is not None:
+            self.index.append(entry)
+        self.chunk_cnt += 1
+
+    def load_index(self):
+        if self.index is None:
+            self.index = []
+            try:
+                with open(os.path.join(self.path, INDEX_FILE)) as f:
+                    for line in f:
+                        try:
+                            self.index.append(json.loads(line))
+                        except ValueError:
+                            pass   # Partial line from an interrupted write
+            except FileNotFoundError:
+                pass
+        return self.index
+
+    def query(self, packet, start, end, names=None):
+        """
+        Return (columns, widths) for the packet's rows with start <= Time <= end
+        in chunk order. Columns are flat arrays with widths values per row.
+        """
+        chunks = sorted((e for e in self.load_index()
+                         if e['packet'] == packet and e['t_max'] >= start and e['t_min'] <= end),
+                        key=operator.itemgetter('t_min'))
+        columns = {}
+        widths  = {}
+        for entry in chunks:
+            self.read_chunk(os.path.join(self.path, entry['file']), start, end, names, columns, widths)
+        return columns, widths
+
+    def read_chunk(self, chunk_file, start, end, names, columns, widths):
+        with open(chunk_file, 'rb') as f:
+            if f.read(4) != CHUNK_MAGIC:
+                raise ValueError(f'{chunk_file} is not an archive chunk')
+            header_len = struct.unpack('<I', f.read(4))[0]
+            header = json.loads(f.read(header_len))
+            data_start = 8 + header_len
+            rows = header['rows']
+            swap = header['byteorder'] != sys.byteorder
+            layout = {c[0]: c[1:] for c in header['columns']}
+            wanted = list(layout) if not names else ['Time'] + [n for n in names if n != 'Time']
+            for name in wanted:
+                if name not in layout:
+                    raise KeyError(f'{header["packet"]} has no column {name}')
+
+            def read_rows(name, first, last):
+                typecode, width, offset = layout[name]
+                values = array.array(typecode)
+                f.seek(data_start + offset + first*width*values.itemsize)
+                values.frombytes(f.read((last-first)*width*values.itemsize))
+                if swap:
+                    values.byteswap()
+                return values
+
+            if header['t_min'] >= start and header['t_max'] <= end:
+                selected = (0, rows)
+            elif header['sorted']:
+                t = read_rows('Time', 0, rows)
+                selected = (bisect.bisect_left(t, start), bisect.bisect_right(t, end))
+            else:
+                t = read_rows('Time', 0, rows)
+                selected = [i for i, row_time in enumerate(t) if start <= row_time <= end]
+
+            for name in wanted:
+                typecode, width, _ = layout[name]
+                if isinstance(selected, tuple):
+                    values = read_rows(name, *selected)
+                else:
+                    col = read_rows(name, 0, rows)
+                    values = array.array(typecode, itertools.chain.from_iterable(col[r*width:(r+1)*width] for r in selected))
+                if name in columns:
+                    columns[name].extend(values)
+                else:
+                    columns[name] = values
+                    widths[name]  = width
+
+
+class PacketQueue():
+    """
+    A packet type's raw packets waiting to be decoded
+    """
+    def __init__(self, ptype, block_rows):
+        self.ptype = ptype
+        self.buf   = bytearray()
+        self.size  = ptype.size
+        self.min_size    = ptype.min_size
+        self.block_bytes = block_rows * ptype.size
+
+
+class TlmDecoder():
+    """
+    Split datagrams and capture data into packets, queue them by packet type
+    and archive decoded blocks
+    """
+    def __init__(self, packet_types, msg_ids, archive, match_length=MATCH_LENGTH, block_rows=BLOCK_ROWS):
+        self.archive = archive
+        self.queues  = {name: PacketQueue(ptype, block_rows) for name, ptype in packet_types.items()}
+        self.by_mid  = {}
+        for name, queue in self.queues.items():
+            msg_id = msg_ids.get(name.lower(), 0)
+            if msg_id != 0:
+                self.by_mid[msg_id] = queue
+        self.by_len = {}
+        if match_length:
+            for queue in self.queues.values():
+                if queue.min_size == queue.size:
+                    self.by_len[queue.size] = None if queue.size in self.by_len else queue
+        if not self.by_mid:
+            if match_length:
+                print('Warning: No TLM_MSG_IDS configured, packets are only identified by their length')
+            else:
+                print('Warning: No TLM_MSG_IDS configured and MATCH_LENGTH is off, no packets will be decoded')
+        self.unknown = set()
+        self.stats   = collections.Counter()
+
+    def expand(self, data):
+        """
+        Return a datagram's packets, decompressing it if needed
+        """
+        if len(data) > 0 and data[0] == ZLIB_HDR:
+            try:
+                data = zlib.decompress(data)
+                self.stats['compressed'] += 1
+            except zlib.error:
+                self.stats['zlib_err'] += 1
+                return b''
+        return data
+
+    def ingest_datagram(self, datagram):
+        data = self.expand(datagram)
+        used = self.ingest(data)
+        if used < len(data):
+            self.stats['trunc_err'] += 1
+        return data
+
+    def ingest(self, data):
+        """
+        Queue the whole packets at the start of data and return the bytes used
+        """
+        unpack_hdr = CCSDS_PRI_HDR.unpack_from
+        by_mid = self.by_mid
+        mv  = memoryview(data)
+        end = len(data) - CCSDS_PRI_HDR_LEN
+        offset = 0
+        packets = 0
+        while offset <= end:
+            stream_id, _, length = unpack_hdr(data, offset)
+            next_offset = offset + length + 7
+            if next_offset > len(data):
+                break
+            queue = by_mid.get(stream_id)
+            if queue is None:
+                queue = self.identify(stream_id, next_offset - offset)
+            if queue is not None:
+                buf = queue.buf
+                buf += mv[offset:next_offset]
+                if next_offset - offset != queue.size:
+                    self.pad(queue, next_offset - offset)
+                if len(buf) >= queue.block_bytes:
+                    self.flush(queue)
+            packets += 1
+            offset = next_offset
+        self.stats['packets'] += packets
+        self.stats['bytes']   += offset
+        return offset
+
+    def pad(self, queue, pkt_len):
+        """
+        Zero fill a shortened packet or drop a packet with an invalid length
+        """
+        if queue.min_size <= pkt_len < queue.size:
+            queue.buf += bytes(queue.size - pkt_len)
+        else:
+            del queue.buf[len(queue.buf)-pkt_len:]
+            self.stats['length_err'] += 1
+
+    def identify(self, stream_id, pkt_len):
+        if stream_id in self.unknown:
+            self.stats['unknown'] += 1
+            return None
+        queue = self.by_len.get(pkt_len)
+        if queue is not None:
+            self.by_mid[stream_id] = queue
+            print(f'Message ID 0x{stream_id:04X} identified as {queue.ptype.name} by its {pkt_len} byte length')
+        else:
+            self.unknown.add(stream_id)
+            self.stats['unknown'] += 1
+            print(f'Ignoring unknown message ID 0x{stream_id:04X}, {pkt_len} byte packet')
+        return queue
+
+    def flush(self, queue):
+        if not queue.buf:
+            return
+        ptype = queue.ptype
+        columns = ptype.decode_block(bytes(queue.buf))
+        self.stats[ptype.name] += len(queue.buf) // queue.size
+        queue.buf.clear()
+        if self.archive is not None:
+            self.archive.append(ptype, columns)
+
+    def flush_all(self):
+        for queue in self.queues.values():
+            self.flush(queue)
+
+    def decode_file(self, capture_file):
+        with open(capture_file, 'rb') as f:
+            compressed = f.read(2) == GZIP_MAGIC
+        with (gzip.open(capture_file, 'rb') if compressed else open(capture_file, 'rb')) as f:
+            tail = b''
+            while True:
+                block = f.read(READ_BLOCK)
+                if not block:
+                    break
+                data = tail + block
+                used = self.ingest(data)
+                tail = data[used:]
+            if tail:
+                self.stats['trunc_err'] += 1
+        self.flush_all()
+
+    def listen(self, port, capture_file=None):
+        rx_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        rx_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        rx_socket.bind(('', port))
+        rx_socket.settimeout(FLUSH_PERIOD)
+        capture = open(capture_file, 'ab') if capture_file else None
+        last_flush = time.monotonic()
+        print(f'Listening for telemetry on port {port}')
+        try:
+            while True:
+                try:
+                    datagram = rx_socket.recv(65536)
+                    data = self.ingest_datagram(datagram)
+                    if capture:
+                        capture.write(data)
+                except socket.timeout:
+                    pass
+                if time.monotonic() - last_flush >= FLUSH_PERIOD:
+                    self.flush_all()
+                    if capture:
+                        capture.flush()
+                    last_flush = time.monotonic()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.flush_all()
+            if capture:
+                capture.close()
+            rx_socket.close()
+
+    def summary(self):
+        for key, value in sorted(self.stats.items()):
+            print(f'  {key:<20} {value}')
+
+
+def format_value(values, row, width, is_bytes):
+    if width == 1:
+        return str(values[row])
+    row_values = values[row*width:(row+1)*width]
+    if is_bytes:
+        return row_values.tobytes().rstrip(b'\0').decode('utf-8', 'replace')
+    return ' '.join(str(v) for v in row_values)
+
+
+def query_cmd(args):
+    packet_types = load_packet_types(EDS_FILE, BYTE_ORDER)
+    if args.packet not in packet_types:
+        sys.exit(f'Unknown packet {args.packet}, packets are {", ".join(sorted(packet_types))}')
+    is_bytes = {col.name: col.is_bytes for col in packet_types[args.packet].columns}
+    columns, widths = Archive(ARCHIVE_DIR).query(args.packet, args.start, args.end, args.columns)
+    names = args.columns if args.columns else list(columns)
+    if 'Time' not in names:
+        names = ['Time'] + names
+    writer = csv.writer(sys.stdout)
+    writer.writerow(names)
+    for row in range(len(columns.get('Time', []))):
+        writer.writerow([format_value(columns[n], row, widths[n], is_bytes.get(n, False)) for n in names])
+
+
+def info_cmd(args):
+    archive = Archive(ARCHIVE_DIR)
+    packets = collections.defaultdict(lambda: [0, 0, float('inf'), float('-inf')])
+    for entry in archive.load_index():
+        p = packets[entry['packet']]
+        p[0] += 1
+        p[1] += entry['rows']
+        p[2] = min(p[2], entry['t_min'])
+        p[3] = max(p[3], entry['t_max'])
+    print(f'{"Packet":<16} {"Chunks":>8} {"Rows":>12}  Time range')
+    for name, (chunks, rows, t_min, t_max) in sorted(packets.items()):
+        print(f'{name:<16} {chunks:>8} {rows:>12}  {t_min:.3f} - {t_max:.3f}')
+
+
+def make_bench_packets(packet_types, msg_ids, count, rate_hz):
+    """
+    Return a buffer of SenseHatTlm packets at rate_hz with a StatusTlm packet
+    every second, like the app's default telemetry
+    """
+    sense_hat = packet_types['SenseHatTlm']
+    status    = packet_types['StatusTlm']
+    status_template = bytearray(status.size)
+    CCSDS_PRI_HDR.pack_into(status_template, 0, msg_ids['statustlm'], 0xC000, status.size - 7)
+    sense_hat_hdr = struct.Struct('>HHHIH')
+    order = '>' if BYTE_ORDER == 'big' else '<'
+    sense_hat_payload = struct.Struct(order + ''.join(col.fmt for col in sense_hat.columns))
+    time_fmt = struct.Struct(order + 'IH')
+    buf = bytearray()
+    status_cnt = 0
+    for i in range(count):
+        t = 1000000.0 + i / rate_hz
+        sec = int(t)
+        subsec = int((t - sec) * SUBSEC_PER_SEC)
+        buf += sense_hat_hdr.pack(msg_ids['sensehattlm'], 0xC000 | (i & CCSDS_SEQ_MASK), sense_hat.size - 7, 0, 0)
+        time_fmt.pack_into(buf, len(buf) - 6, sec, subsec)
+        buf += sense_hat_payload.pack(*([random.random() for _ in range(9)] + [i & 0xFFFF]*4))
+        if i % rate_hz == 0:
+            time_fmt.pack_into(status_template, CCSDS_PRI_HDR_LEN, sec, subsec)
+            CCSDS_PRI_HDR.pack_into(status_template, 0, msg_ids['statustlm'], 0xC000 | (status_cnt & CCSDS_SEQ_MASK), status.size - 7)
+            buf += status_template
+            status_cnt += 1
+    return bytes(buf), count + status_cnt
+
+
+def bench_cmd(args):
+    packet_types = load_packet_types(EDS_FILE, BYTE_ORDER)
+    msg_ids = {'sensehattlm': 0x0900, 'statustlm': 0x0901}
+    rate_hz = 10
+    data, packets = make_bench_packets(packet_types, msg_ids, args.packets, rate_hz)
+    print(f'{packets} packets, {len(data)} bytes, SenseHatTlm at {rate_hz} Hz with StatusTlm at 1 Hz')
+
+    decoder = TlmDecoder(packet_types, msg_ids, None)
+    start = time.perf_counter()
+    decoder.ingest(data)
+    decoder.flush_all()
+    elapsed = time.perf_counter() - start
+    print(f'Decode:           {packets/elapsed:12.0f} packets/s  {len(data)/elapsed/1e6:8.1f} MB/s')
+
+    archive_dir = tempfile.mkdtemp(prefix='astro_pi_tlm_')
+    try:
+        archive = Archive(archive_dir)
+        decoder = TlmDecoder(packet_types, msg_ids, archive)
+        start = time.perf_counter()
+        decoder.ingest(data)
+        decoder.flush_all()
+        elapsed = time.perf_counter() - start
+        print(f'Decode + archive: {packets/elapsed:12.0f} packets/s  {len(data)/elapsed/1e6:8.1f} MB/s  {archive.chunk_cnt} chunks')
+
+        archive = Archive(archive_dir)
+        span = args.packets / rate_hz
+        queries = 20
+        rows = 0
+        start = time.perf_counter()
+        for _ in range(queries):
+            t0 = 1000000.0 + random.uniform(0, span*0.9)
+            columns, _ = archive.query('SenseHatTlm', t0, t0 + span*0.05, ['AccelX', 'AccelY', 'AccelZ'])
+            rows += len(columns.get('Time', []))
+        elapsed = time.perf_counter() - start
+        print(f'Query:            {queries/elapsed:12.1f} queries/s  {rows/elapsed:12.0f} rows/s, 5% time ranges')
+    finally:
+        shutil.rmtree(archive_dir)
+
+
+def decode_cmd(args):
+    decoder = TlmDecoder(load_packet_types(EDS_FILE, BYTE_ORDER), TLM_MSG_IDS, Archive(ARCHIVE_DIR))
+    start = time.perf_counter()
+    decoder.decode_file(args.capture)
+    elapsed = time.perf_counter() - start
+    print(f'Decoded {args.capture} in {elapsed:.2f} s, {decoder.stats["packets"]/max(elapsed, 1e-9):.0f} packets/s')
+    decoder.summary()
+
+
+def listen_cmd(args):
+    decoder = TlmDecoder(load_packet_types(EDS_FILE, BYTE_ORDER), TLM_MSG_IDS, Archive(ARCHIVE_DIR))
+    decoder.listen(TLM_PORT, args.capture)
+    decoder.summary()
+
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description='Decode and archive Astro Pi cFS app telemetry')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    cmd = commands.add_parser('decode', help='Archive a capture file')
+    cmd.add_argument('capture')
+    cmd.set_defaults(func=decode_cmd)
+
+    cmd = commands.add_parser('listen', help='Archive telemetry received on TLM_PORT')
+    cmd.add_argument('capture', nargs='?', help='Also append the received packets to this file')
+    cmd.set_defaults(func=listen_cmd)
+
+    cmd = commands.add_parser('query', help='Print a packet\'s columns for a time range as CSV')
+    cmd.add_argument('packet')
+    cmd.add_argument('start', type=float)
+    cmd.add_argument('end', type=float)
+    cmd.add_argument('columns', nargs='*')
+    cmd.set_defaults(func=query_cmd)
+
+    cmd = commands.add_parser('info', help='Summarize the archive')
+    cmd.set_defaults(func=info_cmd)
+
+    cmd = commands.add_parser('bench', help='Measure decode, archive and query rates')
+    cmd.add_argument('packets', nargs='?', type=int, default=500000)
+    cmd.set_defaults(func=bench_cmd)
+
+    args = parser.parse_args()
+    args.func(args)
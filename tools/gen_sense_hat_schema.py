@@ -0,0 +1,239 @@
+"""
+    Copyright 2022 bitValence, Inc.
+    All Rights Reserved.
+
+    This program is free software; you can modify and/or redistribute it
+    under the terms of the GNU Affero General Public License
+    as published by the Free Software Foundation; version 3 with
+    attribution addendums as found in the LICENSE.txt.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    Purpose:
+      Generate the Sense HAT CSV telemetry schema header from the EDS
+
+    Notes:
+      1. Usage: gen_sense_hat_schema.py <astro_pi.xml> <sense_hat_schema.h>
+      2. Each SenseHatTlm_Payload entry becomes a schema field. The CSV
+         parameter name is the entry name converted from CamelCase to
+         lower case words separated by dashes, e.g. AccelX is "accel-x".
+      3. The name lookup uses a seeded 32-bit FNV-1a hash. Seeds are tried
+         until every name maps to a different slot so the flight code needs
+         one hash and one compare per parameter. The C hash function is
+         emitted with the table so the two can't drift apart.
+
+"""
+
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+PAYLOAD_NAME = 'SenseHatTlm_Payload'
+C_STRUCT     = 'ASTRO_PI_SenseHatTlm_Payload_t'
+MAX_FIELDS   = 32   # Flight code tracks received fields in a uint32 mask
+MAX_SEEDS    = 100000
+
+# EDS base type to schema type
+BASE_TYPES = {
+    'float':  'SENSE_HAT_SCHEMA_FLOAT',
+    'double': 'SENSE_HAT_SCHEMA_DOUBLE',
+    'int8':   'SENSE_HAT_SCHEMA_INT8',
+    'int16':  'SENSE_HAT_SCHEMA_INT16',
+    'int32':  'SENSE_HAT_SCHEMA_INT32',
+    'uint8':  'SENSE_HAT_SCHEMA_UINT8',
+    'uint16': 'SENSE_HAT_SCHEMA_UINT16',
+    'uint32': 'SENSE_HAT_SCHEMA_UINT32',
+}
+
+SCHEMA_TYPES = ['SENSE_HAT_SCHEMA_FLOAT', 'SENSE_HAT_SCHEMA_DOUBLE',
+                'SENSE_HAT_SCHEMA_INT8',  'SENSE_HAT_SCHEMA_INT16',  'SENSE_HAT_SCHEMA_INT32',
+                'SENSE_HAT_SCHEMA_UINT8', 'SENSE_HAT_SCHEMA_UINT16', 'SENSE_HAT_SCHEMA_UINT32']
+
+
+def local_name(tag):
+    return tag.rsplit('}', 1)[-1]
+
+
+def read_payload_entries(eds_file):
+    """
+    Return a list of (entry name, EDS base type) in payload order
+    """
+    root = ET.parse(eds_file).getroot()
+    for elem in root.iter():
+        if local_name(elem.tag) == 'ContainerDataType' and elem.get('name') == PAYLOAD_NAME:
+            entries = []
+            for entry in elem.iter():
+                if local_name(entry.tag) == 'Entry':
+                    base_type = entry.get('type').rsplit('/', 1)[-1]
+                    if base_type not in BASE_TYPES:
+                        sys.exit(f'{eds_file}: {PAYLOAD_NAME} entry {entry.get("name")} has unsupported type {entry.get("type")}')
+                    entries.append((entry.get('name'), base_type))
+            return entries
+    sys.exit(f'{eds_file}: {PAYLOAD_NAME} container not found')
+
+
+def csv_name(entry_name):
+    return re.sub(r'(?<=[a-z0-9])(?=[A-Z])', '-', entry_name).lower()
+
+
+def fnv1a(name, seed):
+    h = (2166136261 ^ seed) & 0xFFFFFFFF
+    for c in name.encode('ascii'):
+        h ^= c
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def fnv1a_slot(name, seed, slots):
+    """
+    Fold the high half into the low half since names that only differ in
+    their last character, e.g. rate-x and rate-y, only differ in the low bits
+    """
+    h = fnv1a(name, seed)
+    return (h ^ (h >> 16)) & (slots-1)
+
+
+def find_perfect_hash(names):
+    """
+    Return (seed, slots, table) where table[slot] is a field index or -1.
+    Slots is the smallest power of 2 at least twice the field count so a
+    seed is found quickly and unknown names usually land on an empty slot.
+    """
+    slots = 1
+    while slots < 2*len(names):
+        slots *= 2
+    for seed in range(MAX_SEEDS):
+        table = [-1] * slots
+        for i, name in enumerate(names):
+            slot = fnv1a_slot(name, seed, slots)
+            if table[slot] >= 0:
+                break
+            table[slot] = i
+        else:
+            return seed, slots, table
+    sys.exit(f'No collision free hash seed found for {len(names)} names')
+
+
+def gen_header(eds_file, entries):
+
+    names = [csv_name(name) for name, _ in entries]
+    if len(set(names)) != len(names):
+        sys.exit(f'{eds_file}: {PAYLOAD_NAME} entry names map to duplicate CSV names')
+    if len(names) > MAX_FIELDS:
+        sys.exit(f'{eds_file}: {PAYLOAD_NAME} has {len(names)} entries, the maximum is {MAX_FIELDS}')
+
+    seed, slots, table = find_perfect_hash(names)
+    name_max_len = max(len(n) for n in names)
+
+    out = []
+    out.append('/*')
+    out.append('** Purpose:')
+    out.append('**   Sense HAT CSV telemetry schema')
+    out.append('**')
+    out.append('** Notes:')
+    out.append(f'**   1. Generated by tools/gen_sense_hat_schema.py from the EDS {PAYLOAD_NAME}')
+    out.append('**      definition. Do not edit.')
+    out.append('**   2. Only included by sense_hat.c.')
+    out.append('**')
+    out.append('*/')
+    out.append('')
+    out.append('#ifndef _sense_hat_schema_')
+    out.append('#define _sense_hat_schema_')
+    out.append('')
+    out.append('#include <stddef.h>')
+    out.append('#include <string.h>')
+    out.append('#include "astro_pi_eds_typedefs.h"')
+    out.append('')
+    out.append(f'#define SENSE_HAT_SCHEMA_FIELD_CNT     {len(names)}')
+    out.append(f'#define SENSE_HAT_SCHEMA_NAME_MAX_LEN  {name_max_len}')
+    out.append(f'#define SENSE_HAT_SCHEMA_HASH_SLOTS    {slots}')
+    out.append(f'#define SENSE_HAT_SCHEMA_HASH_SEED     {seed}u')
+    out.append(f'#define SENSE_HAT_SCHEMA_ALL_FIELDS    0x{(1 << len(names)) - 1:08X}u')
+    out.append('')
+    out.append('typedef enum')
+    out.append('{')
+    for i, t in enumerate(SCHEMA_TYPES):
+        out.append(f'   {t}{"," if i < len(SCHEMA_TYPES)-1 else ""}')
+    out.append('} SENSE_HAT_SCHEMA_Type_t;')
+    out.append('')
+    out.append('typedef struct')
+    out.append('{')
+    out.append('   const char  *Name;')
+    out.append('   uint16      NameLen;')
+    out.append('   uint16      Offset;')
+    out.append('   SENSE_HAT_SCHEMA_Type_t  Type;')
+    out.append('} SENSE_HAT_SCHEMA_Field_t;')
+    out.append('')
+    out.append(f'static const SENSE_HAT_SCHEMA_Field_t SENSE_HAT_SCHEMA_Field[SENSE_HAT_SCHEMA_FIELD_CNT] =')
+    out.append('{')
+    for i, ((entry_name, base_type), name) in enumerate(zip(entries, names)):
+        sep = ',' if i < len(names)-1 else ''
+        out.append(f'   {{ "{name}", {len(name)}, offsetof({C_STRUCT}, {entry_name}), {BASE_TYPES[base_type]} }}{sep}')
+    out.append('};')
+    out.append('')
+    out.append('/* Field index+1 for each hash slot, 0 indicates an empty slot */')
+    out.append(f'static const uint8 SENSE_HAT_SCHEMA_HashTbl[SENSE_HAT_SCHEMA_HASH_SLOTS] =')
+    out.append('{')
+    row = [str(i+1) for i in table]
+    for i in range(0, slots, 16):
+        sep = ',' if i+16 < slots else ''
+        out.append('   ' + ', '.join(row[i:i+16]) + sep)
+    out.append('};')
+    out.append('')
+    out.append('/*')
+    out.append('** Return the field with the given name or NULL if the name is not in the')
+    out.append('** schema. Name does not need to be null terminated.')
+    out.append('*/')
+    out.append('static inline const SENSE_HAT_SCHEMA_Field_t *SENSE_HAT_SCHEMA_Lookup(const char *Name, size_t NameLen)')
+    out.append('{')
+    out.append('')
+    out.append('   uint32 Hash = 2166136261u ^ SENSE_HAT_SCHEMA_HASH_SEED;')
+    out.append('   uint8  FieldIdx;')
+    out.append('   const SENSE_HAT_SCHEMA_Field_t *Field;')
+    out.append('')
+    out.append('   if (NameLen > SENSE_HAT_SCHEMA_NAME_MAX_LEN)')
+    out.append('   {')
+    out.append('      return NULL;')
+    out.append('   }')
+    out.append('')
+    out.append('   for (size_t i=0; i < NameLen; i++)')
+    out.append('   {')
+    out.append('      Hash ^= (uint8)Name[i];')
+    out.append('      Hash *= 16777619u;')
+    out.append('   }')
+    out.append('')
+    out.append('   FieldIdx = SENSE_HAT_SCHEMA_HashTbl[(Hash ^ (Hash >> 16)) & (SENSE_HAT_SCHEMA_HASH_SLOTS-1)];')
+    out.append('   if (FieldIdx == 0)')
+    out.append('   {')
+    out.append('      return NULL;')
+    out.append('   }')
+    out.append('')
+    out.append('   Field = &SENSE_HAT_SCHEMA_Field[FieldIdx-1];')
+    out.append('')
+    out.append('   return (Field->NameLen == NameLen && memcmp(Field->Name, Name, NameLen) == 0) ? Field : NULL;')
+    out.append('')
+    out.append('}')
+    out.append('')
+    out.append('#endif /* _sense_hat_schema_ */')
+    out.append('')
+
+    return '\n'.join(out)
+
+
+def main(argv):
+
+    if len(argv) != 3:
+        sys.exit('Usage: gen_sense_hat_schema.py <astro_pi.xml> <sense_hat_schema.h>')
+
+    eds_file, hdr_file = argv[1], argv[2]
+    header = gen_header(eds_file, read_payload_entries(eds_file))
+
+    with open(hdr_file, 'w') as f:
+        f.write(header)
+
+
+if __name__ == '__main__':
+    main(sys.argv)